@@ -5,16 +5,16 @@ varying vec4 fragColor;
 
 uniform sampler2D texture0;
 uniform vec4 colDiffuse;
+uniform vec2 texelSize;
 
 void main () {
     vec4 my_color = texture2D(texture0, fragTexCoord);
-    float size = 128.0;
-    float scale = 0.2 / size;
+    vec2 scale = texelSize;
 
-    vec2 corner1 = fragTexCoord + vec2(scale);
-    vec2 corner2 = fragTexCoord + vec2(-scale);
-    vec2 corner3 = fragTexCoord + vec2(scale, -scale);
-    vec2 corner4 = fragTexCoord + vec2(-scale, scale);
+    vec2 corner1 = fragTexCoord + scale;
+    vec2 corner2 = fragTexCoord - scale;
+    vec2 corner3 = fragTexCoord + vec2(scale.x, -scale.y);
+    vec2 corner4 = fragTexCoord + vec2(-scale.x, scale.y);
 
     vec4 around = vec4(0.0);
     around.x = texture2D(texture0, corner1).a;
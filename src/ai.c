@@ -3,6 +3,7 @@
 #include "std.h"
 #include "constants.h"
 #include "level.h"
+#include "random.h"
 
 /* Initialization ************************************************************/
 void ai_init (usize player_id, GameState * state) {
@@ -27,16 +28,17 @@ void ai_init (usize player_id, GameState * state) {
     unsigned int max = -1;
     max /= 2;
     max -= 1;
-    player->ai->seed = GetRandomValue(0, (int)max);
+    Random * random = &state->random[RANDOM_AI];
+    player->ai->seed = random_range(random, 0, (int)max);
 
-    player->ai->aggressive = GetRandomValue(0, 1);
+    player->ai->aggressive = random_range(random, 0, 1);
 
-    player->ai->buildings.resources = GetRandomValue(1, 5) * 0.1f;
+    player->ai->buildings.resources = random_range(random, 1, 5) * 0.1f;
 
-    player->ai->buildings.fighter = GetRandomValue(30, 70);
-    player->ai->buildings.archer  = GetRandomValue(30, 70);
-    player->ai->buildings.support = GetRandomValue(10, 40);
-    player->ai->buildings.special = GetRandomValue(20, 50);
+    player->ai->buildings.fighter = random_range(random, 30, 70);
+    player->ai->buildings.archer  = random_range(random, 30, 70);
+    player->ai->buildings.support = random_range(random, 10, 40);
+    player->ai->buildings.special = random_range(random, 20, 50);
     float total = player->ai->buildings.fighter +
                   player->ai->buildings.archer +
                   player->ai->buildings.support +
@@ -112,9 +114,10 @@ void update_frontline_status (usize player_id, GameState * state) {
 }
 void update_random_bias (usize player_id, GameState * state) {
     AIData * ai = state->players.items[player_id].ai;
+    Random * random = &state->random[RANDOM_AI];
     for (usize i = 0; i < ai->regions.len; i++) {
-        ai->regions.items[i].random_focus_bonus = GetRandomValue(0, 1);
-        ai->regions.items[i].gather_troops = GetRandomValue(0, 9) == 0;
+        ai->regions.items[i].random_focus_bonus = random_range(random, 0, 1);
+        ai->regions.items[i].gather_troops = random_range(random, 0, 9) == 0;
     }
 }
 Test update_enemy_present (usize player_id, GameState * state) {
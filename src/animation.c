@@ -1,10 +1,11 @@
 #include "animation.h"
 #include "game.h"
 #include "math.h"
+#include "sprite.h"
+#include "std.h"
 #include <raymath.h>
 
-void render_debug_unit (const GameState * game, const Unit * unit) {
-    EndShaderMode();
+void render_debug_unit (const Unit * unit) {
     Color player = get_player_color(unit->player_owned);
     Color unit_type;
     switch (unit->type) {
@@ -26,8 +27,54 @@ void render_debug_unit (const GameState * game, const Unit * unit) {
         default: label = "N/A"; break;
     }
     DrawText(label, unit->position.x - 1, unit->position.y - 4, 6, BLACK);
+}
 
-    BeginShaderMode(game->resources->outline_shader);
+/* Frames ********************************************************************/
+float animation_duration (const AnimationSet * set, AnimationType type) {
+    switch (type) {
+        case ANIMATION_IDLE: return set->idle_duration;
+        case ANIMATION_WALK: return set->walk_duration;
+        case ANIMATION_ATTACK: return set->attack_duration;
+        case ANIMATION_CAST: return set->cast_duration;
+        default: return 0.0f;
+    }
+}
+uint8_t animation_start (const AnimationSet * set, AnimationType type) {
+    switch (type) {
+        case ANIMATION_IDLE: return set->idle_start;
+        case ANIMATION_WALK: return set->walk_start;
+        case ANIMATION_ATTACK: return set->attack_start;
+        case ANIMATION_CAST: return set->cast_start;
+        default: return 0;
+    }
+}
+void animation_build_lookup (AnimationSet * set) {
+    for (usize type = 0; type < ANIMATION_TYPE_COUNT; type++) {
+        float step = animation_duration(set, type) / ANIMATION_LOOKUP_SIZE;
+        uint8_t index = animation_start(set, type);
+        if (index >= set->frames.len) {
+            clear_memory(set->lookup[type], ANIMATION_LOOKUP_SIZE);
+            continue;
+        }
+        float frame_end = set->frames.items[index].duration;
+        for (usize i = 0; i < ANIMATION_LOOKUP_SIZE; i++) {
+            // middle of the step decides, the same frame a walk through durations would arrive at
+            float time = step * (i + 0.5f);
+            while (time > frame_end && index + 1u < set->frames.len) {
+                index ++;
+                frame_end += set->frames.items[index].duration;
+            }
+            set->lookup[type][i] = index;
+        }
+    }
+}
+uint8_t animation_frame (const AnimationSet * set, AnimationType type, float time) {
+    float duration = animation_duration(set, type);
+    if (duration <= 0.0f) return set->lookup[type][0];
+    if (time >= duration) time -= duration * (usize)(time / duration);
+    usize step = time / duration * ANIMATION_LOOKUP_SIZE;
+    if (step >= ANIMATION_LOOKUP_SIZE) step = ANIMATION_LOOKUP_SIZE - 1;
+    return set->lookup[type][step];
 }
 
 float unit_scale[FACTION_COUNT][UNIT_TYPE_COUNT][UNIT_LEVELS] = {
@@ -45,59 +92,52 @@ float unit_scale[FACTION_COUNT][UNIT_TYPE_COUNT][UNIT_LEVELS] = {
     }
 };
 
-void animate_unit (const GameState * game, const Unit * unit) {
+void animate_unit (const GameState * game, const Unit * unit, ListSpriteQuad * batch) {
     if (unit->type >= UNIT_TYPE_COUNT) {
         TraceLog(LOG_ERROR, "Tried to animate units that can't be animated");
         return;
     }
-    AnimationSet set = game->resources->animations.sets[unit->faction][unit->type][unit->upgrade];
-    if (set.sprite_sheet.format == 0) {
+    const AnimationSet * set = &game->resources->animations.sets[unit->faction][unit->type][unit->upgrade];
+    if (sprite_loaded(set->sprite_sheet) == NO) {
         // we lack sprite sheet, fallback to debug rendering for now
-        render_debug_unit(game, unit);
+        render_debug_unit(unit);
         return;
     }
 
-    float time_left = unit->state_time;
-    uint8_t index;
+    float time = unit->state_time;
+    AnimationType type;
     switch (unit->state) {
         case UNIT_STATE_IDLE: {
-            index = set.idle_start;
-            while (time_left > set.idle_duration) time_left -= set.idle_duration;
+            type = ANIMATION_IDLE;
         } break;
         case UNIT_STATE_CHASING:
         case UNIT_STATE_MOVING: {
-            index = set.walk_start;
-            while (time_left > set.walk_duration) time_left -= set.walk_duration;
+            type = ANIMATION_WALK;
         } break;
         case UNIT_STATE_FIGHTING: {
-            if (time_left >= set.attack_duration) {
-                index = set.idle_start;
-                time_left -= set.attack_duration;
-                while (time_left > set.idle_duration) time_left -= set.idle_duration;
+            if (time >= set->attack_duration) {
+                type = ANIMATION_IDLE;
+                time -= set->attack_duration;
             }
             else {
-                index = set.attack_start;
+                type = ANIMATION_ATTACK;
             }
         } break;
         case UNIT_STATE_SUPPORTING: {
-            if (time_left >= set.cast_duration) {
-                index = set.idle_start;
-                time_left -= set.cast_duration;
-                while (time_left > set.idle_duration) time_left -= set.idle_duration;
+            if (time >= set->cast_duration) {
+                type = ANIMATION_IDLE;
+                time -= set->cast_duration;
             }
             else {
-                index = set.cast_start;
+                type = ANIMATION_CAST;
             }
         } break;
         case UNIT_STATE_GUARDING:
+        default:
             TraceLog(LOG_ERROR, "Can't animate guardians");
             return;
     }
-    while (time_left > set.frames.items[index].duration) {
-        time_left -= set.frames.items[index].duration;
-        index++;
-    }
-    Rectangle source = set.frames.items[index].source;
+    Rectangle source = set->frames.items[animation_frame(set, type, time)].source;
 
     float scale = unit_scale[unit->faction][unit->type][unit->upgrade];
 
@@ -116,5 +156,5 @@ void animate_unit (const GameState * game, const Unit * unit) {
 
     Color outline = get_player_color(unit->player_owned);
 
-    DrawTexturePro(set.sprite_sheet, source, target, origin, 0, outline);
+    batch_sprite_part(batch, set->sprite_sheet, source, target, origin, 0, outline);
 }
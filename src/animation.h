@@ -3,6 +3,11 @@
 
 #include "types.h"
 
-void animate_unit (const GameState * game, const Unit * unit);
+/// Fills frame lookup of the set, called once its frames and tags are loaded
+void    animation_build_lookup (AnimationSet * set);
+/// Frame index of the animation at given time, time past the duration loops
+uint8_t animation_frame        (const AnimationSet * set, AnimationType type, float time);
+/// Queues the unit sprite, units without a sprite sheet are drawn right away
+void    animate_unit           (const GameState * game, const Unit * unit, ListSpriteQuad * batch);
 
 #endif // ANIMATION_H_
@@ -0,0 +1,220 @@
+#include "archive.h"
+#include "std.h"
+#include "alloc.h"
+#include "lz.h"
+#include <raylib.h>
+
+#if defined(ANDROID)
+#include <android/asset_manager.h>
+#include <android_native_app_glue.h>
+struct android_app * GetAndroidApp ();
+#elif defined(LINUX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    const uchar         * data;
+    usize                 size;
+    const ArchiveHeader * header;
+    const ArchiveEntry  * entries;
+    const uint32_t      * buckets;
+    #if defined(ANDROID)
+    AAsset              * asset;
+    #endif
+} Archive;
+
+Archive archive = {0};
+
+/* Utilities *****************************************************************/
+uint64_t archive_hash_path (const char * path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (; *path; path++) {
+        uchar c = *path == '\\' ? '/' : *path;
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+Test archive_path_equals (const char * archived, const char * path) {
+    for (; *archived && *path; archived++, path++) {
+        char c = *path == '\\' ? '/' : *path;
+        if (*archived != c) return NO;
+    }
+    return *archived == *path ? YES : NO;
+}
+Test archive_path_in_folder (const char * path, const char * folder) {
+    usize len = string_length(path);
+    usize end = len;
+    while (end > 0 && path[end - 1] != '/') end --;
+    if (end == 0) return NO;
+    end --;
+    usize start = end;
+    while (start > 0 && path[start - 1] != '/') start --;
+
+    usize folder_len = string_length(folder);
+    if (end - start != folder_len) return NO;
+    for (usize i = 0; i < folder_len; i++) {
+        if (path[start + i] != folder[i]) return NO;
+    }
+    return YES;
+}
+Result archive_validate () {
+    if (archive.size < sizeof(ArchiveHeader)) return FAILURE;
+    archive.header = (const ArchiveHeader *)archive.data;
+    if (archive.header->magic != ARCHIVE_MAGIC || archive.header->version != ARCHIVE_VERSION) {
+        TraceLog(LOG_ERROR, "Asset archive has unsupported version, it needs to be packed again");
+        return FAILURE;
+    }
+
+    const usize entry_count = archive.header->entry_count;
+    const usize bucket_count = archive.header->bucket_count;
+    if (bucket_count == 0 || (bucket_count & (bucket_count - 1)) || bucket_count < entry_count) return FAILURE;
+    usize index_end = sizeof(ArchiveHeader) + sizeof(ArchiveEntry) * entry_count + sizeof(uint32_t) * bucket_count;
+    if (index_end > archive.size) return FAILURE;
+
+    archive.entries = (const ArchiveEntry *)(archive.data + sizeof(ArchiveHeader));
+    archive.buckets = (const uint32_t *)(archive.entries + entry_count);
+
+    for (usize i = 0; i < entry_count; i++) {
+        const ArchiveEntry * entry = &archive.entries[i];
+        if (entry->path_offset + (usize)entry->path_length >= archive.size) return FAILURE;
+        if (archive.data[entry->path_offset + entry->path_length] != 0) return FAILURE;
+        // the byte past the blob is the zero terminator added by the packer
+        if (entry->data_offset + entry->data_size >= archive.size) return FAILURE;
+        if (entry->raw_size > INT32_MAX) return FAILURE;
+        switch (entry->codec) {
+            case ARCHIVE_CODEC_NONE: if (entry->raw_size != entry->data_size) return FAILURE; break;
+            case ARCHIVE_CODEC_LZ: break;
+            default: return FAILURE;
+        }
+    }
+    for (usize i = 0; i < bucket_count; i++) {
+        if (archive.buckets[i] > entry_count) return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/* Lifetime ******************************************************************/
+Result archive_open (const char * path) {
+    if (archive.data) archive_close();
+    TraceLog(LOG_INFO, "Opening asset archive %s", path);
+
+    #if defined(ANDROID)
+    AAssetManager * manager = GetAndroidApp()->activity->assetManager;
+    archive.asset = AAssetManager_open(manager, path, AASSET_MODE_BUFFER);
+    if (archive.asset == NULL) {
+        TraceLog(LOG_ERROR, "Failed to find asset archive %s in the package", path);
+        return FAILURE;
+    }
+    archive.data = AAsset_getBuffer(archive.asset);
+    archive.size = AAsset_getLength(archive.asset);
+    #elif defined(LINUX)
+    int file = open(path, O_RDONLY);
+    if (file < 0) {
+        TraceLog(LOG_ERROR, "Failed to open asset archive %s", path);
+        return FAILURE;
+    }
+    struct stat info;
+    if (fstat(file, &info) || info.st_size <= 0) {
+        close(file);
+        TraceLog(LOG_ERROR, "Failed to read size of asset archive %s", path);
+        return FAILURE;
+    }
+    void * data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        TraceLog(LOG_ERROR, "Failed to map asset archive %s", path);
+        return FAILURE;
+    }
+    archive.data = data;
+    archive.size = info.st_size;
+    #else
+    int len = 0;
+    archive.data = LoadFileData(path, &len);
+    archive.size = len > 0 ? len : 0;
+    #endif
+
+    if (archive.data == NULL || archive_validate()) {
+        TraceLog(LOG_ERROR, "Asset archive %s is damaged", path);
+        archive_close();
+        return FAILURE;
+    }
+    TraceLog(LOG_INFO, "Asset archive contains %u assets", archive.header->entry_count);
+    return SUCCESS;
+}
+void archive_close () {
+    #if defined(ANDROID)
+    if (archive.asset) AAsset_close(archive.asset);
+    #elif defined(LINUX)
+    if (archive.data) munmap((void *)archive.data, archive.size);
+    #else
+    if (archive.data) UnloadFileData((uchar *)archive.data);
+    #endif
+    clear_memory(&archive, sizeof(Archive));
+}
+
+/* Lookup ********************************************************************/
+const uchar * archive_find (const char * path, int * len) {
+    *len = 0;
+    if (archive.data == NULL) return NULL;
+
+    const uint64_t hash = archive_hash_path(path);
+    const usize mask = archive.header->bucket_count - 1;
+    for (usize probe = 0; probe <= mask; probe++) {
+        uint32_t slot = archive.buckets[(hash + probe) & mask];
+        if (slot == 0) break;
+
+        const ArchiveEntry * entry = &archive.entries[slot - 1];
+        if (entry->hash != hash) continue;
+        if (archive_path_equals((const char *)archive.data + entry->path_offset, path) == NO) continue;
+
+        const uchar * data = archive.data + entry->data_offset;
+        if (entry->codec == ARCHIVE_CODEC_NONE) {
+            *len = entry->data_size;
+            return data;
+        }
+
+        uchar * result = MemAlloc(entry->raw_size + 1);
+        if (result == NULL) {
+            TraceLog(LOG_ERROR, "Failed to allocate %zu bytes for asset %s", (usize)entry->raw_size, path);
+            return NULL;
+        }
+        if (lz_decompress(data, entry->data_size, result, entry->raw_size)) {
+            TraceLog(LOG_ERROR, "Asset %s is damaged in the archive", path);
+            MemFree(result);
+            return NULL;
+        }
+        result[entry->raw_size] = 0;
+        *len = entry->raw_size;
+        return result;
+    }
+    TraceLog(LOG_WARNING, "Asset %s isn't in the archive", path);
+    return NULL;
+}
+void archive_release (const uchar * data) {
+    if (data == NULL) return;
+    if (data >= archive.data && data < archive.data + archive.size) return;
+    MemFree((void *)data);
+}
+FilePathList archive_list (const char * folder, const char * extension) {
+    FilePathList result = {0};
+    if (archive.data == NULL || archive.header->entry_count == 0) return result;
+
+    result.paths = MemAlloc(sizeof(char *) * archive.header->entry_count);
+    if (result.paths == NULL) return result;
+    result.capacity = archive.header->entry_count;
+
+    for (usize i = 0; i < archive.header->entry_count; i++) {
+        const char * path = (const char *)archive.data + archive.entries[i].path_offset;
+        if (archive_path_in_folder(path, folder) == NO) continue;
+        if (extension && IsFileExtension(path, extension) == false) continue;
+        result.paths[result.count ++] = (char *)path;
+    }
+    return result;
+}
+void archive_list_unload (FilePathList list) {
+    if (list.paths) MemFree(list.paths);
+}
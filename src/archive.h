@@ -0,0 +1,53 @@
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include "types.h"
+
+#define ARCHIVE_MAGIC 0x4B504C4C
+#define ARCHIVE_VERSION 2
+#define ARCHIVE_ALIGNMENT 16
+#define ARCHIVE_FILE "line-lancer.pak"
+
+/// Archive layout, all offsets are counted from the start of the file:
+/// header, entries in packing order, hash buckets, zero terminated paths, aligned blobs
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t bucket_count;
+} ArchiveHeader;
+
+typedef enum {
+    ARCHIVE_CODEC_NONE = 0,
+    ARCHIVE_CODEC_LZ,
+} ArchiveCodec;
+
+typedef struct {
+    uint64_t hash;
+    uint32_t path_offset;
+    uint32_t path_length;
+    uint64_t data_offset;
+    /// size of the data as stored in the archive
+    uint64_t data_size;
+    /// size of the data after decompression
+    uint64_t raw_size;
+    uint32_t codec;
+    uint32_t reserved;
+} ArchiveEntry;
+
+/// Hash of a path within the archive, separators are treated the same on all platforms
+uint64_t archive_hash_path (const char * path);
+
+/// Maps the archive into memory, assets returned from it stay valid until the archive is closed
+Result        archive_open        (const char * path);
+void          archive_close       ();
+/// Returns asset data, data is zero terminated past its length
+/// Uncompressed assets point straight into the archive, compressed ones are decompressed into a new buffer
+const uchar * archive_find        (const char * path, int * len);
+/// Frees the buffer of a decompressed asset, does nothing for data pointing into the archive
+void          archive_release     (const uchar * data);
+/// Lists archived paths which are inside of a folder with given name, extension can be NULL
+FilePathList  archive_list        (const char * folder, const char * extension);
+void          archive_list_unload (FilePathList list);
+
+#endif // ARCHIVE_H_
@@ -11,8 +11,14 @@
 #include <sys/stat.h>
 #endif
 
+#if defined (ANDROID)
+#include <android_native_app_glue.h>
+struct android_app * GetAndroidApp ();
+#endif
+
 #if defined (EMBEDED_ASSETS)
-#include "packed_assets.h"
+#include "archive.h"
+#include "texture_file.h"
 #endif
 
 #include "mesh.h"
@@ -22,6 +28,9 @@
 #include "alloc.h"
 #include "ui.h"
 #include "animation.h"
+#include "map_file.h"
+#include "loader.h"
+#include "atlas.h"
 
 #define JSMN_PARENT_LINKS
 #include "../vendor/jsmn.h"
@@ -33,6 +42,7 @@ typedef struct {
 
 void unload_animations (Assets * assets);
 void unload_ui (UiAssets * assets);
+void unload_sprites (SpriteTextures * sprites);
 
 /* String Handling ***********************************************************/
 void log_slice(TraceLogLevel log_level, char * text, StringSlice slice) {
@@ -305,10 +315,78 @@ char * config_path (const char * file, Alloc alloc) {
     result[prefix_len + file_len] = 0;
     return result;
 }
+#if defined(LINUX)
+/* creates every missing directory along the path, ~/.cache isn't guaranteed to exist */
+static Result make_directories (char * path) {
+    for (char * at = path + 1; ; at++) {
+        if (*at != '/' && *at != 0) continue;
+        char end = *at;
+        *at = 0;
+        if (! DirectoryExists(path)) {
+            if (mkdir(path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
+                *at = end;
+                return FAILURE;
+            }
+        }
+        *at = end;
+        if (end == 0) break;
+    }
+    return SUCCESS;
+}
+#endif
+char * cache_path (const char * file, Alloc alloc) {
+    char * prefix;
+    usize prefix_len;
+    #if defined(WINDOWS)
+    prefix = "./";
+    #elif defined(ANDROID)
+    // absolute so plain file checks find it too, raylib file functions remap every path on android so use stdio with it
+    const char * internal = GetAndroidApp()->activity->internalDataPath;
+    usize internal_len = string_length(internal);
+    prefix = temp_alloc(internal_len + 2);
+    copy_memory(prefix, internal, internal_len);
+    prefix[internal_len] = '/';
+    prefix[internal_len + 1] = 0;
+    #elif defined(LINUX)
+    char * cache = getenv("XDG_CACHE_HOME");
+    if (NULL == cache) {
+        char * home = getenv("HOME");
+        if (NULL == home) TraceLog(LOG_FATAL, "Failed  to find home directory");
+        usize home_len = string_length(home);
+        char * rest = "/.cache/line-lancer/";
+        usize rest_len = string_length(rest);
+        prefix = temp_alloc(home_len + rest_len + 1);
+        copy_memory(prefix, home, home_len);
+        copy_memory(prefix + home_len, rest, rest_len);
+        prefix[home_len + rest_len] = 0;
+    }
+    else {
+        usize cache_len = string_length(cache);
+        char * rest = "/line-lancer/";
+        usize rest_len = string_length(rest);
+        prefix = temp_alloc(cache_len + rest_len + 1);
+        copy_memory(prefix, cache, cache_len);
+        copy_memory(prefix + cache_len, rest, rest_len);
+        prefix[cache_len + rest_len] = 0;
+    }
+    if (make_directories(prefix)) {
+        TraceLog(LOG_ERROR, "Failed to create cache directory");
+    }
+    #endif
+    prefix_len = string_length(prefix);
+
+    usize file_len = string_length(file);
+    char * result = alloc(file_len + prefix_len + 1);
+    copy_memory(result, prefix, prefix_len);
+    copy_memory(result + prefix_len, file, file_len);
+    result[prefix_len + file_len] = 0;
+    return result;
+}
 void assets_deinit (Assets * assets) {
     unload_animations(assets);
     for (usize i = 0; i < assets->maps.len; i++) {
         MemFree(assets->maps.items[i].name);
+        MemFree(assets->maps.items[i].path);
         map_deinit(&assets->maps.items[i]);
     }
     listMapDeinit(&assets->maps);
@@ -322,31 +400,46 @@ void assets_deinit (Assets * assets) {
         UnloadSound(assets->sound_effects.items[i].sound);
     }
     listSFXDeinit(&assets->sound_effects);
-    UnloadTexture(assets->empty_building);
+    unload_sprites(&assets->sprites);
     UnloadTexture(assets->ground_texture);
     UnloadTexture(assets->water_texture);
     UnloadTexture(assets->bridge_texture);
     unload_ui(&assets->ui);
     UnloadShader(assets->water_shader);
     UnloadShader(assets->outline_shader);
+    #if defined(EMBEDED_ASSETS)
+    archive_close();
+    #endif
+}
+Result load_asset_archive () {
+    #if defined(EMBEDED_ASSETS)
+    #if defined(ANDROID)
+    // apk assets are opened relative to the assets folder of the package
+    return archive_open(ARCHIVE_FILE);
+    #else
+    return archive_open("assets" PATH_SEPARATOR_STR ARCHIVE_FILE);
+    #endif
+    #else
+    return SUCCESS;
+    #endif
 }
 const unsigned char * load_asset (const char * path, int * len) {
   #if defined(EMBEDED_ASSETS)
-  return load_data_from_path(path, len);
+  return archive_find(path, len);
   #else
   return LoadFileData(path, len);
   #endif
 }
 void unload_asset (const unsigned char * data) {
   #if defined(EMBEDED_ASSETS)
-  (void)data;
+  archive_release(data);
   #else
   UnloadFileData((unsigned char *)data);
   #endif
 }
 FilePathList load_map_paths () {
     #if defined(EMBEDED_ASSETS)
-    return load_map_path_list();
+    return archive_list("maps", NULL);
     #else
     const char * path = asset_path("maps", "", &temp_alloc);
     return LoadDirectoryFiles(path);
@@ -354,50 +447,68 @@ FilePathList load_map_paths () {
 }
 FilePathList load_unit_meta_paths () {
     #if defined(EMBEDED_ASSETS)
-    return load_unit_meta_file_paths();
+    return archive_list("units", ".json");
     #else
     const char * path = asset_path("units", "", &temp_alloc);
     return LoadDirectoryFilesEx(path, ".json", false);
     #endif
 }
-Texture load_texture (const char * path) {
+Image load_image (const char * path, const unsigned char ** data) {
+  *data = NULL;
   #if defined(EMBEDED_ASSETS)
   int len = 0;
-  const unsigned char * data = load_asset(path, &len);
-  if (NULL == data) return (Texture) {0};
-  Image i = LoadImageFromMemory(GetFileExtension(path), data, len);
-  Texture t = LoadTextureFromImage(i);
-  UnloadImage(i);
-  return t;
+  const unsigned char * file = load_asset(path, &len);
+  if (NULL == file) return (Image) {0};
+
+  Image i = {0};
+  if (texture_file_is_raw(file, len)) {
+    // pixels are used straight from the asset, it stays loaded until the image is unloaded
+    if (texture_file_read(&i, file, len)) {
+      TraceLog(LOG_ERROR, "Failed to read texture %s", path);
+      unload_asset(file);
+      return (Image) {0};
+    }
+    *data = file;
+    return i;
+  }
+
+  i = LoadImageFromMemory(GetFileExtension(path), file, len);
+  unload_asset(file);
+  return i;
   #else
-  return LoadTexture(path);
+  return LoadImage(path);
   #endif
 }
+void unload_image (Image image, const unsigned char * data) {
+  if (data) unload_asset(data);
+  else UnloadImage(image);
+}
 Shader load_shader (const char * fs_path) {
   #if defined(EMBEDED_ASSETS)
   int len = 0;
-  const char * data = (const char *) load_asset(fs_path, &len);
-  return LoadShaderFromMemory(0, data);
+  const unsigned char * data = load_asset(fs_path, &len);
+  Shader s = LoadShaderFromMemory(0, (const char *)data);
+  unload_asset(data);
+  return s;
   #else
   return LoadShader(0, fs_path);
   #endif
 }
-Sound load_sound (const char * path) {
+Wave load_wave (const char * path) {
     #if defined(EMBEDED_ASSETS)
     int len = 0;
     const unsigned char * data = load_asset(path, &len);
-    if (NULL == data) return (Sound) {0};
+    if (NULL == data) return (Wave) {0};
     Wave w = LoadWaveFromMemory(GetFileExtension(path), data, len);
-    Sound s = LoadSoundFromWave(w);
-    UnloadWave(w);
-    return s;
+    unload_asset(data);
+    return w;
     #else
-    return LoadSound(path);
+    return LoadWave(path);
     #endif
 }
 void unload_file_paths (FilePathList list) {
     #if defined(EMBEDED_ASSETS)
-    (void)list;
+    archive_list_unload(list);
     #else
     UnloadDirectoryFiles(list);
     #endif
@@ -967,6 +1078,21 @@ Result load_level(Map * result, char * path) {
     TraceLog(LOG_ERROR, "Failed to open map file %s", path);
     return FAILURE;
   }
+  result->hash = hash_memory(data, len);
+
+  if (map_file_is_compiled(data, len)) {
+    if (map_file_read(result, data, len)) {
+      TraceLog(LOG_ERROR, "Failed to read compiled map %s", path);
+      unload_asset(data);
+      if (result->name) MemFree(result->name);
+      map_deinit(result);
+      return FAILURE;
+    }
+    unload_asset(data);
+    return SUCCESS;
+  }
+  // json maps are only expected during development, release builds ship maps compiled
+  TraceLog(LOG_INFO, "Map %s isn't compiled, parsing json", path);
 
   jsmn_parser json_parser;
   jsmn_init(&json_parser);
@@ -1107,6 +1233,85 @@ fail:
   map_deinit(result);
   return FAILURE;
 }
+Result load_level_info (Map * result, char * path) {
+  int len;
+  const uchar * data = load_asset(path, &len);
+  if (len <= 0) {
+    TraceLog(LOG_ERROR, "Failed to open map file %s", path);
+    return FAILURE;
+  }
+
+  if (map_file_is_compiled(data, len)) {
+    usize cursor = 0;
+    Result info = map_file_read_info(result, data, len, &cursor);
+    unload_asset(data);
+    if (info) {
+      if (result->name) MemFree(result->name);
+      clear_memory(result, sizeof(Map));
+      return FAILURE;
+    }
+  }
+  else {
+    // json can't be read partially, the geometry is parsed and then dropped until the map is picked
+    unload_asset(data);
+    if (load_level(result, path)) {
+      return FAILURE;
+    }
+    unload_level(result);
+  }
+
+  usize path_len = string_length(path);
+  result->path = MemAlloc(path_len + 1);
+  copy_memory(result->path, path, path_len + 1);
+  return SUCCESS;
+}
+void unload_level (Map * map) {
+  Map info = *map;
+  map_deinit(map);
+  map->name = info.name;
+  map->path = info.path;
+  map->width = info.width;
+  map->height = info.height;
+  map->player_count = info.player_count;
+}
+Result load_level_geometry (ListMap * maps, Map * map) {
+  static usize use_counter = 0;
+  if (map->loaded) {
+    map->last_used = ++use_counter;
+    return SUCCESS;
+  }
+
+  usize loaded_count = 0;
+  for (usize i = 0; i < maps->len; i++) {
+    if (maps->items[i].loaded) loaded_count ++;
+  }
+  while (loaded_count >= MAPS_LOADED_MAX) {
+    Map * oldest = NULL;
+    for (usize i = 0; i < maps->len; i++) {
+      Map * test = &maps->items[i];
+      if (test->loaded && (oldest == NULL || test->last_used < oldest->last_used)) {
+        oldest = test;
+      }
+    }
+    TraceLog(LOG_INFO, "Unloading map %s", oldest->name);
+    unload_level(oldest);
+    loaded_count --;
+  }
+
+  Map loaded = {0};
+  if (load_level(&loaded, map->path)) {
+    if (loaded.name) MemFree(loaded.name);
+    return FAILURE;
+  }
+  // listed metadata is kept, only the geometry is taken from the full load
+  MemFree(loaded.name);
+  map->hash = loaded.hash;
+  map->regions = loaded.regions;
+  map->paths = loaded.paths;
+  map->loaded = true;
+  map->last_used = ++use_counter;
+  return SUCCESS;
+}
 Result load_levels (ListMap * maps) {
     FilePathList list = load_map_paths();
 
@@ -1115,30 +1320,11 @@ Result load_levels (ListMap * maps) {
         goto abort;
     }
 
-    usize i = 0;
-
-    while (i < list.count) {
-        // Load the map
-        if(listMapAppend(maps, (Map){0})) {
-            TraceLog(LOG_ERROR, "Failed to allocate space for map: #%zu: %s", i, list.paths[i]);
+    for (usize i = 0; i < list.count; i++) {
+        if (load_map_async(list.paths[i], maps, LOAD_STAGE_STARTUP)) {
+            TraceLog(LOG_ERROR, "Failed to queue map #%zu: %s", i, list.paths[i]);
             goto abort;
         }
-        if (load_level(&maps->items[i], list.paths[i])) {
-            TraceLog(LOG_ERROR, "Failed to load map %s", list.paths[i]);
-            maps->len -= 1;
-            temp_reset();
-            i++;
-            continue;
-        }
-        TraceLog(LOG_INFO, "Loaded map file: %s", list.paths[i]);
-
-        temp_reset();
-        i ++;
-    }
-
-    if (maps->len == 0) {
-        TraceLog(LOG_FATAL, "Failed to load any map successfully");
-        goto abort;
     }
 
     unload_file_paths(list);
@@ -1149,8 +1335,98 @@ Result load_levels (ListMap * maps) {
     return FAILURE;
 }
 
+/* Sprites *******************************************************************/
+Result load_sprite_atlas (SpriteTextures * sprites) {
+    for (usize i = 0; i < ATLAS_PAGES_MAX; i++) {
+        sprites->pages[i] = SPRITE_TEXTURES_MAX;
+    }
+    #if defined(EMBEDED_ASSETS)
+    char * path = asset_path(ATLAS_FOLDER, ATLAS_INDEX_FILE, &temp_alloc);
+    if (NULL == path) {
+        TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for sprite atlas");
+        return FAILURE;
+    }
+    sprites->atlas = load_asset(path, &sprites->atlas_len);
+    if (NULL == sprites->atlas) {
+        TraceLog(LOG_WARNING, "Assets were packed without atlases, sprites are loaded one by one");
+        return SUCCESS;
+    }
+    usize page_count;
+    if (atlas_file_page_count(sprites->atlas, sprites->atlas_len, &page_count) || page_count > ATLAS_PAGES_MAX) {
+        TraceLog(LOG_ERROR, "Sprite atlas index can't be used");
+        unload_asset(sprites->atlas);
+        sprites->atlas = NULL;
+        return FAILURE;
+    }
+    #endif
+    return SUCCESS;
+}
+Result load_sprite (SpriteTextures * sprites, const char * path, Sprite * result, LoadStage stage, Test required) {
+    #if defined(EMBEDED_ASSETS)
+    AtlasRegion region;
+    if (sprites->atlas && atlas_file_find(sprites->atlas, sprites->atlas_len, path, &region)) {
+        usize * slot = &sprites->pages[region.page];
+        if (*slot == SPRITE_TEXTURES_MAX) {
+            if (sprites->texture_count >= SPRITE_TEXTURES_MAX) {
+                TraceLog(LOG_ERROR, "Too many sprite textures to load atlas page for %s", path);
+                return FAILURE;
+            }
+            *slot = sprites->texture_count ++;
+            sprites->page_stage[region.page] = stage;
+            sprites->page_required[region.page] = required;
+        }
+        // page is needed as soon as any of its sprites is
+        if ((int)stage < sprites->page_stage[region.page]) sprites->page_stage[region.page] = stage;
+        if (required) sprites->page_required[region.page] = YES;
+
+        result->texture = &sprites->textures[*slot];
+        result->source = region.source;
+        return SUCCESS;
+    }
+    #endif
+    if (sprites->texture_count >= SPRITE_TEXTURES_MAX) {
+        TraceLog(LOG_ERROR, "Too many sprite textures to load %s", path);
+        return FAILURE;
+    }
+    Texture2D * texture = &sprites->textures[sprites->texture_count ++];
+    result->texture = texture;
+    result->source = (Rectangle){0};
+    return load_texture_async(path, texture, stage, required);
+}
+Result load_sprite_atlas_pages (Assets * assets) {
+    SpriteTextures * sprites = &assets->sprites;
+    char name[32];
+    for (usize i = 0; i < ATLAS_PAGES_MAX; i++) {
+        if (sprites->pages[i] == SPRITE_TEXTURES_MAX) continue;
+        snprintf(name, 32, ATLAS_PAGE_FILE, i);
+        char * path = asset_path(ATLAS_FOLDER, name, &temp_alloc);
+        if (NULL == path) {
+            TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for atlas page");
+            return FAILURE;
+        }
+        Texture2D * page = &sprites->textures[sprites->pages[i]];
+        if (load_texture_async(path, page, sprites->page_stage[i], sprites->page_required[i])) {
+            TraceLog(LOG_ERROR, "Failed to queue atlas page %s", path);
+            return FAILURE;
+        }
+        temp_free(path);
+    }
+    // regions were all resolved while queueing sprites
+    if (sprites->atlas) unload_asset(sprites->atlas);
+    sprites->atlas = NULL;
+    sprites->atlas_len = 0;
+    return SUCCESS;
+}
+void unload_sprites (SpriteTextures * sprites) {
+    for (usize i = 0; i < sprites->texture_count; i++) {
+        UnloadTexture(sprites->textures[i]);
+    }
+    if (sprites->atlas) unload_asset(sprites->atlas);
+    clear_memory(sprites, sizeof(SpriteTextures));
+}
+
 /* Graphics ******************************************************************/
-Result load_particles (Texture2D * array) {
+Result load_particles (SpriteTextures * sprites, Sprite * array) {
     const char * paths[PARTICLE_LAST + 1] = {
         "arrow.png",
         "fireball.png",
@@ -1169,8 +1445,7 @@ Result load_particles (Texture2D * array) {
             TraceLog(LOG_ERROR, "Temp allocator ran out of memory for joining paths");
             return FAILURE;
         }
-        array[i] = load_texture(path);
-        if (0 == array[i].format) {
+        if (load_sprite(sprites, path, &array[i], LOAD_STAGE_STARTUP, YES)) {
             TraceLog(LOG_ERROR, "Failed to load particle %s", path);
             return FAILURE;
         }
@@ -1196,8 +1471,7 @@ Result load_buildings (Assets * assets) {
             TraceLog(LOG_ERROR, "Temp allocator ran out of memory for joining paths");
             return FAILURE;
         }
-        assets->neutral_castle = load_texture(path);
-        if (0 == assets->neutral_castle.format) {
+        if (load_sprite(&assets->sprites, path, &assets->neutral_castle, LOAD_STAGE_STARTUP, YES)) {
             TraceLog(LOG_ERROR, "Failed to load neutral castle texture");
             return FAILURE;
         }
@@ -1212,13 +1486,12 @@ Result load_buildings (Assets * assets) {
             TraceLog(LOG_ERROR, "Failed to allocate path for %s", name);
             return FAILURE;
         }
-        assets->buildings[fac].castle = load_texture(path);
-        if (0 == assets->buildings[fac].castle.format) {
+        if (load_sprite(&assets->sprites, path, &assets->buildings[fac].castle, LOAD_STAGE_STARTUP, YES)) {
             TraceLog(LOG_ERROR, "Failed to load %s", path);
             return FAILURE;
         }
         usize build_count = 5;
-        Texture2D * buildable = &assets->buildings[fac].fighter[0];
+        Sprite * buildable = &assets->buildings[fac].fighter[0];
         while (build_count --> 0) {
             usize level_count = BUILDING_MAX_LEVEL;
             while (level_count --> 0) {
@@ -1229,8 +1502,7 @@ Result load_buildings (Assets * assets) {
                     TraceLog(LOG_ERROR, "Failed to allocate path for %s", name);
                     return FAILURE;
                 }
-                buildable[index] = load_texture(path);
-                if (0 == buildable[index].format) {
+                if (load_sprite(&assets->sprites, path, &buildable[index], LOAD_STAGE_STARTUP, YES)) {
                     TraceLog(LOG_ERROR, "Failed to load texture: %s", path);
                     return FAILURE;
                 }
@@ -1243,8 +1515,7 @@ Result load_buildings (Assets * assets) {
         TraceLog(LOG_ERROR, "Failed to allocate memory for flag path");
         return FAILURE;
     }
-    assets->flag = load_texture(path);
-    if (0 == assets->flag.format) {
+    if (load_sprite(&assets->sprites, path, &assets->flag, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load flag texture");
         return FAILURE;
     }
@@ -1256,8 +1527,7 @@ Result load_backgrounds (Assets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for backgrounds");
         return FAILURE;
     }
-    assets->ground_texture = load_texture(path);
-    if (0 == assets->ground_texture.format) {
+    if (load_texture_async(path, &assets->ground_texture, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load background");
         return FAILURE;
     }
@@ -1266,8 +1536,7 @@ Result load_backgrounds (Assets * assets) {
         TraceLog(LOG_ERROR, "Failed to allocate path for bridge");
         return FAILURE;
     }
-    assets->bridge_texture = load_texture(path);
-    if (0 == assets->bridge_texture.format) {
+    if (load_texture_async(path, &assets->bridge_texture, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load bridge texture");
         return FAILURE;
     }
@@ -1276,8 +1545,7 @@ Result load_backgrounds (Assets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for building ground");
         return FAILURE;
     }
-    assets->empty_building = load_texture(path);
-    if (0 == assets->empty_building.format) {
+    if (load_sprite(&assets->sprites, path, &assets->empty_building, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load empty building texture");
         return FAILURE;
     }
@@ -1286,8 +1554,7 @@ Result load_backgrounds (Assets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for water");
         return FAILURE;
     }
-    assets->water_texture = load_texture(path);
-    if (0 == assets->water_texture.format) {
+    if (load_texture_async(path, &assets->water_texture, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load water");
         return FAILURE;
     }
@@ -1301,6 +1568,7 @@ Result load_backgrounds (Assets * assets) {
         TraceLog(LOG_ERROR, "Failed to load water shader");
         return FAILURE;
     }
+    assets->water_time_location = GetShaderLocation(assets->water_shader, "time");
     path = asset_path("shaders", "outline.fs", &temp_alloc);
     if (NULL == path) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for outline shader");
@@ -1311,6 +1579,7 @@ Result load_backgrounds (Assets * assets) {
         TraceLog(LOG_ERROR, "Failed to load outline shader");
         return FAILURE;
     }
+    assets->outline_texel_location = GetShaderLocation(assets->outline_shader, "texelSize");
     return SUCCESS;
 }
 Result load_ui (UiAssets * assets) {
@@ -1319,8 +1588,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for ui");
         return FAILURE;
     }
-    assets->background_box = load_texture(path);
-    if (0 == assets->background_box.format) {
+    if (load_texture_async(path, &assets->background_box, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui background box");
         return FAILURE;
     }
@@ -1338,8 +1606,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for button");
         return FAILURE;
     }
-    assets->button = load_texture(path);
-    if (0 == assets->button.format) {
+    if (load_texture_async(path, &assets->button, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui button texture");
         return FAILURE;
     }
@@ -1348,8 +1615,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Failed to allocate path for button close");
         return FAILURE;
     }
-    assets->button_press = load_texture(path);
-    if (0 == assets->button_press.format) {
+    if (load_texture_async(path, &assets->button_press, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load button press texture");
         return FAILURE;
     }
@@ -1366,8 +1632,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for close button");
         return FAILURE;
     }
-    assets->close = load_texture(path);
-    if (0 == assets->close.format) {
+    if (load_texture_async(path, &assets->close, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui close button texture");
         return FAILURE;
     }
@@ -1376,8 +1641,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for close button click");
         return FAILURE;
     }
-    assets->close_press = load_texture(path);
-    if (0 == assets->close_press.format) {
+    if (load_texture_async(path, &assets->close_press, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui close button click texture");
         return FAILURE;
     }
@@ -1386,8 +1650,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for slider");
         return FAILURE;
     }
-    assets->slider = load_texture(path);
-    if (0 == assets->slider.format) {
+    if (load_texture_async(path, &assets->slider, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui slider texture");
         return FAILURE;
     }
@@ -1396,8 +1659,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for slider thumb");
         return FAILURE;
     }
-    assets->slider_thumb = load_texture(path);
-    if (0 == assets->slider_thumb.format) {
+    if (load_texture_async(path, &assets->slider_thumb, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui slider thumb texture");
         return FAILURE;
     }
@@ -1412,8 +1674,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for drop down");
         return FAILURE;
     }
-    assets->drop = load_texture(path);
-    if (0 == assets->drop.format) {
+    if (load_texture_async(path, &assets->drop, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui dropdown texture");
         return FAILURE;
     }
@@ -1422,8 +1683,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for drop down");
         return FAILURE;
     }
-    assets->title = load_texture(path);
-    if (0 == assets->title.format) {
+    if (load_texture_async(path, &assets->title, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui dropdown texture");
         return FAILURE;
     }
@@ -1434,8 +1694,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for joystick");
         return FAILURE;
     }
-    assets->joystick = load_texture(path);
-    if (0 == assets->joystick.format) {
+    if (load_texture_async(path, &assets->joystick, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui joystick texture");
         return FAILURE;
     }
@@ -1444,8 +1703,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for zoom in");
         return FAILURE;
     }
-    assets->zoom_in = load_texture(path);
-    if (0 == assets->zoom_in.format) {
+    if (load_texture_async(path, &assets->zoom_in, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui zoom in texture");
         return FAILURE;
     }
@@ -1454,8 +1712,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for zoom out");
         return FAILURE;
     }
-    assets->zoom_out = load_texture(path);
-    if (0 == assets->zoom_out.format) {
+    if (load_texture_async(path, &assets->zoom_out, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui zoom out texture");
         return FAILURE;
     }
@@ -1464,8 +1721,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Temp allocator failed to allocate path for aim target");
         return FAILURE;
     }
-    assets->crosshair = load_texture(path);
-    if (0 == assets->crosshair.format) {
+    if (load_texture_async(path, &assets->crosshair, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load ui aim target texture");
         return FAILURE;
     }
@@ -1476,8 +1732,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for itch brand");
         return FAILURE;
     }
-    assets->media_itch = load_texture(path);
-    if (0 == assets->media_itch.format) {
+    if (load_texture_async(path, &assets->media_itch, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for itch");
         return FAILURE;
     }
@@ -1486,8 +1741,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for github brand");
         return FAILURE;
     }
-    assets->media_github = load_texture(path);
-    if (0 == assets->media_github.format) {
+    if (load_texture_async(path, &assets->media_github, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for github");
         return FAILURE;
     }
@@ -1496,8 +1750,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for coffee brand");
         return FAILURE;
     }
-    assets->media_coffee = load_texture(path);
-    if (0 == assets->media_coffee.format) {
+    if (load_texture_async(path, &assets->media_coffee, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for coffee");
         return FAILURE;
     }
@@ -1506,8 +1759,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for youtube brand");
         return FAILURE;
     }
-    assets->media_youtube = load_texture(path);
-    if (0 == assets->media_youtube.format) {
+    if (load_texture_async(path, &assets->media_youtube, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for youtube");
         return FAILURE;
     }
@@ -1516,8 +1768,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for twitch brand");
         return FAILURE;
     }
-    assets->media_twitch = load_texture(path);
-    if (0 == assets->media_twitch.format) {
+    if (load_texture_async(path, &assets->media_twitch, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for twitch");
         return FAILURE;
     }
@@ -1526,8 +1777,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for x brand");
         return FAILURE;
     }
-    assets->media_x = load_texture(path);
-    if (0 == assets->media_x.format) {
+    if (load_texture_async(path, &assets->media_x, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for x");
         return FAILURE;
     }
@@ -1536,8 +1786,7 @@ Result load_ui (UiAssets * assets) {
         TraceLog(LOG_ERROR, "Tempt allocator failed to allocate path for discord brand");
         return FAILURE;
     }
-    assets->media_discord = load_texture(path);
-    if (0 == assets->media_discord.format) {
+    if (load_texture_async(path, &assets->media_discord, LOAD_STAGE_STARTUP, YES)) {
         TraceLog(LOG_ERROR, "Failed to load brand logo for discord");
         return FAILURE;
     }
@@ -1569,7 +1818,9 @@ void unload_ui (UiAssets * assets) {
     UnloadTexture(assets->media_discord);
 }
 Result load_graphics (Assets * assets) {
-    Result result = load_particles(assets->particles);
+    Result result = load_sprite_atlas(&assets->sprites);
+    if (result != SUCCESS) return result;
+    result = load_particles(&assets->sprites, assets->particles);
     if (result != SUCCESS) return result;
     result = load_buildings(assets);
     if (result != SUCCESS) return result;
@@ -1675,9 +1926,9 @@ Result load_animations (Assets * assets) {
         copy_memory(texture_path, data.paths[i], path_len - 4);
         copy_memory(texture_path + path_len - 4, "png", 3);
         texture_path[path_len - 1] = 0;
-        animations->sprite_sheet = load_texture(texture_path);
-        if (animations->sprite_sheet.format == 0) {
-            TraceLog(LOG_ERROR, "Missing sprite sheet at %s", texture_path);
+        // sprite sheets keep loading once the menu is up, animations skip sets without one
+        if (load_sprite(&assets->sprites, texture_path, &animations->sprite_sheet, LOAD_STAGE_BACKGROUND, NO)) {
+            TraceLog(LOG_ERROR, "Failed to queue sprite sheet at %s", texture_path);
             goto next_file;
         }
 
@@ -1881,6 +2132,7 @@ Result load_animations (Assets * assets) {
                 }
             } // loading tags
         }
+        animation_build_lookup(animations);
 
         next_file:
         unload_asset(text);
@@ -1891,7 +2143,6 @@ Result load_animations (Assets * assets) {
 }
 void unload_animation_set (AnimationSet * set) {
     listFrameDeinit(&set->frames);
-    UnloadTexture(set->sprite_sheet);
 }
 void unload_animations (Assets * assets) {
     for (usize f = 0; f <= FACTION_LAST; f++) {
@@ -1919,16 +2170,9 @@ Result load_music (Assets * assets) {
             return FAILURE;
         }
 
-        #if defined(EMBEDED_ASSETS)
-        int len = 0;
-        const unsigned char * data = load_asset(path, &len);
-        assets->faction_themes[i] = LoadMusicStreamFromMemory(".xm", data, len);
-        #else
-        assets->faction_themes[i] = LoadMusicStream(path);
-        #endif
-
-        if (assets->faction_themes[i].frameCount == 0) {
-            TraceLog(LOG_ERROR, "Failed to load music from %s", path);
+        // faction themes are needed only once the game starts
+        if (load_music_async(path, &assets->faction_themes[i], LOAD_STAGE_BACKGROUND, YES)) {
+            TraceLog(LOG_ERROR, "Failed to queue music from %s", path);
             return FAILURE;
         }
         temp_free(path);
@@ -1941,21 +2185,13 @@ Result load_music (Assets * assets) {
         return FAILURE;
     }
 
-    #if defined(EMBEDED_ASSETS)
-    int len = 0;
-    const unsigned char * data = load_asset(path, &len);
-    assets->main_theme = LoadMusicStreamFromMemory(".xm", data, len);
-    #else
-    assets->main_theme = LoadMusicStream(path);
-    #endif
-
-    if (assets->main_theme.frameCount == 0) {
-        TraceLog(LOG_ERROR, "Failed to load main theme");
+    if (load_music_async(path, &assets->main_theme, LOAD_STAGE_STARTUP, YES)) {
+        TraceLog(LOG_ERROR, "Failed to queue main theme");
         return FAILURE;
     }
     temp_free(path);
 
-    TraceLog(LOG_INFO, "Music loaded");
+    TraceLog(LOG_INFO, "Music queued");
     return SUCCESS;
 }
 typedef struct {
@@ -2005,16 +2241,8 @@ Result load_sound_effects (Assets * assets) {
     usize i = 0;
     while (loader[i].name != NULL) {
         char * path = asset_path("sfx", loader[i].name, &temp_alloc);
-        Sound s = load_sound(path);
-        if (s.frameCount == 0) {
-            TraceLog(LOG_ERROR, "Failed to load sound");
-            i ++;
-            continue;
-        }
-        SoundEffect se = { loader[i].kind, s };
-        if (listSFXAppend(&assets->sound_effects, se)) {
-            TraceLog(LOG_ERROR, "Failed to add sound effect %s", loader[i].name);
-            UnloadSound(s);
+        if (load_sound_async(path, &assets->sound_effects, loader[i].kind, LOAD_STAGE_STARTUP)) {
+            TraceLog(LOG_ERROR, "Failed to queue sound effect %s", loader[i].name);
         }
         i++;
     }
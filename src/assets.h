@@ -5,15 +5,31 @@
 #include "level.h"
 
 /* Loading *******************************************************************/
-Result load_levels   (ListMap * maps);
+Result load_asset_archive  ();
+Result load_level          (Map * result, char * path);
+Result load_level_info     (Map * result, char * path);
+Result load_level_geometry (ListMap * maps, Map * map);
+void   unload_level        (Map * map);
+Result load_levels         (ListMap * maps);
+
 Result load_graphics (Assets * assets);
 Result load_settings (Settings * settings);
 Result save_settings (const Settings * settings);
 Result load_animations (Assets * assets);
+/// Queues atlas pages needed by sprites, called once all sprites are requested
+Result load_sprite_atlas_pages (Assets * assets);
 
 /* Asset Management **********************************************************/
 void   assets_deinit (Assets * assets);
+/// File data of an asset, from the archive with embedded assets or from disk otherwise
+const unsigned char * load_asset   (const char * path, int * len);
+void                  unload_asset (const unsigned char * data);
+/// Decodes an image without touching the gpu, data is set when pixels live inside of the asset data
+Image                 load_image   (const char * path, const unsigned char ** data);
+void                  unload_image (Image image, const unsigned char * data);
+Wave                  load_wave    (const char * path);
 char * file_name_from_path (char * path, Alloc alloc);
+char * cache_path          (const char * file, Alloc alloc);
 
 /* Audio *********************************************************************/
 Result load_music (Assets * assets);
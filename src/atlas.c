@@ -0,0 +1,102 @@
+#include "atlas.h"
+#include "std.h"
+
+#define ATLAS_FILE_MAGIC 0x534C5441
+#define ATLAS_FILE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t page_count;
+    uint32_t region_count;
+} AtlasFileHeader;
+
+// paths are stored after the regions, offsets are counted from the start of the file
+typedef struct {
+    uint32_t path_offset;
+    uint32_t path_length;
+    uint32_t page;
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} AtlasFileRegion;
+
+/* Reading *******************************************************************/
+Result atlas_file_header (const uchar * data, usize len, AtlasFileHeader * header) {
+    usize cursor = 0;
+    if (read_bytes(data, len, &cursor, header, sizeof(AtlasFileHeader))) return FAILURE;
+    if (header->magic != ATLAS_FILE_MAGIC || header->version != ATLAS_FILE_VERSION) {
+        TraceLog(LOG_ERROR, "Atlas has unsupported version %u, pack assets again", header->version);
+        return FAILURE;
+    }
+    if (header->region_count > (len - cursor) / sizeof(AtlasFileRegion)) {
+        TraceLog(LOG_ERROR, "Atlas index is damaged");
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+Test atlas_path_equals (const uchar * data, usize len, const AtlasFileRegion * region, const char * path) {
+    if ((usize)region->path_offset + region->path_length > len) return NO;
+    const char * packed = (const char *)data + region->path_offset;
+    usize i = 0;
+    for (; i < region->path_length && path[i]; i++) {
+        char c = path[i] == '\\' ? '/' : path[i];
+        if (packed[i] != c) return NO;
+    }
+    return i == region->path_length && path[i] == 0 ? YES : NO;
+}
+Result atlas_file_page_count (const uchar * data, usize len, usize * result) {
+    AtlasFileHeader header;
+    if (atlas_file_header(data, len, &header)) return FAILURE;
+    *result = header.page_count;
+    return SUCCESS;
+}
+Test atlas_file_find (const uchar * data, usize len, const char * path, AtlasRegion * result) {
+    AtlasFileHeader header;
+    if (atlas_file_header(data, len, &header)) return NO;
+
+    usize cursor = sizeof(AtlasFileHeader);
+    for (usize i = 0; i < header.region_count; i++) {
+        AtlasFileRegion region;
+        if (read_bytes(data, len, &cursor, &region, sizeof(AtlasFileRegion))) return NO;
+        if (atlas_path_equals(data, len, &region, path) == NO) continue;
+        if (region.page >= header.page_count) return NO;
+
+        result->path   = (const char *)data + region.path_offset;
+        result->page   = region.page;
+        result->source = (Rectangle){ region.x, region.y, region.width, region.height };
+        return YES;
+    }
+    return NO;
+}
+
+/* Writing *******************************************************************/
+Result atlas_file_write (const AtlasRegion * regions, usize count, usize page_count, ListUchar * buffer) {
+    AtlasFileHeader header = {
+        .magic        = ATLAS_FILE_MAGIC,
+        .version      = ATLAS_FILE_VERSION,
+        .page_count   = page_count,
+        .region_count = count,
+    };
+    if (write_bytes(buffer, &header, sizeof(AtlasFileHeader))) return FAILURE;
+
+    usize path_offset = sizeof(AtlasFileHeader) + sizeof(AtlasFileRegion) * count;
+    for (usize i = 0; i < count; i++) {
+        AtlasFileRegion region = {
+            .path_offset = path_offset,
+            .path_length = string_length(regions[i].path),
+            .page        = regions[i].page,
+            .x           = regions[i].source.x,
+            .y           = regions[i].source.y,
+            .width       = regions[i].source.width,
+            .height      = regions[i].source.height,
+        };
+        path_offset += region.path_length + 1;
+        if (write_bytes(buffer, &region, sizeof(AtlasFileRegion))) return FAILURE;
+    }
+    for (usize i = 0; i < count; i++) {
+        if (write_bytes(buffer, regions[i].path, string_length(regions[i].path) + 1)) return FAILURE;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,25 @@
+#ifndef ATLAS_H_
+#define ATLAS_H_
+
+#include <raylib.h>
+#include "types.h"
+
+/// Atlases are produced by tools/asset_packer.c, index and pages are stored in a folder of their own
+/// Pages are pre-decoded textures like any other packed png, the index tells where each texture ended up
+#define ATLAS_FOLDER "atlas"
+#define ATLAS_INDEX_FILE "index"
+#define ATLAS_PAGE_FILE "page-%zu.png"
+#define ATLAS_PAGE_SIZE 2048
+
+typedef struct {
+    const char * path;
+    usize        page;
+    Rectangle    source;
+} AtlasRegion;
+
+Result atlas_file_page_count (const uchar * data, usize len, usize * result);
+/// Looks up the texture with given path, path of the result points into the index data
+Test   atlas_file_find       (const uchar * data, usize len, const char * path, AtlasRegion * result);
+Result atlas_file_write      (const AtlasRegion * regions, usize count, usize page_count, ListUchar * buffer);
+
+#endif // ATLAS_H_
@@ -1,4 +1,8 @@
 #include "audio.h"
+#include "quality.h"
+#include "music.h"
+#include "std.h"
+#include "random.h"
 #include <raylib.h>
 #include <raymath.h>
 
@@ -44,10 +48,7 @@ void UnloadSoundAlias(Sound);
 
 void apply_sound_settings (const Assets * assets, const Settings * settings) {
     SetMasterVolume(settings->volume_master);
-    for (usize i = 0; i <= FACTION_LAST; i++) {
-        SetMusicVolume(assets->faction_themes[i], settings->volume_music);
-    }
-    SetMusicVolume(assets->main_theme, settings->volume_music);
+    music_volume(settings->volume_music);
     for (usize i = 0; i < assets->sound_effects.len; i++) {
         if (assets->sound_effects.items[i].kind == SOUND_UI_CLICK) {
             SetSoundVolume(assets->sound_effects.items[i].sound, settings->volume_ui);
@@ -74,43 +75,69 @@ void play_sound (const Assets * assets, SoundEffectType kind) {
     SetSoundPitch(sound, pitch);
     PlaySound(sound);
 }
-void play_sound_inworld (const GameState * game, SoundEffectType kind, Vector2 position) {
-    Vector2 screen_pos = GetWorldToScreen2D(position, game->camera);
-    Vector2 screen = { GetScreenWidth(), GetScreenHeight() };
-    Vector2 center = Vector2Scale(screen, 0.5);
-    float len = Vector2Length(center);
-    float dist = Vector2Distance(center, screen_pos);
-    float volume = dist / len ;
-    volume = 1.0f - volume * volume;
-    float zoom = game->camera.zoom / 10.0;
-    volume *= zoom;
-    if (volume <= 0.0) return;
+/* Voice Pool ****************************************************************/
+typedef struct {
+    /// higher priority voices steal from lower ones when the pool is busy
+    uint8_t priority;
+    /// aliases made for the kind, also the most that can play at once
+    uint8_t limit;
+} VoiceRule;
 
-    const Assets * assets = game->resources;
-    Sound sound = {0};
+const VoiceRule voice_rules[SOUND_EFFECT_COUNT] = {
+    [SOUND_HURT_HUMAN]      = { 1, 4 },
+    [SOUND_HURT_HUMAN_OLD]  = { 1, 4 },
+    [SOUND_HURT_KNIGHT]     = { 1, 4 },
+    [SOUND_HURT_GOLEM]      = { 1, 4 },
+    [SOUND_HURT_GREMLIN]    = { 1, 4 },
+    [SOUND_HURT_GENIE]      = { 1, 4 },
+    [SOUND_HURT_CASTLE]     = { 3, 2 },
+
+    [SOUND_ATTACK_SWORD]    = { 2, 4 },
+    [SOUND_ATTACK_BOW]      = { 2, 4 },
+    [SOUND_ATTACK_HOLY]     = { 2, 4 },
+    [SOUND_ATTACK_KNIGHT]   = { 2, 4 },
+    [SOUND_ATTACK_GOLEM]    = { 2, 4 },
+    [SOUND_ATTACK_FIREBALL] = { 2, 4 },
+    [SOUND_ATTACK_TORNADO]  = { 2, 4 },
+    [SOUND_ATTACK_THUNDER]  = { 3, 2 },
+
+    [SOUND_MAGIC_HEALING]   = { 2, 3 },
+    [SOUND_MAGIC_WEAKNESS]  = { 2, 3 },
+};
+
+void voices_init (VoicePool * pool, const Assets * assets) {
+    clear_memory(pool, sizeof(VoicePool));
     for (usize i = 0; i < assets->sound_effects.len; i++) {
-        SoundEffect * effect = &assets->sound_effects.items[i];
-        if (effect->kind == kind) {
-            sound = effect->sound;
-            break;
+        const SoundEffect * effect = &assets->sound_effects.items[i];
+        if (effect->sound.frameCount == 0) continue;
+
+        for (usize v = 0; v < voice_rules[effect->kind].limit; v++) {
+            if (pool->len >= VOICE_POOL_SIZE) {
+                TraceLog(LOG_WARNING, "Voice pool is too small for all sound effects, %s is short on voices", sound_kind_name(effect->kind));
+                return;
+            }
+            pool->voices[pool->len ++] = (Voice){ .sound = LoadSoundAlias(effect->sound), .kind = effect->kind };
         }
     }
-    if (sound.frameCount == 0) {
-        TraceLog(LOG_WARNING, "Couldn't find sound: %s", sound_kind_name(kind));
-        return;
+}
+void voices_deinit (VoicePool * pool) {
+    for (usize i = 0; i < pool->len; i++) {
+        if (IsSoundPlaying(pool->voices[i].sound)) {
+            StopSound(pool->voices[i].sound);
+        }
+        UnloadSoundAlias(pool->voices[i].sound);
     }
-    SetSoundVolume(sound, volume * game->settings->volume_sfx);
-
-    float pan = ( center.x - screen_pos.x ) / len;
-    pan = pan * 0.5f + 0.5f;
-    SetSoundPan(sound, pan);
-
-    float pitch = GetRandomValue(80, 120) * 0.01;
-    SetSoundPitch(sound, pitch);
-    PlaySound(sound);
+    pool->len = 0;
 }
-void play_sound_concurent (GameState * game, SoundEffectType kind, Vector2 position) {
-    Vector2 screen_pos = GetWorldToScreen2D(position, game->camera);
+Test voice_weaker (const Voice * voice, const Voice * than) {
+    if (than == NULL) return YES;
+    uint8_t priority = voice_rules[voice->kind].priority;
+    uint8_t other = voice_rules[than->kind].priority;
+    if (priority != other) return priority < other ? YES : NO;
+    if (voice->volume != than->volume) return voice->volume < than->volume ? YES : NO;
+    return voice->started < than->started ? YES : NO;
+}
+void play_voice (GameState * game, SoundEffectType kind, Vector2 screen_pos, float gain) {
     Vector2 screen = { GetScreenWidth(), GetScreenHeight() };
     Vector2 center = Vector2Scale(screen, 0.5);
     float len = Vector2Length(center);
@@ -118,114 +145,130 @@ void play_sound_concurent (GameState * game, SoundEffectType kind, Vector2 posit
     float volume = dist / len ;
     volume = 1.0f - volume * volume;
     float zoom = game->camera.zoom / 10.0;
-    volume *= zoom;
+    volume *= zoom * gain;
     if (volume <= 0.0) return;
 
-    SoundEffect sound = {0};
-    for (usize i = 0; i < game->disabled_sounds.len; i++) {
-        if (game->disabled_sounds.items[i].kind == kind) {
-            sound = game->disabled_sounds.items[i];
-            listSFXRemove(&game->disabled_sounds, i);
-            break;
-        }
-    }
-    if (sound.sound.frameCount == 0) {
-        const Assets * assets = game->resources;
-        for (usize i = 0; i < assets->sound_effects.len; i++) {
-            SoundEffect * effect = &assets->sound_effects.items[i];
-            if (effect->kind == kind) {
-                sound = (SoundEffect){ kind, LoadSoundAlias(effect->sound) };
-                break;
-            }
+    VoicePool * pool = &game->voices;
+    Voice wanted = { .kind = kind, .volume = volume, .started = GetTime() };
+    Voice * idle = NULL;
+    Voice * same_kind = NULL;
+    Voice * weakest = NULL;
+    usize playing = 0;
+
+    for (usize i = 0; i < pool->len; i++) {
+        Voice * voice = &pool->voices[i];
+        if (IsSoundPlaying(voice->sound) == false) {
+            if (voice->kind == kind && idle == NULL) idle = voice;
+            continue;
         }
+        playing ++;
+        if (voice->kind == kind && voice_weaker(voice, same_kind)) same_kind = voice;
+        if (voice_weaker(voice, weakest)) weakest = voice;
     }
-    if (sound.sound.frameCount == 0) {
-        TraceLog(LOG_WARNING, "Couldn't find sound: %s", sound_kind_name(kind));
-        return;
+
+    Voice * voice = idle;
+    if (voice == NULL) {
+        // every alias of the kind is busy, take over the quietest or oldest of them
+        if (same_kind == NULL || voice_weaker(&wanted, same_kind)) return;
+        voice = same_kind;
+        StopSound(voice->sound);
     }
-    if (listSFXAppend(&game->active_sounds, sound)) {
-        TraceLog(LOG_ERROR, "Failed to play sound concurently: %s", sound_kind_name(kind));
-        UnloadSoundAlias(sound.sound);
-        return;
+    else if (playing >= quality_settings(&game->quality).voices) {
+        // keep the mixer load bounded by making room
+        if (weakest == NULL || voice_weaker(&wanted, weakest)) return;
+        StopSound(weakest->sound);
     }
 
-    SetSoundVolume(sound.sound, volume * game->settings->volume_sfx);
+    voice->volume = volume;
+    voice->started = wanted.started;
+    // crowd gain and zoom can push it over, anything above full volume clips
+    SetSoundVolume(voice->sound, fminf(volume * game->settings->volume_sfx, 1.0f));
 
     float pan = ( center.x - screen_pos.x ) / len;
     pan = pan * 0.5f + 0.5f;
-    SetSoundPan(sound.sound, pan);
+    SetSoundPan(voice->sound, pan);
 
-    float pitch = GetRandomValue(80, 120) * 0.01;
-    SetSoundPitch(sound.sound, pitch);
-    PlaySound(sound.sound);
+    float pitch = random_range(&game->random[RANDOM_PRESENTATION], 80, 120) * 0.01;
+    SetSoundPitch(voice->sound, pitch);
+    PlaySound(voice->sound);
 }
-void stop_sounds (ListSFX * sounds) {
-    for (usize i = 0; i < sounds->len; i++) {
-        if (IsSoundPlaying(sounds->items[i].sound)) {
-            StopSound(sounds->items[i].sound);
-        }
-        UnloadSoundAlias(sounds->items[i].sound);
+
+/* Sound Queue ***************************************************************/
+void queue_sound (GameState * game, SoundEffectType kind, Vector2 position) {
+    Vector2 screen_pos = GetWorldToScreen2D(position, game->camera);
+    Vector2 center = { GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f };
+    // too far off screen to be heard
+    if (Vector2DistanceSqr(center, screen_pos) >= Vector2LengthSqr(center)) return;
+
+    SoundQueue * queue = &game->sound_queue;
+    for (usize i = 0; i < queue->len; i++) {
+        SoundCluster * cluster = &queue->clusters[i];
+        if (cluster->kind != kind) continue;
+        if (Vector2Distance(cluster->position, screen_pos) > SOUND_CLUSTER_DISTANCE) continue;
+
+        cluster->count ++;
+        cluster->position = Vector2Add(cluster->position, Vector2Scale(Vector2Subtract(screen_pos, cluster->position), 1.0f / cluster->count));
+        return;
     }
-    sounds->len = 0;
+    if (queue->len >= SOUND_QUEUE_SIZE) return;
+    queue->clusters[queue->len ++] = (SoundCluster){ .kind = kind, .position = screen_pos, .count = 1 };
 }
-void clean_sounds (GameState * state) {
-    ListSFX * sounds = &state->active_sounds;
-    ListSFX * rest = &state->disabled_sounds;
-
-    usize idx = sounds->len;
-    while (idx --> 0) {
-        SoundEffect sound = sounds->items[idx];
-        if (! IsSoundPlaying(sound.sound)) {
-            listSFXRemove(sounds, idx);
-            listSFXAppend(rest, sound);
-        }
+void play_sound_queue (GameState * game) {
+    SoundQueue * queue = &game->sound_queue;
+    for (usize i = 0; i < queue->len; i++) {
+        const SoundCluster * cluster = &queue->clusters[i];
+        // bigger crowds sound louder but not as loud as all of them playing separately
+        float gain = fminf(1.0f + log2f(cluster->count) * 0.25f, 2.0f);
+        play_voice(game, cluster->kind, cluster->position, gain);
     }
+    queue->len = 0;
 }
 
+/* Unit Sounds ***************************************************************/
 void play_unit_hurt_sound (GameState * game, const Unit * unit) {
     switch (unit->type) {
         case UNIT_FIGHTER: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_HURT_HUMAN, unit->position);
+                    queue_sound(game, SOUND_HURT_HUMAN, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_HURT_GOLEM, unit->position);
+                    queue_sound(game, SOUND_HURT_GOLEM, unit->position);
                 } break;
             }
         } break;
         case UNIT_ARCHER: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_HURT_HUMAN, unit->position);
+                    queue_sound(game, SOUND_HURT_HUMAN, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_HURT_HUMAN_OLD, unit->position);
+                    queue_sound(game, SOUND_HURT_HUMAN_OLD, unit->position);
                 } break;
             }
         } break;
         case UNIT_SUPPORT: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_HURT_HUMAN_OLD, unit->position);
+                    queue_sound(game, SOUND_HURT_HUMAN_OLD, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_HURT_GREMLIN, unit->position);
+                    queue_sound(game, SOUND_HURT_GREMLIN, unit->position);
                 } break;
             }
         } break;
         case UNIT_SPECIAL: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_HURT_KNIGHT, unit->position);
+                    queue_sound(game, SOUND_HURT_KNIGHT, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_HURT_GENIE, unit->position);
+                    queue_sound(game, SOUND_HURT_GENIE, unit->position);
                 } break;
             }
         } break;
         case UNIT_GUARDIAN: {
-            play_sound_concurent(game, SOUND_HURT_CASTLE, unit->position);
+            queue_sound(game, SOUND_HURT_CASTLE, unit->position);
         } break;
     }
 }
@@ -234,50 +277,50 @@ void play_unit_attack_sound (GameState * game, const Unit * unit) {
         case UNIT_FIGHTER: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_ATTACK_SWORD, unit->position);
+                    queue_sound(game, SOUND_ATTACK_SWORD, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_ATTACK_GOLEM, unit->position);
+                    queue_sound(game, SOUND_ATTACK_GOLEM, unit->position);
                 } break;
             }
         } break;
         case UNIT_ARCHER: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_ATTACK_BOW, unit->position);
+                    queue_sound(game, SOUND_ATTACK_BOW, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_ATTACK_FIREBALL, unit->position);
+                    queue_sound(game, SOUND_ATTACK_FIREBALL, unit->position);
                 } break;
             }
         } break;
         case UNIT_SUPPORT: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_ATTACK_HOLY, unit->position);
+                    queue_sound(game, SOUND_ATTACK_HOLY, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_ATTACK_TORNADO, unit->position);
+                    queue_sound(game, SOUND_ATTACK_TORNADO, unit->position);
                 } break;
             }
         } break;
         case UNIT_SPECIAL: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_ATTACK_KNIGHT, unit->position);
+                    queue_sound(game, SOUND_ATTACK_KNIGHT, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_ATTACK_THUNDER, unit->position);
+                    queue_sound(game, SOUND_ATTACK_THUNDER, unit->position);
                 } break;
             }
         } break;
         case UNIT_GUARDIAN: {
             switch (unit->faction) {
                 case FACTION_KNIGHTS: {
-                    play_sound_concurent(game, SOUND_ATTACK_BOW, unit->position);
+                    queue_sound(game, SOUND_ATTACK_BOW, unit->position);
                 } break;
                 case FACTION_MAGES: {
-                    play_sound_concurent(game, SOUND_ATTACK_FIREBALL, unit->position);
+                    queue_sound(game, SOUND_ATTACK_FIREBALL, unit->position);
                 } break;
             }
         } break;
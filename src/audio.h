@@ -7,10 +7,13 @@ void apply_sound_settings (const Assets * assets, const Settings * settings);
 
 /* Direct sound handling *****************************************************/
 void play_sound           (const Assets * assets, SoundEffectType sound);
-void play_sound_inworld   (const GameState * game, SoundEffectType kind, Vector2 position);
-void play_sound_concurent (GameState * game, SoundEffectType kind, Vector2 position);
-void stop_sounds          (ListSFX * sounds);
-void clean_sounds         (GameState * sounds);
+/// Requests made during a tick are grouped by kind and screen position and played once per group
+void queue_sound          (GameState * game, SoundEffectType kind, Vector2 position);
+void play_sound_queue     (GameState * game);
+
+/* Voice pool ****************************************************************/
+void voices_init          (VoicePool * pool, const Assets * assets);
+void voices_deinit        (VoicePool * pool);
 
 /* Complex sound handling ****************************************************/
 void play_unit_attack_sound       (GameState * game, const Unit * unit);
@@ -9,6 +9,11 @@
 #define NDEBUG
 #endif
 
+// release builds like the qa apk can keep the profiler with -DPROFILER
+#if !defined(RELEASE) && !defined(PROFILER)
+#define PROFILER
+#endif
+
 #if defined(ANDROID)
 #define FPS 30
 #else
@@ -25,6 +30,13 @@
 #define UNIT_LEVELS 3
 
 #define PARTICLES_MAX 512
+// samples each particle curve is baked into
+#define PARTICLE_CURVE_STEPS 32
+// sound aliases made for a match, see voice_rules in audio.c for how they're split
+#define VOICE_POOL_SIZE 64
+// sounds of a kind requested within this many pixels from each other in one tick play once
+#define SOUND_CLUSTER_DISTANCE 96.0f
+#define SOUND_QUEUE_SIZE 32
 
 #define NAV_GRID_SIZE 12
 
@@ -35,6 +47,8 @@
 #define BUILDING_MAX_LEVEL 3
 
 #define PATH_THICKNESS (NAV_GRID_SIZE * 3)
+// largest distance objects can be picked from with the picking grid, larger ranges test every object
+#define PICKING_RADIUS PATH_THICKNESS
 
 #define LAYER_BACKGROUND -0.4f
 #define LAYER_MAP -0.3f
@@ -42,6 +56,59 @@
 #define LAYER_PATH -0.2f
 #define LAYER_BUILDING -0.1f
 #define MAP_BEVEL 5
+// frames the quality governor averages work time over
+#define QUALITY_AVERAGE_FRAMES 30
+// frames to wait after changing quality before lowering it again, raising waits three times as long
+#define QUALITY_SETTLE_FRAMES FPS
+// share of the frame budget above which quality is lowered and below which it is raised
+#define QUALITY_LOWER_AT 0.85f
+#define QUALITY_RAISE_AT 0.5f
+// share of the frame budget whole frames can take before the target frame rate counts as missed
+#define QUALITY_MISSED_AT 1.1f
+// nav grid cells along each side of a visibility chunk
+#define VISIBILITY_CHUNK_CELLS 16
+// part of the screen size added on each side of the cached world layer
+#define WORLD_LAYER_MARGIN 0.25f
+
+// prepared maps are stored on disk and reused until the map file changes
+#define MAP_CACHE
+// how many maps keep their geometry in memory after being played
+#define MAPS_LOADED_MAX 3
+
+// threads decoding assets in the background, with 0 assets are loaded on the main thread a piece per frame
+#define LOADER_WORKERS 2
+// seconds the main thread spends each frame uploading assets that finished decoding
+#define LOADER_FRAME_BUDGET 0.004
+// milliseconds the music thread sleeps between refilling the music stream
+#define MUSIC_UPDATE_INTERVAL 10
+#define MUSIC_COMMAND_QUEUE 16
+// seconds one theme fades into another
+#define MUSIC_CROSSFADE 1.5f
+// textures sprites can be drawn from, atlas pages count as one each
+#define SPRITE_TEXTURES_MAX 128
+#define ATLAS_PAGES_MAX 8
+// steps each unit animation is sampled at when looking up frames
+#define ANIMATION_LOOKUP_SIZE 64
+// segments on each side of the health ring when it's full
+#define HEALTH_RING_SEGMENTS 16
+// measured ui labels kept around, older ones get replaced when their slot is needed
+#define UI_TEXT_CACHE_SIZE 256
+// zones the profiler keeps per frame and how deep they can nest
+#define PROFILER_EVENTS 128
+#define PROFILER_DEPTH 16
+#define PROFILER_OVERLAY_FRAMES 30
+#define PROFILER_CAPTURE_FRAMES 120
+#define PROFILER_OVERLAY_KEY KEY_F3
+#define PROFILER_CAPTURE_KEY KEY_F4
+// fingers that have to be on the screen at once for the same on touch devices
+#define PROFILER_OVERLAY_TOUCHES 3
+#define PROFILER_CAPTURE_TOUCHES 4
+// ticks the pathfinding statistics are averaged over and how long expanded cells stay on the heatmap
+#define NAV_STATS_TICKS 60
+#define NAV_HEAT_SECONDS 5.0f
+// expansions within NAV_HEAT_SECONDS it takes for a cell to show at full strength
+#define NAV_HEAT_SCALE 20.0f
+#define NAV_STATS_KEY KEY_F5
 
 #define RENDER_PATHS
 /* #define RENDER_NAV_GRID */
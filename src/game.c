@@ -10,6 +10,11 @@
 #include "alloc.h"
 #include "audio.h"
 #include "unit_pool.h"
+#include "visibility.h"
+#include "quality.h"
+#include "profiler.h"
+#include "nav_stats.h"
+#include "random.h"
 #include <raymath.h>
 
 /* Information ***************************************************************/
@@ -91,6 +96,7 @@ Test spawn_unit (GameState * state, Building * building) {
         return NO;
     }
     listUnitAppend(&state->units, unit);
+    visibility_move_unit(&state->visibility, unit);
     return YES;
 }
 void update_buildings (GameState * state, float delta_time) {
@@ -255,6 +261,7 @@ void move_units (GameState * state, float delta_time) {
                 NavRangeSearchContext context = {
                     .type = NAV_CONTEXT_HOSTILE,
                     .amount = NAV_CONTEXT_SINGLE,
+                    .caller = NAV_CALLER_SIGHT,
                     .player_id = unit->player_owned,
                     .range = UNIT_MAX_RANGE
                 };
@@ -262,7 +269,8 @@ void move_units (GameState * state, float delta_time) {
                     NavTarget target = {
                         .approach_only = true,
                         .waypoint = context.unit_found->waypoint,
-                        .type = NAV_TARGET_WAYPOINT
+                        .type = NAV_TARGET_WAYPOINT,
+                        .caller = NAV_CALLER_CHASE,
                     };
                     if (nav_find_path(unit->waypoint, target, &unit->pathfind) == SUCCESS) {
                         continue;
@@ -275,7 +283,8 @@ void move_units (GameState * state, float delta_time) {
                     NavTarget navtarget = (NavTarget){
                         .region = region,
                         .approach_only = false,
-                        .type = NAV_TARGET_REGION
+                        .type = NAV_TARGET_REGION,
+                        .caller = NAV_CALLER_TRANSIT,
                     };
                     if (nav_find_path(unit->waypoint, navtarget, &unit->pathfind)) {
                         navtarget.region = path->region_a == region ? path->region_b : path->region_a;
@@ -295,7 +304,8 @@ void move_units (GameState * state, float delta_time) {
                         NavTarget navtarget = (NavTarget){
                             .region = target,
                             .approach_only = false,
-                            .type = NAV_TARGET_REGION
+                            .type = NAV_TARGET_REGION,
+                            .caller = NAV_CALLER_TRANSIT,
                         };
                         if (nav_find_path(unit->waypoint, navtarget, &unit->pathfind)) {
                             goto go_idle;
@@ -305,14 +315,15 @@ void move_units (GameState * state, float delta_time) {
                 go_idle: {}
                     usize allowed_attempts = 10;
                     while (allowed_attempts --> 0) {
-                        usize random = GetRandomValue(0, region->nav_graph.waypoints.len - 1);
+                        usize random = random_range(&state->random[RANDOM_SIMULATION], 0, region->nav_graph.waypoints.len - 1);
                         WayPoint * target = region->nav_graph.waypoints.items[random];
                         if (target == NULL) continue;
                         if (target->blocked || target->unit) continue;
                         NavTarget navtarget = {
                             .approach_only = true,
                             .waypoint = target,
-                            .type = NAV_TARGET_WAYPOINT
+                            .type = NAV_TARGET_WAYPOINT,
+                            .caller = NAV_CALLER_WANDER,
                         };
                         if (nav_find_path(unit->waypoint, navtarget, &unit->pathfind)) {
                             TraceLog(LOG_DEBUG, "Failed to find idling path inside region");
@@ -325,7 +336,8 @@ void move_units (GameState * state, float delta_time) {
                     NavTarget target = {
                         .approach_only = true,
                         .waypoint = region->castle.waypoint,
-                        .type = NAV_TARGET_WAYPOINT
+                        .type = NAV_TARGET_WAYPOINT,
+                        .caller = NAV_CALLER_TRANSIT,
                     };
                     if (nav_find_path(unit->waypoint, target, &unit->pathfind)) {
                         goto go_idle;
@@ -346,6 +358,7 @@ void move_units (GameState * state, float delta_time) {
                     unit->waypoint->world_position,
                     get_unit_speed(unit) * delta_time
                 );
+                visibility_move_unit(&state->visibility, unit);
             } break;
             default: break;
         }
@@ -413,7 +426,7 @@ void units_support (GameState * state, float delta_time) {
                 unit->facing_direction = Vector2Normalize(Vector2Subtract(most_hurt->position, unit->position));
                 listMagicEffectAppend(&most_hurt->effects, magic);
                 particles_magic(state, unit, most_hurt);
-                play_sound_concurent(state, SOUND_MAGIC_HEALING, unit->position);
+                queue_sound(state, SOUND_MAGIC_HEALING, unit->position);
             } break;
             case FACTION_MAGES: {
                 if (get_enemies_in_range(unit, &buffer)) {
@@ -438,7 +451,7 @@ void units_support (GameState * state, float delta_time) {
                     unit->facing_direction = Vector2Normalize(Vector2Subtract(target->position, unit->position));
                     listMagicEffectAppend(&target->effects, magic);
                     particles_magic(state, unit, target);
-                    play_sound_concurent(state, SOUND_MAGIC_WEAKNESS, unit->position);
+                    queue_sound(state, SOUND_MAGIC_WEAKNESS, unit->position);
                     break;
                 }
             } break;
@@ -615,6 +628,7 @@ void process_effects (GameState * state, float delta_time) {
     }
 }
 void simulate_units (GameState * state, float dt) {
+    PROFILE_BEGIN("cooldowns");
     for (usize i = 0; i < state->units.len; i++) {
         Unit * unit = state->units.items[i];
         if (unit->cooldown > 0)
@@ -626,15 +640,16 @@ void simulate_units (GameState * state, float dt) {
         if (guard->cooldown > 0)
             guard->cooldown -= dt;
     }
-
-    update_buildings  (state, dt);
-    update_unit_state (state);
-    move_units        (state, dt);
-    units_support     (state, dt);
-    units_fight       (state, dt);
-    guardian_fight    (state, dt);
-    units_damage      (state, dt);
-    process_effects   (state, dt);
+    PROFILE_END();
+
+    PROFILE_BEGIN("buildings");  update_buildings  (state, dt); PROFILE_END();
+    PROFILE_BEGIN("unit state"); update_unit_state (state);     PROFILE_END();
+    PROFILE_BEGIN("movement");   move_units        (state, dt); PROFILE_END();
+    PROFILE_BEGIN("support");    units_support     (state, dt); PROFILE_END();
+    PROFILE_BEGIN("fight");      units_fight       (state, dt); PROFILE_END();
+    PROFILE_BEGIN("guardians");  guardian_fight    (state, dt); PROFILE_END();
+    PROFILE_BEGIN("damage");     units_damage      (state, dt); PROFILE_END();
+    PROFILE_BEGIN("effects");    process_effects   (state, dt); PROFILE_END();
 }
 
 /* Gameplay Loop *************************************************************/
@@ -683,32 +698,47 @@ void setup_camera(GameState * state, const Theme * theme) {
     bounds.height = ( GetScreenHeight() - 20.0f - theme->info_bar_height ) / ( bounds.height * 2.0f );
     state->camera.zoom = (bounds.width < bounds.height) ? bounds.width : bounds.height;
 }
-Result game_state_prepare (GameState * result, const Map * prefab) {
-    TraceLog(LOG_INFO, "Cloning map for gameplay");
-    if (map_clone(&result->map, prefab)) {
+Result game_state_prepare (GameState * result, Map * prefab) {
+    TraceLog(LOG_INFO, "Preparing map %s", prefab->name);
+    // matches without a chosen seed get a fresh one, 16 bits at a time as wider ranges overflow inside GetRandomValue
+    while (result->seed == 0) {
+        for (usize i = 0; i < 4; i++) {
+            result->seed = (result->seed << 16) | (uint64_t)GetRandomValue(0, 0xFFFF);
+        }
+    }
+    TraceLog(LOG_INFO, "Match seed %llu", (unsigned long long)result->seed);
+    for (usize i = 0; i < RANDOM_STREAMS; i++) {
+        random_seed(&result->random[i], result->seed, i);
+    }
+    if (map_prepare_prefab(result->resources, prefab)) {
+        TraceLog(LOG_ERROR, "Failed to finalize setup for map %s", prefab->name);
+        return FAILURE;
+    }
+    TraceLog(LOG_INFO, "Instancing map for gameplay");
+    if (map_instantiate(&result->map, prefab)) {
         TraceLog(LOG_ERROR, "Failed to set up map %s, for gameplay", prefab->name);
         return FAILURE;
     }
-    TraceLog(LOG_INFO, "Preparing new map for gameplay");
     for (usize r = 0; r < result->map.regions.len; r++) {
         Region * region = &result->map.regions.items[r];
         region->faction = result->players.items[region->player_id].faction;
+        setup_unit_guardian(region);
     }
-    if (map_prepare_to_play(result->resources, &result->map)) {
-        TraceLog(LOG_ERROR, "Failed to finalize setup for map %s", prefab->name);
-        map_deinit(&result->map);
-        return FAILURE;
+    if (visibility_init(&result->visibility, &result->map)) {
+        TraceLog(LOG_ERROR, "Failed to set up visibility grid for map %s", prefab->name);
+        goto fail;
     }
     TraceLog(LOG_INFO, "Map ready to play");
 
-    result->active_sounds = listSFXInit(40, perm_allocator());
-    result->disabled_sounds = listSFXInit(40, perm_allocator());
+    voices_init(&result->voices, result->resources);
     result->units  = unit_pool_get_new();
 
-    result->particles_available = listParticleInit(PARTICLES_MAX, perm_allocator());
-    result->particles_in_use    = listParticleInit(PARTICLES_MAX, perm_allocator());
-    for (usize i = 0; i < PARTICLES_MAX; i++) {
-        listParticleAppend(&result->particles_available, (Particle*)&result->resources->particle_pool[i]);
+    result->unit_batch.sprites  = listSpriteQuadInit(128, perm_allocator());
+    result->unit_batch.effects  = listSpriteQuadInit(128, perm_allocator());
+    result->unit_batch.health   = listHealthRingInit(64, perm_allocator());
+    quality_init(&result->quality);
+    if (particles_init(&result->particles)) {
+        goto fail;
     }
 
     result->players.len = result->map.player_count + 1;
@@ -724,6 +754,18 @@ Result game_state_prepare (GameState * result, const Map * prefab) {
     }
 
     return SUCCESS;
+
+    fail:
+    // players stay with the caller, it can try again with another map
+    particles_deinit(&result->particles);
+    listSpriteQuadDeinit(&result->unit_batch.sprites);
+    listSpriteQuadDeinit(&result->unit_batch.effects);
+    listHealthRingDeinit(&result->unit_batch.health);
+    unit_pool_reset();
+    voices_deinit(&result->voices);
+    visibility_deinit(&result->visibility);
+    map_deinit(&result->map);
+    return FAILURE;
 }
 void game_state_deinit (GameState * state) {
     unit_pool_reset();
@@ -733,18 +775,32 @@ void game_state_deinit (GameState * state) {
         }
     }
     listPlayerDataDeinit(&state->players);
-    listParticleDeinit(&state->particles_available);
-    listParticleDeinit(&state->particles_in_use);
-    stop_sounds(&state->active_sounds);
-    stop_sounds(&state->disabled_sounds);
-    listSFXDeinit(&state->active_sounds);
-    listSFXDeinit(&state->disabled_sounds);
+    particles_deinit(&state->particles);
+    voices_deinit(&state->voices);
     map_deinit(&state->map);
+    world_layer_unload(&state->world_layer);
+    visibility_deinit(&state->visibility);
+    listSpriteQuadDeinit(&state->unit_batch.sprites);
+    listSpriteQuadDeinit(&state->unit_batch.effects);
+    listHealthRingDeinit(&state->unit_batch.health);
     clear_memory(state, sizeof(GameState));
 }
+void game_step (GameState * state, float dt) {
+    state->turn ++;
+    NAV_STAT(nav_stats_tick());
+
+    PROFILE_BEGIN("resources"); update_resources(state);      PROFILE_END();
+    PROFILE_BEGIN("ai");        simulate_ai(state);           PROFILE_END();
+    PROFILE_BEGIN("units");     simulate_units(state, dt);    PROFILE_END();
+    PROFILE_BEGIN("sounds");    play_sound_queue(state);      PROFILE_END();
+
+    PROFILE_BEGIN("particles advance"); particles_advance(state, dt); PROFILE_END();
+    PROFILE_BEGIN("particles clean");   particles_clean(state);       PROFILE_END();
+}
 void game_tick (GameState * state) {
     float dt = GetFrameTime();
-    update_input_state(state);
+    PROFILE_BEGIN("tick");
+    PROFILE_BEGIN("input"); update_input_state(state); PROFILE_END();
 
     #if defined(GAME_SUPER_SPEED)
     int counter;
@@ -754,19 +810,12 @@ void game_tick (GameState * state) {
     while (counter --> 0) {
     #endif
 
-    state->turn ++;
-
-    update_resources(state);
-    simulate_ai(state);
-    simulate_units(state, dt);
-    clean_sounds(state);
-
-    particles_advance(state->particles_in_use.items, state->particles_in_use.len, dt);
-    particles_clean(state);
+    game_step(state, dt);
 
     #if defined(GAME_SUPER_SPEED)
     }
     #endif
+    PROFILE_END();
 }
 usize game_winner (GameState * game) {
     usize player = 0;
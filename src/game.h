@@ -8,8 +8,10 @@ Result       get_local_player_index (const GameState * state, usize * result);
 Color        get_player_color       (usize player_id);
 
 void      game_tick          (GameState * state);
+/// Advances the match by one turn without reading input, for running matches without a player
+void      game_step          (GameState * state, float dt);
 usize     game_winner        (GameState * game);
-Result    game_state_prepare (GameState * result, const Map * prefab);
+Result    game_state_prepare (GameState * result, Map * prefab);
 void      game_state_deinit  (GameState * state);
 
 #endif // GAME_H_
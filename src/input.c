@@ -119,31 +119,20 @@ void state_none (GameState * state) {
         #endif
     }
 
-    for (usize i = 0; i < region->buildings.len; i++) {
-        Building * b = &region->buildings.items[i];
-        if (CheckCollisionPointCircle(cursor, b->position, PLAYER_SELECTION_RADIUS)) {
-            state->current_input = INPUT_CLICKED_BUILDING;
-            state->selected_building = b;
-            state->selected_region = region;
-            return;
-        }
+    Building * b = get_building_by_position(&state->map, cursor, PLAYER_SELECTION_RADIUS);
+    if (b && b->region == region) {
+        state->current_input = INPUT_CLICKED_BUILDING;
+        state->selected_building = b;
+        state->selected_region = region;
+        return;
     }
 
-    for (usize i = 0; i < region->paths.len; i++) {
-        Path * path = region->paths.items[i];
-        Vector2 point;
-        if (path->region_a == region) {
-            point = path->lines.items[0].a;
-        }
-        else {
-            point = path->lines.items[path->lines.len - 1].b;
-        }
-        if (CheckCollisionPointCircle(cursor, point, PLAYER_SELECTION_RADIUS)) {
-            state->selected_region = region;
-            state->selected_path = path;
-            state->current_input = INPUT_CLICKED_PATH;
-            return;
-        }
+    Path * path = region_path_by_position(region, cursor, PLAYER_SELECTION_RADIUS);
+    if (path) {
+        state->selected_region = region;
+        state->selected_path = path;
+        state->current_input = INPUT_CLICKED_PATH;
+        return;
     }
 }
 void state_clicked_building (GameState * state) {
@@ -341,31 +330,19 @@ void find_pointed_thing (GameState * state, usize player) {
 
     state->selected_region = region;
 
-    for (usize i = 0; i < region->buildings.len; i++) {
-        Building * building = &region->buildings.items[i];
-        if (CheckCollisionPointCircle(cursor, building->position, PATH_THICKNESS)) {
-            state->selected_building = building;
-            state->current_input = INPUT_CLICKED_BUILDING;
-            return;
-        }
+    Building * building = get_building_by_position(&state->map, cursor, PATH_THICKNESS);
+    if (building && building->region == region) {
+        state->selected_building = building;
+        state->current_input = INPUT_CLICKED_BUILDING;
+        return;
     }
 
-    for (usize i = 0; i < region->paths.len; i++) {
-        Path * path = region->paths.items[i];
-        Vector2 point;
-        if (path->region_a == region) {
-            point = path->lines.items[0].a;
-        }
-        else {
-            point = path->lines.items[path->lines.len - 1].b;
-        }
-        if (CheckCollisionPointCircle(cursor, point, PATH_THICKNESS)) {
-            state->selected_path = path;
-            state->current_input = INPUT_CLICKED_PATH;
-            return;
-        }
+    Path * path = region_path_by_position(region, cursor, PATH_THICKNESS);
+    if (path) {
+        state->selected_path = path;
+        state->current_input = INPUT_CLICKED_PATH;
+        return;
     }
-
 }
 void update_input_state_android (GameState * state) {
     usize player = 0;
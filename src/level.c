@@ -9,7 +9,14 @@
 #include "units.h"
 #include "audio.h"
 #include "ai.h"
+#include "map_cache.h"
+#include "sprite.h"
+#include "visibility.h"
+#include "nav_stats.h"
+#include "quality.h"
+#include "picking.h"
 #include <raymath.h>
+#include <rlgl.h>
 #include <assert.h>
 
 /* Line Functions **********************************************************/
@@ -265,6 +272,8 @@ bool area_contains_point (const Area * area, const Vector2 point) {
             contains = true;
         }
     }
+    // hands the memory back to the arena, map setup tests thousands of points before the next reset
+    listVector2Deinit(&intersections);
 
     return contains;
 }
@@ -355,6 +364,13 @@ usize building_max_units (const Building * building) {
     return building_unit_capacity[building->type][building->upgrades];
 }
 Building * get_building_by_position (const Map * map, Vector2 position, float range) {
+    const PickCell * cell = picking_cell(map, position);
+    if (cell && range <= PICKING_RADIUS && (cell->flags & PICK_BUILDING_OVERLAP) == 0) {
+        if (cell->building == 0) return NULL;
+        Building * building = &map->regions.items[cell->building_region - 1].buildings.items[cell->building - 1];
+        return CheckCollisionPointCircle(position, building->position, range) ? building : NULL;
+    }
+
     for (usize r = 0; r < map->regions.len; r++) {
         ListBuilding * buildings = &map->regions.items[r].buildings;
 
@@ -454,13 +470,13 @@ const char * building_name (BuildingType building, FactionType faction, usize up
         default: return "ERROR: UNKNOWN FACTION";
     }
 }
-Texture2D building_image (const Assets * assets, FactionType faction, BuildingType building, usize level) {
+Sprite building_image (const Assets * assets, FactionType faction, BuildingType building, usize level) {
     if (level > BUILDING_MAX_UPGRADES || faction > FACTION_LAST || building > BUILDING_TYPE_LAST)
-        return (Texture2D){0};
+        return (Sprite){0};
     const BuildingSpriteSet * set = &assets->buildings[faction];
     switch (building) {
         default:
-        case BUILDING_EMPTY: return (Texture2D) {0};
+        case BUILDING_EMPTY: return (Sprite) {0};
         case BUILDING_FIGHTER: return set->fighter[level];
         case BUILDING_ARCHER: return set->archer[level];
         case BUILDING_SUPPORT: return set->support[level];
@@ -539,7 +555,35 @@ void region_change_ownership (GameState * state, Region * region, usize player_i
 Region * region_by_unit (const Unit * unit) {
     return unit->waypoint->graph->region;
 }
+Vector2 path_end_in_region (const Path * path, const Region * region) {
+    return path->region_a == region ? path->lines.items[0].a : path->lines.items[path->lines.len - 1].b;
+}
+Path * region_path_by_position (const Region * region, Vector2 position, float range) {
+    const PickCell * cell = picking_cell(region->map, position);
+    if (cell && range <= PICKING_RADIUS && (cell->flags & PICK_PATH_OVERLAP) == 0) {
+        if (cell->path == 0) return NULL;
+        Path * path = &region->map->paths.items[cell->path - 1];
+        Region * owner = cell->path_end ? path->region_b : path->region_a;
+        if (owner != region) return NULL;
+        return CheckCollisionPointCircle(position, path_end_in_region(path, region), range) ? path : NULL;
+    }
+
+    for (usize i = 0; i < region->paths.len; i++) {
+        Path * path = region->paths.items[i];
+        if (CheckCollisionPointCircle(position, path_end_in_region(path, region), range)) {
+            return path;
+        }
+    }
+    return NULL;
+}
 Result region_by_position (const Map * map, Vector2 position, Region ** result) {
+    const PickCell * cell = picking_cell(map, position);
+    if (cell && (cell->flags & PICK_REGION_EDGE) == 0) {
+        if (cell->region == 0) return FAILURE;
+        *result = &map->regions.items[cell->region - 1];
+        return SUCCESS;
+    }
+
     for (usize r = 0; r < map->regions.len; r++) {
         Region * region = &map->regions.items[r];
         if (area_contains_point(&region->area, position)) {
@@ -645,6 +689,10 @@ float get_expected_maintenance_cost (const Map * map, usize player) {
     return cost;
 }
 Region * map_get_region_at (const Map * map, Vector2 point) {
+    Region * found;
+    if (map->picking.cells) {
+        return region_by_position(map, point, &found) ? NULL : found;
+    }
     for (usize r = 0; r < map->regions.len; r++) {
         Region * region = &map->regions.items[r];
         if (area_contains_point(&region->area, point)) {
@@ -674,14 +722,39 @@ void render_map (Map * map) {
         }
     }
 }
-void render_map_mesh (const GameState * state) {
-    Shader shader = state->map.background.materials[0].shader;
-    int time_loc = GetShaderLocation(shader, "time");
-    float time = get_time();
-    SetShaderValue(shader, time_loc, &time, SHADER_UNIFORM_FLOAT);
+/* World Layer *************************************************************/
+uint64_t world_layer_hash (uint64_t hash, uint64_t value) {
+    hash ^= value;
+    hash *= 0x100000001b3ULL;
+    return hash;
+}
+// everything the static layer is drawn from, so it doesn't matter where in the game it gets changed
+uint64_t world_layer_signature (const GameState * state) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (usize i = 0; i < state->map.regions.len; i++) {
+        const Region * region = &state->map.regions.items[i];
+        hash = world_layer_hash(hash, region->player_id);
+        hash = world_layer_hash(hash, region->faction);
+        hash = world_layer_hash(hash, region->active_path);
+        for (usize b = 0; b < region->buildings.len; b++) {
+            hash = world_layer_hash(hash, region->buildings.items[b].type);
+            hash = world_layer_hash(hash, region->buildings.items[b].upgrades);
+        }
+    }
+    // sprites still loading are drawn again once they arrive
+    const SpriteTextures * sprites = &state->resources->sprites;
+    for (usize i = 0; i < sprites->texture_count; i++) {
+        hash = world_layer_hash(hash, sprites->textures[i].id);
+    }
+    hash = world_layer_hash(hash, quality_settings(&state->quality).animated_water);
+    return hash;
+}
+void render_world_layer (GameState * state, Rectangle area) {
+    visibility_mark(&state->visibility, area);
+    Rectangle building_area = { area.x - NAV_GRID_SIZE, area.y - NAV_GRID_SIZE, area.width + NAV_GRID_SIZE * 2, area.height + NAV_GRID_SIZE * 2 };
 
-    DrawModel(state->map.background, Vector3Zero(), 1.0f, WHITE);
     for (usize i = 0; i < state->map.regions.len; i++) {
+        if (visibility_region_marked(&state->visibility, i) == NO) continue;
         const Region * region = &state->map.regions.items[i];
         DrawModel(region->area.model, Vector3Zero(), 1.0f, WHITE);
         DrawModel(region->area.outline, Vector3Zero(), 1.0f, get_player_color(region->player_id));
@@ -689,7 +762,8 @@ void render_map_mesh (const GameState * state) {
         const ListBuilding * buildings = &region->buildings;
         for (usize b = 0; b < buildings->len; b++) {
             Building * building = &buildings->items[b];
-            const Texture2D * sprite = NULL;
+            if (! CheckCollisionPointRec(building->position, building_area)) continue;
+            const Sprite * sprite = NULL;
             switch (building->type) {
                 case BUILDING_EMPTY: {
                 } break;
@@ -717,12 +791,10 @@ void render_map_mesh (const GameState * state) {
             };
             Vector2 origin = (Vector2){ NAV_GRID_SIZE, NAV_GRID_SIZE };
             if (sprite != NULL) {
-                Rectangle source = { 0, 0, sprite->width, sprite->height };
-                DrawTexturePro(*sprite, source, destination, origin, 0.0f, WHITE);
+                draw_sprite(*sprite, destination, origin, 0.0f, WHITE);
             }
             else {
-                Rectangle source = { 0, 0, state->resources->empty_building.width, state->resources->empty_building.height };
-                DrawTexturePro(state->resources->empty_building, source, destination, origin, 0, WHITE);
+                draw_sprite(state->resources->empty_building, destination, origin, 0, WHITE);
             }
         }
 
@@ -731,16 +803,16 @@ void render_map_mesh (const GameState * state) {
             Vector2 end = active_path->region_a == region ?
                 active_path->lines.items[0].a :
                 active_path->lines.items[active_path->lines.len - 1].b;
-            Rectangle whole = {0, 0, state->resources->flag.width, state->resources->flag.height};
             Rectangle target = {end.x, end.y, NAV_GRID_SIZE, NAV_GRID_SIZE};
             Vector2 origin = {target.width * 0.5f, target.height * 0.5f};
-            DrawTexturePro(state->resources->flag, whole, target, origin, 0, get_player_color(region->player_id));
+            draw_sprite(state->resources->flag, target, origin, 0, get_player_color(region->player_id));
         }
 
     }
 
     #ifdef RENDER_PATHS
     for (usize i = 0; i < state->map.paths.len; i++) {
+        if (visibility_path_marked(&state->visibility, i) == NO) continue;
         const Path * path = &state->map.paths.items[i];
         DrawModel(path->model, Vector3Zero(), 1.0f, WHITE);
         #ifdef RENDER_PATHS_DEBUG
@@ -751,6 +823,90 @@ void render_map_mesh (const GameState * state) {
         #endif
     }
     #endif
+}
+void world_layer_update (GameState * state) {
+    WorldLayer * layer = &state->world_layer;
+    float screen_width = GetScreenWidth();
+    float screen_height = GetScreenHeight();
+    int width = screen_width * (1.0f + WORLD_LAYER_MARGIN * 2.0f);
+    int height = screen_height * (1.0f + WORLD_LAYER_MARGIN * 2.0f);
+
+    if (layer->texture.id == 0 || layer->texture.texture.width != width || layer->texture.texture.height != height) {
+        if (layer->texture.id) UnloadRenderTexture(layer->texture);
+        layer->texture = LoadRenderTexture(width, height);
+        layer->zoom = 0.0f;
+        if (layer->texture.id == 0) {
+            TraceLog(LOG_WARNING, "Failed to create texture for world layer, it will be drawn every frame");
+            return;
+        }
+    }
+
+    float zoom = state->camera.zoom;
+    Vector2 top_left = GetScreenToWorld2D(Vector2Zero(), state->camera);
+    Rectangle visible = { top_left.x, top_left.y, screen_width / zoom, screen_height / zoom };
+    uint64_t signature = world_layer_signature(state);
+
+    Test covered = layer->zoom == zoom
+        && visible.x >= layer->area.x
+        && visible.y >= layer->area.y
+        && visible.x + visible.width <= layer->area.x + layer->area.width
+        && visible.y + visible.height <= layer->area.y + layer->area.height;
+    if (covered && signature == layer->signature) return;
+
+    layer->signature = signature;
+    layer->zoom = zoom;
+    layer->area = (Rectangle) {
+        visible.x - visible.width * WORLD_LAYER_MARGIN,
+        visible.y - visible.height * WORLD_LAYER_MARGIN,
+        width / zoom,
+        height / zoom,
+    };
+    Camera2D camera = { .target = { layer->area.x, layer->area.y }, .zoom = zoom };
+
+    EndMode2D();
+    BeginTextureMode(layer->texture);
+    ClearBackground(BLANK);
+    BeginMode2D(camera);
+    // alpha is kept premultiplied so the layer blends over the water same as if it was drawn directly
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    if (quality_settings(&state->quality).animated_water == false) {
+        DrawModel(state->map.background, Vector3Zero(), 1.0f, WHITE);
+    }
+    render_world_layer(state, layer->area);
+    EndBlendMode();
+    EndMode2D();
+    EndTextureMode();
+    BeginMode2D(state->camera);
+}
+void world_layer_unload (WorldLayer * layer) {
+    if (layer->texture.id) UnloadRenderTexture(layer->texture);
+    clear_memory(layer, sizeof(WorldLayer));
+}
+void render_map_mesh (GameState * state) {
+    bool animated_water = quality_settings(&state->quality).animated_water;
+    if (animated_water) {
+        Shader shader = state->map.background.materials[0].shader;
+        float time = get_time();
+        SetShaderValue(shader, state->resources->water_time_location, &time, SHADER_UNIFORM_FLOAT);
+        DrawModel(state->map.background, Vector3Zero(), 1.0f, WHITE);
+    }
+
+    world_layer_update(state);
+    WorldLayer * layer = &state->world_layer;
+    if (layer->texture.id) {
+        // render textures are stored upside down
+        Rectangle source = { 0, 0, layer->texture.texture.width, -layer->texture.texture.height };
+        BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+        DrawTexturePro(layer->texture.texture, source, layer->area, Vector2Zero(), 0.0f, WHITE);
+        EndBlendMode();
+    }
+    else {
+        if (animated_water == false) {
+            DrawModel(state->map.background, Vector3Zero(), 1.0f, WHITE);
+        }
+        render_world_layer(state, visibility_view(state->camera, 0.0f));
+    }
 
     #ifdef RENDER_NAV_GRID
     const Map * map = &state->map;
@@ -763,6 +919,9 @@ void render_map_mesh (const GameState * state) {
         nav_render(&region->nav_graph);
     }
     #endif
+    #if !defined(RELEASE)
+    nav_stats_render_heat(&state->map.nav_grid, visibility_view(state->camera, 0.0f));
+    #endif
 }
 
 void map_clamp (Map * map) {
@@ -779,6 +938,10 @@ void map_clamp (Map * map) {
 Result map_clone (Map * dest, const Map * src) {
     clear_memory(dest, sizeof(Map));
     dest->name = src->name;
+    dest->path = src->path;
+    dest->loaded = src->loaded;
+    dest->last_used = src->last_used;
+    dest->hash = src->hash;
     dest->width = src->width;
     dest->height = src->height;
     dest->player_count = src->player_count;
@@ -807,7 +970,120 @@ Result map_clone (Map * dest, const Map * src) {
     map_deinit(dest);
     return FAILURE;
 }
+Result map_instantiate (Map * dest, const Map * prefab) {
+    clear_memory(dest, sizeof(Map));
+    dest->name = prefab->name;
+    dest->path = prefab->path;
+    dest->loaded = true;
+    dest->hash = prefab->hash;
+    dest->width = prefab->width;
+    dest->height = prefab->height;
+    dest->player_count = prefab->player_count;
+    dest->background = prefab->background;
+    dest->prepared = true;
+    dest->prefab = prefab;
+    dest->paths = listPathInit(prefab->paths.len, perm_allocator());
+    dest->regions = listRegionInit(prefab->regions.len, perm_allocator());
+    if (dest->paths.items == NULL || dest->regions.items == NULL) {
+        TraceLog(LOG_ERROR, "!Failed to allocate map objects");
+        goto fail;
+    }
+
+    for (usize p = 0; p < prefab->paths.len; p++) {
+        const Path * from = &prefab->paths.items[p];
+        Path * to = &dest->paths.items[p];
+        dest->paths.len ++;
+        clear_memory(to, sizeof(Path));
+        to->path_id = from->path_id;
+        to->lines = from->lines;
+        to->model = from->model;
+        to->map = dest;
+        if (from->region_a) to->region_a = &dest->regions.items[from->region_a - prefab->regions.items];
+        if (from->region_b) to->region_b = &dest->regions.items[from->region_b - prefab->regions.items];
+    }
+
+    for (usize r = 0; r < prefab->regions.len; r++) {
+        const Region * from = &prefab->regions.items[r];
+        Region * to = &dest->regions.items[r];
+        dest->regions.len ++;
+        clear_memory(to, sizeof(Region));
+        to->region_id = from->region_id;
+        to->player_id = from->player_id;
+        to->faction = from->faction;
+        to->area = from->area;
+        to->map = dest;
+        to->active_path = from->paths.len;
+
+        to->paths = listPathPInit(from->paths.len, perm_allocator());
+        to->buildings = listBuildingInit(from->buildings.len, perm_allocator());
+        if (to->paths.items == NULL || to->buildings.items == NULL) {
+            TraceLog(LOG_ERROR, "!Failed to allocate objects of region %zu", r);
+            goto fail;
+        }
+        for (usize p = 0; p < from->paths.len; p++) {
+            listPathPAppend(&to->paths, &dest->paths.items[from->paths.items[p] - prefab->paths.items]);
+        }
+        for (usize b = 0; b < from->buildings.len; b++) {
+            Building * building = &to->buildings.items[b];
+            to->buildings.len ++;
+            clear_memory(building, sizeof(Building));
+            building->position = from->buildings.items[b].position;
+            building->region = to;
+        }
+    }
+
+    if (nav_init_instance(dest, prefab)) {
+        TraceLog(LOG_ERROR, "!Failed to instance map nav grid");
+        goto fail;
+    }
+    if (picking_init(dest)) {
+        TraceLog(LOG_ERROR, "!Failed to build picking grid");
+        goto fail;
+    }
+
+    for (usize r = 0; r < prefab->regions.len; r++) {
+        const Region * from = &prefab->regions.items[r];
+        Region * to = &dest->regions.items[r];
+
+        for (usize b = 0; b < from->buildings.len; b++) {
+            const ListWayPoint * points = &from->buildings.items[b].spawn_points;
+            ListWayPoint * spawn_points = &to->buildings.items[b].spawn_points;
+            *spawn_points = listWayPointInit(points->len ? points->len : 1, perm_allocator());
+            if (spawn_points->items == NULL) {
+                TraceLog(LOG_ERROR, "!Failed to allocate spawn points");
+                goto fail;
+            }
+            for (usize w = 0; w < points->len; w++) {
+                const WayPoint * point = points->items[w];
+                listWayPointAppend(spawn_points, point ? nav_instance_waypoint(&dest->nav_grid, point) : NULL);
+            }
+        }
+
+        setup_unit_guardian(to);
+        WayPoint * point = nav_instance_waypoint(&dest->nav_grid, from->castle.waypoint);
+        point->unit = &to->castle;
+        to->castle.waypoint = point;
+        to->castle.position = point->world_position;
+    }
+
+    return SUCCESS;
+
+    fail:
+    map_deinit(dest);
+    return FAILURE;
+}
 void map_deinit (Map * map) {
+    // instanced maps only release what they allocated themselves, the rest belongs to the prefab
+    if (map->prefab) {
+        map->background = (Model){0};
+        for (usize p = 0; p < map->paths.len; p++) {
+            map->paths.items[p].lines = (ListLine){0};
+            map->paths.items[p].model = (Model){0};
+        }
+        for (usize r = 0; r < map->regions.len; r++) {
+            map->regions.items[r].area = (Area){0};
+        }
+    }
     UnloadModel(map->background);
     for (usize p = 0; p < map->paths.len; p++) {
         TraceLog(LOG_DEBUG, "Deinitializing path %zu", p);
@@ -818,10 +1094,71 @@ void map_deinit (Map * map) {
         region_deinit(&map->regions.items[r]);
     }
     nav_deinit_global(&map->nav_grid);
+    picking_deinit(map);
     listPathDeinit(&map->paths);
     listRegionDeinit(&map->regions);
     clear_memory(map, sizeof(Map));
 }
+Result region_connect_objects (Region * region) {
+    for (usize b = 0; b < region->buildings.len; b++) {
+        TraceLog(LOG_DEBUG, "  Connecting building %zu", b);
+        Building * building = &region->buildings.items[b];
+        building->region = region;
+        building->spawn_points = listWayPointInit(8, perm_allocator());
+        WayPoint * point;
+
+        if (nav_find_waypoint(&region->nav_graph, building->position, &point)) {
+            TraceLog(LOG_ERROR, "!Failed to find navigation position for building nr %zu in region %zu", b, region->region_id);
+            return FAILURE;
+        }
+        if (point == NULL) {
+            TraceLog(LOG_ERROR, "!The point the building %zu is at doesn't have nav grid coverage in region %zu", b, region->region_id);
+            return FAILURE;
+        }
+        if (point->blocked) {
+            TraceLog(LOG_ERROR, "!The position of the building %zu overlaps with another one in region %zu", b, region->region_id);
+            return FAILURE;
+        }
+
+        building->position = point->world_position;
+        point->blocked = true;
+        if (nav_gather_points(point, &building->spawn_points)) {
+            TraceLog(LOG_ERROR, "!Failed to gather spawn points");
+            return FAILURE;
+        }
+    }
+
+    WayPoint * point;
+    TraceLog(LOG_DEBUG, "Castle position [%.1f, %.1f]", region->castle.position.x, region->castle.position.y);
+    if (nav_find_waypoint(&region->nav_graph, region->castle.position, &point)) {
+        TraceLog(LOG_ERROR, "!Failed to find position for the castle");
+        return FAILURE;
+    }
+    if (point == NULL) {
+        TraceLog(LOG_ERROR, "!Position of the castle is outside of region's nav grid");
+        return FAILURE;
+    }
+    if (point->blocked) {
+        TraceLog(LOG_ERROR, "!Position of the castle overlaps with a building");
+        return FAILURE;
+    }
+    setup_unit_guardian(region);
+    point->unit = &region->castle;
+    region->castle.waypoint = point;
+    region->castle.position = point->world_position;
+    return SUCCESS;
+}
+Result path_link_regions (Path * path) {
+    if (listPathPAppend(&path->region_a->paths, path)) {
+        TraceLog(LOG_ERROR, "!Failed to add path to region a");
+        return FAILURE;
+    }
+    if (listPathPAppend(&path->region_b->paths, path)) {
+        TraceLog(LOG_ERROR, "!Failed to add path to region b");
+        return FAILURE;
+    }
+    return SUCCESS;
+}
 Result map_make_connections (Map * map) {
     TraceLog(LOG_INFO, "Connecting map");
     if (nav_init_global_grid(map)) {
@@ -836,53 +1173,10 @@ Result map_make_connections (Map * map) {
             TraceLog(LOG_ERROR, "!Failed to initialize region %zu navigation grid", i);
             return FAILURE;
         }
-
-        for (usize b = 0; b < region->buildings.len; b++) {
-            TraceLog(LOG_DEBUG, "  Connecting building %zu", b);
-            Building * building = &region->buildings.items[b];
-            building->region = region;
-            building->spawn_points = listWayPointInit(8, perm_allocator());
-            WayPoint * point;
-
-            if (nav_find_waypoint(&region->nav_graph, building->position, &point)) {
-                TraceLog(LOG_ERROR, "!Failed to find navigation position for building nr %zu in region %zu", b, region->region_id);
-                return FAILURE;
-            }
-            if (point == NULL) {
-                TraceLog(LOG_ERROR, "!The point the building %zu is at doesn't have nav grid coverage in region %zu", b, region->region_id);
-                return FAILURE;
-            }
-            if (point->blocked) {
-                TraceLog(LOG_ERROR, "!The position of the building %zu overlaps with another one in region %zu", b, region->region_id);
-                return FAILURE;
-            }
-
-            building->position = point->world_position;
-            point->blocked = true;
-            if (nav_gather_points(point, &building->spawn_points)) {
-                TraceLog(LOG_ERROR, "!Failed to gather spawn points");
-                return FAILURE;
-            }
-        }
-
-        WayPoint * point;
-        TraceLog(LOG_DEBUG, "Castle position [%.1f, %.1f]", region->castle.position.x, region->castle.position.y);
-        if (nav_find_waypoint(&region->nav_graph, region->castle.position, &point)) {
-            TraceLog(LOG_ERROR, "!Failed to find position for the castle");
-            return FAILURE;
-        }
-        if (point == NULL) {
-            TraceLog(LOG_ERROR, "!Position of the castle is outside of region's nav grid");
+        if (region_connect_objects(region)) {
+            TraceLog(LOG_ERROR, "!Failed to connect objects of region %zu", i);
             return FAILURE;
         }
-        if (point->blocked) {
-            TraceLog(LOG_ERROR, "!Position of the castle overlaps with a building");
-            return FAILURE;
-        }
-        setup_unit_guardian(region);
-        point->unit = &region->castle;
-        region->castle.waypoint = point;
-        region->castle.position = point->world_position;
 
         TraceLog(LOG_DEBUG, "+Completed connecting region %zu", i);
     }
@@ -917,14 +1211,7 @@ Result map_make_connections (Map * map) {
                     TraceLog(LOG_ERROR, "!Failed to initialize path's navigation grid");
                     return FAILURE;
                 }
-
-                if (listPathPAppend(&path->region_a->paths, path)) {
-                    TraceLog(LOG_ERROR, "!Failed to add path to region a");
-                    return FAILURE;
-                }
-                if (listPathPAppend(&path->region_b->paths, path)) {
-
-                    TraceLog(LOG_ERROR, "!Failed to add path to region b");
+                if (path_link_regions(path)) {
                     return FAILURE;
                 }
                 TraceLog(LOG_INFO, "Path connected");
@@ -971,14 +1258,54 @@ void map_apply_textures (const Assets * assets, Map * map) {
     SetMaterialTexture(&map->background.materials[0], MATERIAL_MAP_DIFFUSE, assets->water_texture);
 }
 Result map_prepare_to_play (const Assets * assets, Map * map) {
-  map_clamp(map);
-  map_subdivide_paths(map);
-  if(map_make_connections(map)) {
+  Result cached = map_cache_load(map);
+  if (cached == FATAL) {
     return FAILURE;
   }
-  if(generate_map_mesh(map)) {
+  if (cached) {
+    map_clamp(map);
+    map_subdivide_paths(map);
+    if(map_make_connections(map)) {
       return FAILURE;
+    }
+    if(generate_map_mesh(map)) {
+        return FAILURE;
+    }
+    if (map_cache_save(map)) {
+      TraceLog(LOG_WARNING, "Failed to save map cache for %s", map->name);
+    }
   }
   map_apply_textures(assets, map);
   return SUCCESS;
 }
+Result map_prepare_prefab (const Assets * assets, Map * map) {
+    if (map->prepared)
+        return SUCCESS;
+    if (map->loaded == false) {
+        TraceLog(LOG_ERROR, "Map %s has to be loaded before it can be prepared", map->name);
+        return FAILURE;
+    }
+
+    // the loaded map stays untouched until preparation succeeds so a broken map fails the same way every time
+    Map prepared;
+    if (map_clone(&prepared, map)) {
+        return FAILURE;
+    }
+    if (map_prepare_to_play(assets, &prepared)) {
+        map_deinit(&prepared);
+        return FAILURE;
+    }
+    map_deinit(map);
+    *map = prepared;
+    map->prepared = true;
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        map->regions.items[r].map = map;
+        map->regions.items[r].nav_graph.global = &map->nav_grid;
+    }
+    for (usize p = 0; p < map->paths.len; p++) {
+        map->paths.items[p].map = map;
+        map->paths.items[p].nav_graph.global = &map->nav_grid;
+    }
+    return SUCCESS;
+}
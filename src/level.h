@@ -8,7 +8,7 @@
 Test      line_intersects     (Line a, Line b);
 Result    line_intersection   (Line a, Line b, Vector2 * out_result);
 usize     lines_intersections (const ListLine lines, const Line line, ListVector2 * result);
-Rectangle line_bounds         (const Line line);
+Rectangle get_line_bounds     (const Line line);
 Result    lines_bounds        (const ListLine * lines, Rectangle * result);
 Test      lines_check_hit     (const ListLine * lines, Vector2 point, float distance);
 void      bevel_lines         (ListLine *lines, usize resolution, float depth, bool enclosed);
@@ -30,28 +30,38 @@ usize     building_cost_to_spawn    (const Building * building);
 usize     building_generated_income (const Building * building);
 float     building_trigger_interval (const Building * building);
 usize     building_max_units        (const Building * building);
-Texture2D building_image            (const Assets * assets, FactionType faction, BuildingType building, usize level);
+Sprite    building_image            (const Assets * assets, FactionType faction, BuildingType building, usize level);
 
 Building   * get_building_by_position (const Map * map, Vector2 position, float range);
 const char * building_name            (BuildingType building, FactionType faction, usize upgrade);
 
 /* Path Functions ************************************************************/
-Result path_by_position (const Map * map, Vector2 position, Path ** result);
+Result path_by_position  (const Map * map, Vector2 position, Path ** result);
+Result path_link_regions (Path * path);
 
 /* Region Functions ********************************************************/
 void     region_reset_unit_pathfinding (Region * region);
 void     region_change_ownership       (GameState * state, Region * region, usize player_id);
 Region * region_by_unit                (const Unit * guardian);
 Result   region_by_position            (const Map * map, Vector2 position, Region ** result);
+/// Path leading out of the region with its end within range of the position
+Path   * region_path_by_position       (const Region * region, Vector2 position, float range);
+Vector2  path_end_in_region            (const Path * path, const Region * region);
+Result   region_connect_objects        (Region * region);
 
 /* Map Functions *********************************************************/
-void     map_clamp           (Map * map);
-Result   map_clone           (Map * dst, const Map * src);
-Result   map_prepare_to_play (const Assets * assets, Map * map);
-void     map_deinit          (Map * map);
-void     render_map          (Map * map);
-void     render_map_mesh     (const GameState * state);
-Region * map_get_region_at   (const Map * map, Vector2 point);
+void     map_clamp            (Map * map);
+void     map_subdivide_paths  (Map * map);
+Result   map_make_connections (Map * map);
+Result   map_clone            (Map * dst, const Map * src);
+Result   map_instantiate      (Map * dst, const Map * prefab);
+Result   map_prepare_to_play  (const Assets * assets, Map * map);
+Result   map_prepare_prefab   (const Assets * assets, Map * map);
+void     map_deinit           (Map * map);
+void     render_map           (Map * map);
+void     render_map_mesh      (GameState * state);
+void     world_layer_unload   (WorldLayer * layer);
+Region * map_get_region_at    (const Map * map, Vector2 point);
 
 float get_expected_income           (const Map * map, usize player);
 float get_expected_maintenance_cost (const Map * map, usize player);
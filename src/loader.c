@@ -0,0 +1,344 @@
+#include "loader.h"
+#include "constants.h"
+#include "assets.h"
+#include "std.h"
+#include "alloc.h"
+#include <pthread.h>
+
+typedef enum {
+    LOAD_JOB_TEXTURE,
+    LOAD_JOB_MUSIC,
+    LOAD_JOB_SOUND,
+    LOAD_JOB_MAP,
+} LoadJobKind;
+
+typedef struct {
+    LoadJobKind   kind;
+    LoadStage     stage;
+    Test          required;
+    char        * path;
+    void        * target;
+    int           tag;
+
+    // filled in by the worker
+    Result        result;
+    Image         image;
+    Wave          wave;
+    Map           map;
+    const uchar * data;
+    int           len;
+} LoadJob;
+
+typedef struct {
+    LoadJob ** items;
+    usize      len;
+    usize      cap;
+} LoadQueue;
+
+typedef struct {
+    pthread_t       workers[LOADER_WORKERS + 1];
+    usize           worker_count;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    bool            running;
+    bool            quit;
+    // guarded by the lock
+    LoadQueue       pending;
+    LoadQueue       finished;
+    // main thread only
+    usize           queued[LOAD_STAGE_COUNT];
+    usize           completed[LOAD_STAGE_COUNT];
+    bool            failed;
+} Loader;
+
+Loader loader = {0};
+
+/* Queue *********************************************************************/
+Result load_queue_reserve (LoadQueue * queue, usize count) {
+    if (count <= queue->cap) return SUCCESS;
+    usize cap = queue->cap ? queue->cap * 2 : 64;
+    while (cap < count) cap *= 2;
+    LoadJob ** items = MemRealloc(queue->items, sizeof(LoadJob *) * cap);
+    if (items == NULL) return FAILURE;
+    queue->items = items;
+    queue->cap = cap;
+    return SUCCESS;
+}
+Result load_queue_push (LoadQueue * queue, LoadJob * job) {
+    if (load_queue_reserve(queue, queue->len + 1)) return FAILURE;
+    queue->items[queue->len ++] = job;
+    return SUCCESS;
+}
+LoadJob * load_queue_take (LoadQueue * queue) {
+    if (queue->len == 0) return NULL;
+    // earlier stages go first, within a stage jobs keep their queueing order
+    usize best = 0;
+    for (usize i = 1; i < queue->len; i++) {
+        if (queue->items[i]->stage < queue->items[best]->stage) best = i;
+    }
+    LoadJob * job = queue->items[best];
+    queue->len --;
+    copy_memory(&queue->items[best], &queue->items[best + 1], sizeof(LoadJob *) * (queue->len - best));
+    return job;
+}
+
+/* Jobs **********************************************************************/
+void load_job_free (LoadJob * job) {
+    MemFree(job->path);
+    MemFree(job);
+}
+void load_job_discard (LoadJob * job) {
+    if (job->result == SUCCESS) {
+        switch (job->kind) {
+            case LOAD_JOB_TEXTURE: unload_image(job->image, job->data); break;
+            case LOAD_JOB_SOUND: UnloadWave(job->wave); break;
+            case LOAD_JOB_MUSIC: unload_asset(job->data); break;
+            case LOAD_JOB_MAP: {
+                MemFree(job->map.name);
+                MemFree(job->map.path);
+                map_deinit(&job->map);
+            } break;
+        }
+    }
+    load_job_free(job);
+}
+// only cpu side work, runs on worker threads
+void load_job_run (LoadJob * job) {
+    job->result = FAILURE;
+    switch (job->kind) {
+        case LOAD_JOB_TEXTURE: {
+            job->image = load_image(job->path, &job->data);
+            if (job->image.data) job->result = SUCCESS;
+        } break;
+        case LOAD_JOB_SOUND: {
+            job->wave = load_wave(job->path);
+            if (job->wave.frameCount) job->result = SUCCESS;
+        } break;
+        case LOAD_JOB_MUSIC: {
+            job->data = load_asset(job->path, &job->len);
+            if (job->data && job->len > 0) job->result = SUCCESS;
+        } break;
+        case LOAD_JOB_MAP: {
+            job->result = load_level_info(&job->map, job->path);
+        } break;
+    }
+}
+Result load_job_insert_map (ListMap * maps, Map map) {
+    if (listMapAppend(maps, map)) return FAILURE;
+    usize i = maps->len - 1;
+    while (i > 0 && strcmp(maps->items[i - 1].path, map.path) > 0) {
+        maps->items[i] = maps->items[i - 1];
+        i --;
+    }
+    maps->items[i] = map;
+    return SUCCESS;
+}
+// gpu and audio device work, runs on the main thread
+Result load_job_finish (LoadJob * job) {
+    if (job->result) {
+        TraceLog(LOG_ERROR, "Failed to load %s", job->path);
+        return FAILURE;
+    }
+    switch (job->kind) {
+        case LOAD_JOB_TEXTURE: {
+            Texture2D * texture = job->target;
+            *texture = LoadTextureFromImage(job->image);
+            unload_image(job->image, job->data);
+            if (texture->id == 0) {
+                TraceLog(LOG_ERROR, "Failed to upload texture %s", job->path);
+                return FAILURE;
+            }
+        } break;
+        case LOAD_JOB_SOUND: {
+            Sound sound = LoadSoundFromWave(job->wave);
+            UnloadWave(job->wave);
+            if (sound.frameCount == 0) {
+                TraceLog(LOG_ERROR, "Failed to create sound from %s", job->path);
+                return FAILURE;
+            }
+            SoundEffect effect = { job->tag, sound };
+            if (listSFXAppend(job->target, effect)) {
+                TraceLog(LOG_ERROR, "Failed to add sound effect %s", job->path);
+                UnloadSound(sound);
+                return FAILURE;
+            }
+        } break;
+        case LOAD_JOB_MUSIC: {
+            Music * music = job->target;
+            // module music is fully decoded into its own memory so the file data can go right away
+            *music = LoadMusicStreamFromMemory(GetFileExtension(job->path), job->data, job->len);
+            unload_asset(job->data);
+            if (music->frameCount == 0) {
+                TraceLog(LOG_ERROR, "Failed to load music from %s", job->path);
+                return FAILURE;
+            }
+        } break;
+        case LOAD_JOB_MAP: {
+            if (load_job_insert_map(job->target, job->map)) {
+                TraceLog(LOG_ERROR, "Failed to allocate space for map %s", job->path);
+                MemFree(job->map.name);
+                MemFree(job->map.path);
+                map_deinit(&job->map);
+                return FAILURE;
+            }
+            TraceLog(LOG_INFO, "Loaded map file: %s", job->path);
+        } break;
+    }
+    return SUCCESS;
+}
+
+/* Workers *******************************************************************/
+void * loader_worker (void * arg) {
+    (void)arg;
+    pthread_mutex_lock(&loader.lock);
+    while (true) {
+        while (loader.quit == false && loader.pending.len == 0) {
+            pthread_cond_wait(&loader.wake, &loader.lock);
+        }
+        if (loader.quit) break;
+
+        LoadJob * job = load_queue_take(&loader.pending);
+        pthread_mutex_unlock(&loader.lock);
+        load_job_run(job);
+        pthread_mutex_lock(&loader.lock);
+        // space is reserved when queueing so finished jobs can't get lost here
+        loader.finished.items[loader.finished.len ++] = job;
+    }
+    pthread_mutex_unlock(&loader.lock);
+    return NULL;
+}
+Result loader_init () {
+    clear_memory(&loader, sizeof(Loader));
+    if (pthread_mutex_init(&loader.lock, NULL)) return FAILURE;
+    if (pthread_cond_init(&loader.wake, NULL)) {
+        pthread_mutex_destroy(&loader.lock);
+        return FAILURE;
+    }
+    for (usize i = 0; i < LOADER_WORKERS; i++) {
+        if (pthread_create(&loader.workers[i], NULL, loader_worker, NULL)) {
+            TraceLog(LOG_WARNING, "Failed to start asset loading thread, %zu running", loader.worker_count);
+            break;
+        }
+        loader.worker_count ++;
+    }
+    loader.running = true;
+    return SUCCESS;
+}
+void loader_deinit () {
+    if (loader.running == false) return;
+    pthread_mutex_lock(&loader.lock);
+    loader.quit = true;
+    pthread_cond_broadcast(&loader.wake);
+    pthread_mutex_unlock(&loader.lock);
+    for (usize i = 0; i < loader.worker_count; i++) {
+        pthread_join(loader.workers[i], NULL);
+    }
+
+    for (usize i = 0; i < loader.pending.len; i++) {
+        load_job_free(loader.pending.items[i]);
+    }
+    for (usize i = 0; i < loader.finished.len; i++) {
+        load_job_discard(loader.finished.items[i]);
+    }
+    MemFree(loader.pending.items);
+    MemFree(loader.finished.items);
+    pthread_cond_destroy(&loader.wake);
+    pthread_mutex_destroy(&loader.lock);
+    clear_memory(&loader, sizeof(Loader));
+}
+
+/* Queueing ******************************************************************/
+Result loader_queue (LoadJobKind kind, const char * path, void * target, int tag, LoadStage stage, Test required) {
+    LoadJob * job = MemAlloc(sizeof(LoadJob));
+    if (job == NULL) return FAILURE;
+    usize path_len = string_length(path);
+    job->path = MemAlloc(path_len + 1);
+    if (job->path == NULL) {
+        MemFree(job);
+        return FAILURE;
+    }
+    copy_memory(job->path, path, path_len + 1);
+    job->kind = kind;
+    job->stage = stage;
+    job->required = required;
+    job->target = target;
+    job->tag = tag;
+
+    usize outstanding = 1;
+    for (usize i = 0; i < LOAD_STAGE_COUNT; i++) {
+        outstanding += loader.queued[i] - loader.completed[i];
+    }
+
+    pthread_mutex_lock(&loader.lock);
+    Result result = load_queue_reserve(&loader.finished, outstanding);
+    if (result == SUCCESS) result = load_queue_push(&loader.pending, job);
+    if (result == SUCCESS) pthread_cond_signal(&loader.wake);
+    pthread_mutex_unlock(&loader.lock);
+
+    if (result) {
+        load_job_free(job);
+        return FAILURE;
+    }
+    loader.queued[stage] ++;
+    return SUCCESS;
+}
+Result load_texture_async (const char * path, Texture2D * target, LoadStage stage, Test required) {
+    return loader_queue(LOAD_JOB_TEXTURE, path, target, 0, stage, required);
+}
+Result load_music_async (const char * path, Music * target, LoadStage stage, Test required) {
+    return loader_queue(LOAD_JOB_MUSIC, path, target, 0, stage, required);
+}
+Result load_sound_async (const char * path, ListSFX * target, SoundEffectType kind, LoadStage stage) {
+    return loader_queue(LOAD_JOB_SOUND, path, target, kind, stage, NO);
+}
+Result load_map_async (const char * path, ListMap * target, LoadStage stage) {
+    return loader_queue(LOAD_JOB_MAP, path, target, 0, stage, NO);
+}
+
+/* Progress ******************************************************************/
+Result loader_update () {
+    double start = GetTime();
+    do {
+        LoadJob * job = NULL;
+        pthread_mutex_lock(&loader.lock);
+        if (loader.finished.len) {
+            job = loader.finished.items[0];
+            loader.finished.len --;
+            copy_memory(&loader.finished.items[0], &loader.finished.items[1], sizeof(LoadJob *) * loader.finished.len);
+        }
+        else if (loader.worker_count == 0) {
+            job = load_queue_take(&loader.pending);
+        }
+        pthread_mutex_unlock(&loader.lock);
+
+        if (job == NULL) break;
+        if (loader.worker_count == 0) load_job_run(job);
+
+        if (load_job_finish(job) && job->required) {
+            loader.failed = true;
+        }
+        loader.completed[job->stage] ++;
+        load_job_free(job);
+    } while (GetTime() - start < LOADER_FRAME_BUDGET);
+
+    return loader.failed ? FAILURE : SUCCESS;
+}
+float loader_progress (LoadStage stage) {
+    usize queued = 0;
+    usize completed = 0;
+    for (usize i = 0; i <= stage; i++) {
+        queued += loader.queued[i];
+        completed += loader.completed[i];
+    }
+    if (queued == 0) return 1.0f;
+    return (float)completed / (float)queued;
+}
+Test loader_finished (LoadStage stage) {
+    for (usize i = 0; i <= stage; i++) {
+        if (loader.completed[i] < loader.queued[i]) return NO;
+    }
+    return YES;
+}
+Test loader_failed () {
+    return loader.failed ? YES : NO;
+}
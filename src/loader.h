@@ -0,0 +1,41 @@
+#ifndef LOADER_H_
+#define LOADER_H_
+
+#include <raylib.h>
+#include "types.h"
+
+/// Order in which assets are loaded, earlier stages are always picked up by workers first
+typedef enum {
+    // needed before the main menu can show up
+    LOAD_STAGE_STARTUP = 0,
+    // needed only once the game starts, streamed in while the menu is open
+    LOAD_STAGE_BACKGROUND,
+    LOAD_STAGE_COUNT,
+} LoadStage;
+
+/* Lifetime ******************************************************************/
+Result loader_init   ();
+/// Stops workers and drops anything that didn't make it to the main thread yet
+void   loader_deinit ();
+
+/* Queueing ******************************************************************/
+/// File reading and decoding happens on worker threads, gpu and audio device work is done by loader_update
+/// Paths are copied so they can come from temporary memory
+/// Failing required assets make the loader report failure, others only log it and leave the target empty
+Result load_texture_async (const char * path, Texture2D * target, LoadStage stage, Test required);
+Result load_music_async   (const char * path, Music * target, LoadStage stage, Test required);
+/// Sound is appended to the list under the given kind once loaded
+Result load_sound_async   (const char * path, ListSFX * target, SoundEffectType kind, LoadStage stage);
+/// Map info is inserted into the list sorted by path once loaded, maps failing to load are skipped
+Result load_map_async     (const char * path, ListMap * target, LoadStage stage);
+
+/* Progress ******************************************************************/
+/// Hands finished assets over to gpu and audio device for a fraction of a frame
+/// Needs to be called regularly from the main thread for loading to progress
+Result loader_update   ();
+/// Fraction of assets from the stage and stages before it that are ready to use
+float  loader_progress (LoadStage stage);
+Test   loader_finished (LoadStage stage);
+Test   loader_failed   ();
+
+#endif // LOADER_H_
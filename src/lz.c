@@ -0,0 +1,132 @@
+#include "lz.h"
+#include "std.h"
+#include "alloc.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 0xFFFF
+#define LZ_HASH_BITS 14
+// matches can't reach into last bytes so the block always ends with literals
+#define LZ_END_LITERALS 5
+
+/* Compression ***************************************************************/
+uint32_t lz_read_u32 (const uchar * data) {
+    uint32_t value;
+    copy_memory(&value, data, sizeof(uint32_t));
+    return value;
+}
+uint32_t lz_hash (uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+Result lz_write_length (ListUchar * out, usize length) {
+    uchar byte = 255;
+    while (length >= 255) {
+        if (write_bytes(out, &byte, 1)) return FAILURE;
+        length -= 255;
+    }
+    byte = length;
+    return write_bytes(out, &byte, 1);
+}
+Result lz_write_sequence (ListUchar * out, const uchar * literals, usize literal_len, usize offset, usize match_len) {
+    uchar token = (literal_len >= 15 ? 15 : literal_len) << 4;
+    if (offset) {
+        usize extra = match_len - LZ_MIN_MATCH;
+        token |= extra >= 15 ? 15 : extra;
+    }
+    if (write_bytes(out, &token, 1)) return FAILURE;
+    if (literal_len >= 15 && lz_write_length(out, literal_len - 15)) return FAILURE;
+    if (write_bytes(out, literals, literal_len)) return FAILURE;
+    if (offset == 0) return SUCCESS;
+
+    uchar offset_bytes[2] = { offset & 0xFF, offset >> 8 };
+    if (write_bytes(out, offset_bytes, 2)) return FAILURE;
+    if (match_len - LZ_MIN_MATCH >= 15 && lz_write_length(out, match_len - LZ_MIN_MATCH - 15)) return FAILURE;
+    return SUCCESS;
+}
+Result lz_compress (const uchar * data, usize len, ListUchar * out) {
+    uint32_t * table = MemAlloc(sizeof(uint32_t) * (1 << LZ_HASH_BITS));
+    if (table == NULL) return FAILURE;
+
+    usize anchor = 0;
+    usize cursor = 0;
+    usize match_limit = len > LZ_END_LITERALS + LZ_MIN_MATCH ? len - LZ_END_LITERALS - LZ_MIN_MATCH : 0;
+
+    // table stores position + 1 so zeroed entries are empty
+    while (cursor < match_limit) {
+        uint32_t sequence = lz_read_u32(&data[cursor]);
+        uint32_t hash = lz_hash(sequence);
+        usize candidate = table[hash];
+        table[hash] = cursor + 1;
+
+        if (candidate == 0 || cursor - (candidate - 1) > LZ_MAX_OFFSET || lz_read_u32(&data[candidate - 1]) != sequence) {
+            cursor ++;
+            continue;
+        }
+        candidate --;
+
+        usize match_len = LZ_MIN_MATCH;
+        usize match_end = len - LZ_END_LITERALS;
+        while (cursor + match_len < match_end && data[candidate + match_len] == data[cursor + match_len]) {
+            match_len ++;
+        }
+
+        if (lz_write_sequence(out, &data[anchor], cursor - anchor, cursor - candidate, match_len)) goto fail;
+        cursor += match_len;
+        anchor = cursor;
+    }
+
+    if (lz_write_sequence(out, &data[anchor], len - anchor, 0, 0)) goto fail;
+    MemFree(table);
+    return SUCCESS;
+
+    fail:
+    MemFree(table);
+    return FAILURE;
+}
+
+/* Decompression *************************************************************/
+Result lz_read_length (const uchar * data, usize len, usize * cursor, usize * length) {
+    uchar byte;
+    do {
+        if (*cursor >= len) return FAILURE;
+        byte = data[(*cursor)++];
+        *length += byte;
+    } while (byte == 255);
+    return SUCCESS;
+}
+Result lz_decompress (const uchar * data, usize len, uchar * out, usize out_len) {
+    usize cursor = 0;
+    usize written = 0;
+
+    while (cursor < len) {
+        uchar token = data[cursor++];
+
+        usize literal_len = token >> 4;
+        if (literal_len == 15 && lz_read_length(data, len, &cursor, &literal_len)) return FAILURE;
+        if (literal_len > len - cursor || literal_len > out_len - written) return FAILURE;
+        copy_memory(&out[written], &data[cursor], literal_len);
+        cursor += literal_len;
+        written += literal_len;
+
+        // last sequence has no match
+        if (cursor == len) break;
+
+        if (len - cursor < 2) return FAILURE;
+        usize offset = data[cursor] | (data[cursor + 1] << 8);
+        cursor += 2;
+        if (offset == 0 || offset > written) return FAILURE;
+
+        usize match_len = token & 15;
+        if (match_len == 15 && lz_read_length(data, len, &cursor, &match_len)) return FAILURE;
+        match_len += LZ_MIN_MATCH;
+        if (match_len > out_len - written) return FAILURE;
+
+        // matches can overlap their own output so they're copied byte by byte
+        const uchar * from = &out[written - offset];
+        for (usize i = 0; i < match_len; i++) {
+            out[written + i] = from[i];
+        }
+        written += match_len;
+    }
+
+    return written == out_len ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,13 @@
+#ifndef LZ_H_
+#define LZ_H_
+
+#include "types.h"
+
+/// Byte oriented LZ77 codec laid out like an LZ4 block:
+/// token with literal and match length nibbles, literals, 16 bit match offset
+/// Compression is done offline by the asset packer, the game only decompresses
+Result lz_compress   (const uchar * data, usize len, ListUchar * out);
+/// Output size has to be known upfront, fails on damaged data or size mismatch
+Result lz_decompress (const uchar * data, usize len, uchar * out, usize out_len);
+
+#endif // LZ_H_
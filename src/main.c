@@ -16,6 +16,13 @@
 #include "unit_pool.h"
 #include "input.h"
 #include "manual.h"
+#include "loader.h"
+#include "sprite.h"
+#include "music.h"
+#include "ui_cache.h"
+#include "quality.h"
+#include "profiler.h"
+#include "nav_stats.h"
 
 #if defined(ANDROID)
 const int WINDOW_WIDTH = 0;
@@ -53,8 +60,6 @@ ExecutionMode level_select (Assets * assets, GameState * game) {
         BeginDrawing();
         draw_title(&game->settings->theme);
 
-        UpdateMusicStream(assets->main_theme);
-
         Rectangle screen = cake_rect(GetScreenWidth(), GetScreenHeight());
         screen = cake_margin_all(screen, 20);
         Rectangle map_list = cake_cut_vertical(&screen, 0.3f, 10);
@@ -70,15 +75,20 @@ ExecutionMode level_select (Assets * assets, GameState * game) {
             int sel = render_map_list(map_list, &assets->maps, 0, assets->maps.len, theme);
             if (sel >= 0) {
                 play_sound(assets, SOUND_UI_CLICK);
-                selected_map = sel;
+                if (load_level_geometry(&assets->maps, &assets->maps.items[sel])) {
+                    TraceLog(LOG_ERROR, "Failed to load map %s", assets->maps.items[sel].name);
+                }
+                else {
+                    selected_map = sel;
+                }
             }
         }
         else {
             // TODO make a scroll bar
         }
 
-        float cancel_width = MeasureText("Cancel", theme->font_size) + theme->frame_thickness * 2 + theme->margin * 2;
-        float start_width = MeasureText("Start", theme->font_size) + theme->frame_thickness * 2 + theme->margin * 2;
+        float cancel_width = measure_text("Cancel", theme->font_size) + theme->frame_thickness * 2 + theme->margin * 2;
+        float start_width = measure_text("Start", theme->font_size) + theme->frame_thickness * 2 + theme->margin * 2;
 
         #if defined(ANDROID)
         Rectangle buttons = cake_cut_vertical(&map_preview, (cancel_width > start_width) ? -cancel_width : -start_width, 20);
@@ -126,6 +136,8 @@ ExecutionMode level_select (Assets * assets, GameState * game) {
         case 1: next = EXE_MODE_MAIN_MENU; break;
         case 2: {
             if (game_state_prepare (game, &assets->maps.items[selected_map])) {
+                // map selection sets the players up again
+                listPlayerDataDeinit(&game->players);
                 next = EXE_MODE_SINGLE_PLAYER_MAP_SELECT;
                 break;
             }
@@ -146,8 +158,7 @@ ExecutionMode play_mode (GameState * game) {
         player = 1;
     }
 
-    Music theme = game->resources->faction_themes[game->players.items[player].faction];
-    PlayMusicStream(theme);
+    music_play(game->resources->faction_themes[game->players.items[player].faction], MUSIC_CROSSFADE);
     InfoBarAction play_state = INFO_BAR_ACTION_NONE;
     usize winner = 0;
     while (play_state != INFO_BAR_ACTION_QUIT) {
@@ -155,22 +166,29 @@ ExecutionMode play_mode (GameState * game) {
             break;
         }
         BeginDrawing();
+        double frame_start = GetTime();
+        sprite_stats_frame();
         draw_title(&game->settings->theme);
 
-        UpdateMusicStream(theme);
+        float tick_time = 0.0f;
         if (play_state == INFO_BAR_ACTION_NONE) {
+            double tick_start = GetTime();
             game_tick(game);
+            tick_time = GetTime() - tick_start;
             winner = game_winner(game);
         }
 
         BeginMode2D(game->camera);
+            PROFILE_BEGIN("render");
             if (play_state == INFO_BAR_ACTION_NONE) {
-                render_interaction_hints(game);
+                PROFILE_BEGIN("hints"); render_interaction_hints(game); PROFILE_END();
             }
-            render_map_mesh(game);
-            render_units(game);
-            particles_render(game->particles_in_use.items, game->particles_in_use.len);
+            PROFILE_BEGIN("map");          render_map_mesh(game);  PROFILE_END();
+            PROFILE_BEGIN("render units"); render_units(game);     PROFILE_END();
+            PROFILE_BEGIN("particles");    particles_render(game); PROFILE_END();
+            PROFILE_END();
         EndMode2D();
+        PROFILE_BEGIN("ui");
 
         #if defined(ANDROID)
         if (play_state == INFO_BAR_ACTION_NONE) {
@@ -234,11 +252,21 @@ ExecutionMode play_mode (GameState * game) {
                 }
             } break;
         }
-        EndDrawing();
+        PROFILE_END();
+        quality_update(&game->quality, GetTime() - frame_start, tick_time, GetFrameTime());
+        #if !defined(RELEASE)
+        render_sprite_stats(&game->settings->theme);
+        render_quality_stats(&game->settings->theme, &game->quality);
+        nav_stats_render(&game->settings->theme);
+        #endif
+        #if defined(PROFILER)
+        profiler_render(&game->settings->theme);
+        #endif
+        PROFILE_BEGIN("present"); EndDrawing(); PROFILE_END();
+        PROFILE_FRAME();
         temp_reset();
     }
     game_state_deinit(game);
-    StopMusicStream(theme);
     return EXE_MODE_MAIN_MENU;
 }
 ExecutionMode main_menu (Assets * assets, Settings * settings) {
@@ -251,7 +279,7 @@ ExecutionMode main_menu (Assets * assets, Settings * settings) {
             mode = EXE_MODE_EXIT;
             break;
         }
-        UpdateMusicStream(assets->main_theme);
+        loader_update();
         BeginDrawing();
         draw_title(&settings->theme);
 
@@ -336,6 +364,35 @@ ExecutionMode main_menu (Assets * assets, Settings * settings) {
     return mode;
 }
 
+Result loading_screen (LoadStage stage) {
+    while (loader_finished(stage) == NO) {
+        if (WindowShouldClose()) {
+            return FAILURE;
+        }
+        if (loader_update()) {
+            return FAILURE;
+        }
+
+        BeginDrawing();
+        ClearBackground(black);
+        Rectangle rect = (Rectangle) { 0, 0, GetScreenWidth(), GetScreenHeight() };
+        rect = cake_diet_by(rect, 0.5f);
+        rect = cake_squish_by(rect, 0.5f);
+        DrawRectangleRec(rect, bg_color);
+
+        Rectangle bar = { rect.x + rect.width * 0.1f, rect.y + rect.height * 0.7f, rect.width * 0.8f, 10 };
+        DrawRectangleRec(bar, black);
+        bar.width *= loader_progress(stage);
+        DrawRectangleRec(bar, tx_color);
+
+        char * loading = "Loading...";
+        float len = measure_text(loading, 30);
+        rect = cake_carve_to(rect, len, 30);
+        DrawText(loading, rect.x, rect.y, 30, tx_color);
+        EndDrawing();
+    }
+    return loader_failed() ? FAILURE : SUCCESS;
+}
 int main(void) {
     int result = 0;
     #if defined(RELEASE)
@@ -356,19 +413,7 @@ int main(void) {
     SetExitKey(KEY_F1);
     #endif
 
-    {
-        BeginDrawing();
-        ClearBackground(black);
-        Rectangle rect = (Rectangle) { 0, 0, GetScreenWidth(), GetScreenHeight() };
-        rect = cake_diet_by(rect, 0.5f);
-        rect = cake_squish_by(rect, 0.5f);
-        DrawRectangleRec(rect, bg_color);
-        char * loading = "Loading...";
-        float len = MeasureText(loading, 30);
-        rect = cake_carve_to(rect, len, 30);
-        DrawText(loading, rect.x, rect.y, 30, tx_color);
-        EndDrawing();
-    }
+    SetTargetFPS(FPS);
 
     Assets game_assets = {0};
     GameState game_state = {0};
@@ -377,6 +422,18 @@ int main(void) {
     game_assets.maps = listMapInit(6, perm_allocator());
     ExecutionMode mode = EXE_MODE_MAIN_MENU;
 
+    if (loader_init()) {
+        TraceLog(LOG_FATAL, "Failed to start asset loader");
+        goto close;
+    }
+    if (music_init()) {
+        TraceLog(LOG_FATAL, "Failed to start music player");
+        goto close;
+    }
+    if (load_asset_archive()) {
+        TraceLog(LOG_FATAL, "Failed to open asset archive");
+        goto close;
+    }
     if (load_levels(&game_assets.maps)) {
         TraceLog(LOG_FATAL, "Failed to load levels");
         goto close;
@@ -401,6 +458,18 @@ int main(void) {
         TraceLog(LOG_FATAL, "Failed to load animations");
         goto close;
     }
+    if (load_sprite_atlas_pages(&game_assets)) {
+        TraceLog(LOG_FATAL, "Failed to load sprite atlases");
+        goto close;
+    }
+    if (loading_screen(LOAD_STAGE_STARTUP)) {
+        TraceLog(LOG_FATAL, "Failed to load assets");
+        goto close;
+    }
+    if (game_assets.maps.len == 0) {
+        TraceLog(LOG_FATAL, "Failed to load any map successfully");
+        goto close;
+    }
     game_settings.theme.assets = &game_assets.ui;
 
     apply_sound_settings(&game_assets, &game_settings);
@@ -415,8 +484,7 @@ int main(void) {
     #endif
     unit_pool_init();
 
-    SetTargetFPS(FPS);
-    PlayMusicStream(game_assets.main_theme);
+    music_play(game_assets.main_theme, 0.0f);
     while (mode != EXE_MODE_EXIT) {
         if (WindowShouldClose()) {
             break;
@@ -424,12 +492,19 @@ int main(void) {
 
         game_state.resources = &game_assets;
         game_state.settings = &game_settings;
+        if (mode == EXE_MODE_SINGLE_PLAYER_MAP_SELECT || mode == EXE_MODE_TUTORIAL || mode == EXE_MODE_IN_GAME) {
+            // game assets keep loading while the menu is open, anything left is awaited here
+            if (loading_screen(LOAD_STAGE_BACKGROUND)) {
+                TraceLog(LOG_FATAL, "Failed to load assets");
+                break;
+            }
+            apply_sound_settings(&game_assets, &game_settings);
+        }
         switch (mode) {
             case EXE_MODE_IN_GAME: {
-                StopMusicStream(game_assets.main_theme);
                 mode = play_mode(&game_state);
                 if (EXE_MODE_MAIN_MENU == mode || EXE_MODE_SINGLE_PLAYER_MAP_SELECT == mode) {
-                    PlayMusicStream(game_assets.main_theme);
+                    music_play(game_assets.main_theme, MUSIC_CROSSFADE);
                 }
             } break;
             case EXE_MODE_MAIN_MENU: {
@@ -451,6 +526,8 @@ int main(void) {
     }
 
     close:
+    music_deinit();
+    loader_deinit();
     CloseAudioDevice();
     save_settings(&game_settings);
     unit_pool_deinit();
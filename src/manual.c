@@ -2,6 +2,8 @@
 #include "cake.h"
 #include "ui.h"
 #include "audio.h"
+#include "loader.h"
+#include "ui_cache.h"
 
 // What is this game?
 // How do you win?
@@ -136,7 +138,7 @@ const char * manual_credits_text =
 void manual_text (Rectangle area, const char * text, const Theme * theme) {
     draw_background(area, theme);
 
-    Vector2 text_area = MeasureTextEx(GetFontDefault(), text, theme->font_size, theme->font_size/10.0f);
+    Vector2 text_area = measure_text_size(text, theme->font_size);
     Rectangle back = {
         area.x + theme->frame_thickness + theme->margin,
         area.y + theme->frame_thickness + theme->margin,
@@ -160,6 +162,8 @@ typedef enum {
 } ManualPage;
 
 ManualPage selected_page = PAGE_INFO;
+// pages are static so they're drawn into the panel only when the page or the screen changes
+UiPanel page_panel = {0};
 const char * buttons[] = {
     [PAGE_INFO]     = "Game Information",
     [PAGE_CONTROLS] = "Controls",
@@ -184,14 +188,17 @@ ExecutionMode manual_mode (Assets * assets, const Theme * theme) {
         [PAGE_CREDITS]  = manual_credits_text,
     };
 
-    while (1) {
+    ExecutionMode mode = EXE_MODE_MANUAL;
+    while (mode == EXE_MODE_MANUAL) {
         if (WindowShouldClose()) {
-            return EXE_MODE_EXIT;
+            mode = EXE_MODE_EXIT;
+            break;
         }
         if (IsKeyPressed(KEY_ESCAPE)) {
-            return EXE_MODE_MAIN_MENU;
+            mode = EXE_MODE_MAIN_MENU;
+            break;
         }
-        UpdateMusicStream(assets->main_theme);
+        loader_update();
         BeginDrawing();
         draw_title(theme);
 
@@ -200,7 +207,17 @@ ExecutionMode manual_mode (Assets * assets, const Theme * theme) {
         menu = cake_margin_all(menu, theme->margin);
         screen = cake_margin_all(screen, theme->margin);
 
-        manual_text(screen, texts[selected_page], theme);
+        uint64_t key = ui_hash(0xcbf29ce484222325ULL, &selected_page, sizeof(selected_page));
+        key = ui_hash(key, &theme->font_size, sizeof(float));
+        key = ui_hash(key, &theme->margin, sizeof(float));
+        key = ui_hash(key, &theme->frame_thickness, sizeof(float));
+        key = ui_hash(key, &theme->assets->background_box.id, sizeof(unsigned int));
+        key = ui_hash(key, &theme->assets->button.id, sizeof(unsigned int));
+        if (ui_panel_begin(&page_panel, screen, key)) {
+            manual_text(screen, texts[selected_page], theme);
+            ui_panel_end(&page_panel);
+        }
+        ui_panel_draw(&page_panel);
 
         draw_background(menu, theme);
 
@@ -224,10 +241,11 @@ ExecutionMode manual_mode (Assets * assets, const Theme * theme) {
         draw_button(button, "Back", cursor, UI_LAYOUT_LEFT, theme);
         if (click && CheckCollisionPointRec(cursor, button)) {
             play_sound(assets, SOUND_UI_CLICK);
-            return EXE_MODE_MAIN_MENU;
+            mode = EXE_MODE_MAIN_MENU;
         }
         EndDrawing();
     }
 
-    return EXE_MODE_MAIN_MENU;
+    ui_panel_unload(&page_panel);
+    return mode;
 }
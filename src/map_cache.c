@@ -0,0 +1,419 @@
+#include "map_cache.h"
+#include "constants.h"
+#include "std.h"
+#include "alloc.h"
+#include "level.h"
+#include "pathfinding.h"
+#include "assets.h"
+#include <stdio.h>
+
+#define MAP_CACHE_MAGIC 0x434D4C4C
+// bump whenever map preparation produces different results
+#define MAP_CACHE_VERSION 2
+#define MAP_CACHE_NO_REGION 0xFFFFFFFF
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t hash;
+    uint32_t nav_grid_size;
+    uint32_t bevel;
+    float    path_thickness;
+    uint32_t region_count;
+    uint32_t path_count;
+} MapCacheHeader;
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset_x;
+    uint32_t offset_y;
+    const uchar * mask;
+} CachedGraph;
+
+typedef struct {
+    ListLine    lines;
+    CachedGraph graph;
+    Mesh        model;
+    Mesh        outline;
+} CachedRegion;
+
+typedef struct {
+    uint32_t    region_a;
+    uint32_t    region_b;
+    CachedGraph graph;
+    Mesh        model;
+} CachedPath;
+
+typedef struct {
+    CachedRegion * regions;
+    CachedPath   * paths;
+    usize          region_count;
+    usize          path_count;
+    Mesh           background;
+} CachedMap;
+
+/* Utilities *****************************************************************/
+char * map_cache_file (const Map * map) {
+    char name[64];
+    snprintf(name, 64, "map-%016llx.cache", (unsigned long long)map->hash);
+    return cache_path(name, &temp_alloc);
+}
+// stdio instead of raylib file functions, on android those remap the absolute cache path
+uchar * map_cache_load_file (const char * path, usize * len) {
+    FILE * file = fopen(path, "rb");
+    if (NULL == file) return NULL;
+    uchar * data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = MemAlloc(size);
+            if (data && fread(data, 1, size, file) != (usize)size) {
+                MemFree(data);
+                data = NULL;
+            }
+            *len = size;
+        }
+    }
+    fclose(file);
+    return data;
+}
+Result map_cache_save_file (const char * path, const ListUchar * buffer) {
+    FILE * file = fopen(path, "wb");
+    if (NULL == file) return FAILURE;
+    usize written = fwrite(buffer->items, 1, buffer->len, file);
+    if (fclose(file) != 0 || written != buffer->len) return FAILURE;
+    return SUCCESS;
+}
+MapCacheHeader map_cache_header (const Map * map) {
+    return (MapCacheHeader) {
+        .magic          = MAP_CACHE_MAGIC,
+        .version        = MAP_CACHE_VERSION,
+        .hash           = map->hash,
+        .nav_grid_size  = NAV_GRID_SIZE,
+        .bevel          = MAP_BEVEL,
+        .path_thickness = PATH_THICKNESS,
+        .region_count   = map->regions.len,
+        .path_count     = map->paths.len,
+    };
+}
+// field by field so struct padding never ends up in the file
+Result map_cache_write_header (ListUchar * buffer, const MapCacheHeader * header) {
+    if (write_bytes(buffer, &header->magic, sizeof(uint32_t))) return FAILURE;
+    if (write_bytes(buffer, &header->version, sizeof(uint32_t))) return FAILURE;
+    if (write_bytes(buffer, &header->hash, sizeof(uint64_t))) return FAILURE;
+    if (write_bytes(buffer, &header->nav_grid_size, sizeof(uint32_t))) return FAILURE;
+    if (write_bytes(buffer, &header->bevel, sizeof(uint32_t))) return FAILURE;
+    if (write_bytes(buffer, &header->path_thickness, sizeof(float))) return FAILURE;
+    if (write_bytes(buffer, &header->region_count, sizeof(uint32_t))) return FAILURE;
+    if (write_bytes(buffer, &header->path_count, sizeof(uint32_t))) return FAILURE;
+    return SUCCESS;
+}
+Result map_cache_read_header (const uchar * data, usize len, usize * cursor, MapCacheHeader * header) {
+    if (read_bytes(data, len, cursor, &header->magic, sizeof(uint32_t))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->version, sizeof(uint32_t))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->hash, sizeof(uint64_t))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->nav_grid_size, sizeof(uint32_t))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->bevel, sizeof(uint32_t))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->path_thickness, sizeof(float))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->region_count, sizeof(uint32_t))) return FAILURE;
+    if (read_bytes(data, len, cursor, &header->path_count, sizeof(uint32_t))) return FAILURE;
+    return SUCCESS;
+}
+void mesh_release (Mesh * mesh) {
+    if (mesh->vertices)  MemFree(mesh->vertices);
+    if (mesh->texcoords) MemFree(mesh->texcoords);
+    if (mesh->indices)   MemFree(mesh->indices);
+    clear_memory(mesh, sizeof(Mesh));
+}
+void cached_map_deinit (CachedMap * cache) {
+    for (usize r = 0; r < cache->region_count; r++) {
+        listLineDeinit(&cache->regions[r].lines);
+        mesh_release(&cache->regions[r].model);
+        mesh_release(&cache->regions[r].outline);
+    }
+    for (usize p = 0; p < cache->path_count; p++) {
+        mesh_release(&cache->paths[p].model);
+    }
+    mesh_release(&cache->background);
+    if (cache->regions) MemFree(cache->regions);
+    if (cache->paths)   MemFree(cache->paths);
+    clear_memory(cache, sizeof(CachedMap));
+}
+
+/* Writing *******************************************************************/
+Result map_cache_write_graph (ListUchar * buffer, const NavGraph * graph) {
+    uint32_t dimensions[4] = { graph->width, graph->height, graph->offset_x, graph->offset_y };
+    if (write_bytes(buffer, dimensions, sizeof(dimensions))) return FAILURE;
+
+    for (usize i = 0; i < graph->width * graph->height; i++) {
+        uchar occupied = graph->waypoints.items[i] != NULL;
+        if (write_bytes(buffer, &occupied, sizeof(uchar))) return FAILURE;
+    }
+    return SUCCESS;
+}
+Result map_cache_write_mesh (ListUchar * buffer, const Model * model) {
+    if (model->meshCount < 1 || model->meshes == NULL) {
+        TraceLog(LOG_ERROR, "Tried to cache a model without a mesh");
+        return FAILURE;
+    }
+    const Mesh * mesh = &model->meshes[0];
+    uint32_t counts[3] = { mesh->vertexCount, mesh->triangleCount, mesh->indices != NULL };
+    if (write_bytes(buffer, counts, sizeof(counts))) return FAILURE;
+    if (write_bytes(buffer, mesh->vertices, sizeof(float) * 3 * mesh->vertexCount)) return FAILURE;
+    if (write_bytes(buffer, mesh->texcoords, sizeof(float) * 2 * mesh->vertexCount)) return FAILURE;
+    if (mesh->indices) {
+        if (write_bytes(buffer, mesh->indices, sizeof(ushort) * 3 * mesh->triangleCount)) return FAILURE;
+    }
+    return SUCCESS;
+}
+Result map_cache_write (ListUchar * buffer, const Map * map) {
+    MapCacheHeader header = map_cache_header(map);
+    if (map_cache_write_header(buffer, &header)) return FAILURE;
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        const Region * region = &map->regions.items[r];
+        uint32_t line_count = region->area.lines.len;
+        if (write_bytes(buffer, &line_count, sizeof(uint32_t))) return FAILURE;
+        if (write_bytes(buffer, region->area.lines.items, sizeof(Line) * line_count)) return FAILURE;
+        if (map_cache_write_graph(buffer, &region->nav_graph)) return FAILURE;
+        if (map_cache_write_mesh(buffer, &region->area.model)) return FAILURE;
+        if (map_cache_write_mesh(buffer, &region->area.outline)) return FAILURE;
+    }
+
+    for (usize p = 0; p < map->paths.len; p++) {
+        const Path * path = &map->paths.items[p];
+        uint32_t regions[2] = { MAP_CACHE_NO_REGION, MAP_CACHE_NO_REGION };
+        // paths that didn't connect to both regions are left without nav graph
+        if (path->region_a && path->region_b) {
+            regions[0] = path->region_a - map->regions.items;
+            regions[1] = path->region_b - map->regions.items;
+        }
+        if (write_bytes(buffer, regions, sizeof(regions))) return FAILURE;
+        if (regions[0] != MAP_CACHE_NO_REGION) {
+            if (map_cache_write_graph(buffer, &path->nav_graph)) return FAILURE;
+        }
+        if (map_cache_write_mesh(buffer, &path->model)) return FAILURE;
+    }
+
+    return map_cache_write_mesh(buffer, &map->background);
+}
+
+/* Reading *******************************************************************/
+Result map_cache_read_graph (const uchar * data, usize len, usize * cursor, CachedGraph * graph) {
+    uint32_t dimensions[4];
+    if (read_bytes(data, len, cursor, dimensions, sizeof(dimensions))) return FAILURE;
+    graph->width    = dimensions[0];
+    graph->height   = dimensions[1];
+    graph->offset_x = dimensions[2];
+    graph->offset_y = dimensions[3];
+
+    usize cells = (usize)graph->width * graph->height;
+    if (*cursor + cells > len) return FAILURE;
+    graph->mask = &data[*cursor];
+    *cursor += cells;
+    return SUCCESS;
+}
+Result map_cache_read_mesh (const uchar * data, usize len, usize * cursor, Mesh * mesh) {
+    uint32_t counts[3];
+    if (read_bytes(data, len, cursor, counts, sizeof(counts))) return FAILURE;
+    if (counts[0] == 0 || counts[1] == 0) return FAILURE;
+
+    mesh->vertexCount   = counts[0];
+    mesh->triangleCount = counts[1];
+    mesh->vertices  = MemAlloc(sizeof(float) * 3 * mesh->vertexCount);
+    mesh->texcoords = MemAlloc(sizeof(float) * 2 * mesh->vertexCount);
+    if (NULL == mesh->vertices || NULL == mesh->texcoords) return FAILURE;
+    if (read_bytes(data, len, cursor, mesh->vertices, sizeof(float) * 3 * mesh->vertexCount)) return FAILURE;
+    if (read_bytes(data, len, cursor, mesh->texcoords, sizeof(float) * 2 * mesh->vertexCount)) return FAILURE;
+
+    if (counts[2]) {
+        mesh->indices = MemAlloc(sizeof(ushort) * 3 * mesh->triangleCount);
+        if (NULL == mesh->indices) return FAILURE;
+        if (read_bytes(data, len, cursor, mesh->indices, sizeof(ushort) * 3 * mesh->triangleCount)) return FAILURE;
+    }
+    return SUCCESS;
+}
+Result map_cache_read (const uchar * data, usize len, const Map * map, CachedMap * cache) {
+    usize cursor = 0;
+    MapCacheHeader header;
+    MapCacheHeader expected = map_cache_header(map);
+    if (map_cache_read_header(data, len, &cursor, &header)) return FAILURE;
+    if (header.magic != expected.magic || header.version != expected.version || header.hash != expected.hash) return FAILURE;
+    if (header.nav_grid_size != expected.nav_grid_size || header.bevel != expected.bevel) return FAILURE;
+    if (header.path_thickness != expected.path_thickness) return FAILURE;
+    if (header.region_count != expected.region_count || header.path_count != expected.path_count) return FAILURE;
+
+    cache->regions = MemAlloc(sizeof(CachedRegion) * header.region_count);
+    cache->paths   = MemAlloc(sizeof(CachedPath) * header.path_count);
+    if (NULL == cache->regions || NULL == cache->paths) return FAILURE;
+    clear_memory(cache->regions, sizeof(CachedRegion) * header.region_count);
+    clear_memory(cache->paths, sizeof(CachedPath) * header.path_count);
+
+    for (usize r = 0; r < header.region_count; r++) {
+        CachedRegion * region = &cache->regions[r];
+        cache->region_count ++;
+
+        uint32_t line_count;
+        if (read_bytes(data, len, &cursor, &line_count, sizeof(uint32_t))) return FAILURE;
+        if (line_count < 3) return FAILURE;
+        region->lines = listLineInit(line_count, perm_allocator());
+        if (NULL == region->lines.items) return FAILURE;
+        if (read_bytes(data, len, &cursor, region->lines.items, sizeof(Line) * line_count)) return FAILURE;
+        region->lines.len = line_count;
+
+        if (map_cache_read_graph(data, len, &cursor, &region->graph)) return FAILURE;
+        if (map_cache_read_mesh(data, len, &cursor, &region->model)) return FAILURE;
+        if (map_cache_read_mesh(data, len, &cursor, &region->outline)) return FAILURE;
+    }
+
+    for (usize p = 0; p < header.path_count; p++) {
+        CachedPath * path = &cache->paths[p];
+        cache->path_count ++;
+
+        uint32_t regions[2];
+        if (read_bytes(data, len, &cursor, regions, sizeof(regions))) return FAILURE;
+        path->region_a = regions[0];
+        path->region_b = regions[1];
+        if (path->region_a != MAP_CACHE_NO_REGION) {
+            if (path->region_a >= header.region_count || path->region_b >= header.region_count) return FAILURE;
+            if (map_cache_read_graph(data, len, &cursor, &path->graph)) return FAILURE;
+        }
+        if (map_cache_read_mesh(data, len, &cursor, &path->model)) return FAILURE;
+    }
+
+    if (map_cache_read_mesh(data, len, &cursor, &cache->background)) return FAILURE;
+    return cursor == len ? SUCCESS : FAILURE;
+}
+Model map_cache_upload (Mesh * mesh) {
+    Mesh upload = *mesh;
+    clear_memory(mesh, sizeof(Mesh));
+    UploadMesh(&upload, false);
+    return LoadModelFromMesh(upload);
+}
+Result map_cache_restore_graph (NavGraph * graph, GlobalNavGrid * global, const CachedGraph * cached) {
+    graph->global   = global;
+    graph->width    = cached->width;
+    graph->height   = cached->height;
+    graph->offset_x = cached->offset_x;
+    graph->offset_y = cached->offset_y;
+    return nav_init_from_mask(graph, cached->mask);
+}
+Result map_cache_apply (Map * map, CachedMap * cache) {
+    if (nav_init_global_grid(map)) {
+        TraceLog(LOG_ERROR, "!Failed to initialize map nav grid");
+        return FAILURE;
+    }
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        Region * region = &map->regions.items[r];
+        CachedRegion * cached = &cache->regions[r];
+
+        listLineDeinit(&region->area.lines);
+        region->area.lines = cached->lines;
+        cached->lines = (ListLine){0};
+
+        region->nav_graph.type   = GRAPH_REGION;
+        region->nav_graph.region = region;
+        if (map_cache_restore_graph(&region->nav_graph, &map->nav_grid, &cached->graph)) {
+            TraceLog(LOG_ERROR, "!Failed to restore nav graph of region %zu", r);
+            return FAILURE;
+        }
+        if (region_connect_objects(region)) {
+            TraceLog(LOG_ERROR, "!Failed to connect objects of region %zu", r);
+            return FAILURE;
+        }
+    }
+
+    for (usize p = 0; p < map->paths.len; p++) {
+        Path * path = &map->paths.items[p];
+        CachedPath * cached = &cache->paths[p];
+        if (cached->region_a == MAP_CACHE_NO_REGION) continue;
+
+        path->region_a = &map->regions.items[cached->region_a];
+        path->region_b = &map->regions.items[cached->region_b];
+        path->nav_graph.type = GRAPH_PATH;
+        path->nav_graph.path = path;
+        if (map_cache_restore_graph(&path->nav_graph, &map->nav_grid, &cached->graph)) {
+            TraceLog(LOG_ERROR, "!Failed to restore nav graph of path %zu", p);
+            return FAILURE;
+        }
+        if (path_link_regions(path)) {
+            return FAILURE;
+        }
+    }
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        Region * region = &map->regions.items[r];
+        region->area.model   = map_cache_upload(&cache->regions[r].model);
+        region->area.outline = map_cache_upload(&cache->regions[r].outline);
+    }
+    for (usize p = 0; p < map->paths.len; p++) {
+        map->paths.items[p].model = map_cache_upload(&cache->paths[p].model);
+    }
+    map->background = map_cache_upload(&cache->background);
+
+    return SUCCESS;
+}
+
+/* Handlers ******************************************************************/
+Result map_cache_load (Map * map) {
+    #ifndef MAP_CACHE
+    (void)map;
+    return FAILURE;
+    #else
+    if (map->hash == 0) return FAILURE;
+
+    char * path = map_cache_file(map);
+    if (! FileExists(path)) return FAILURE;
+
+    usize len = 0;
+    uchar * data = map_cache_load_file(path, &len);
+    if (NULL == data) return FAILURE;
+
+    CachedMap cache = {0};
+    if (map_cache_read(data, len, map, &cache)) {
+        TraceLog(LOG_WARNING, "Map cache for %s is outdated, rebuilding", map->name);
+        cached_map_deinit(&cache);
+        MemFree(data);
+        return FAILURE;
+    }
+
+    Result result = SUCCESS;
+    if (map_cache_apply(map, &cache)) {
+        TraceLog(LOG_ERROR, "Failed to restore map %s from cache", map->name);
+        result = FATAL;
+    }
+    else {
+        TraceLog(LOG_INFO, "Map %s loaded from cache", map->name);
+    }
+
+    cached_map_deinit(&cache);
+    MemFree(data);
+    return result;
+    #endif
+}
+Result map_cache_save (const Map * map) {
+    #ifndef MAP_CACHE
+    (void)map;
+    return SUCCESS;
+    #else
+    if (map->hash == 0) return FAILURE;
+
+    ListUchar buffer = listUcharInit(64 * 1024, perm_allocator());
+    if (NULL == buffer.items) return FAILURE;
+
+    Result result = SUCCESS;
+    if (map_cache_write(&buffer, map)) {
+        TraceLog(LOG_ERROR, "Failed to serialize map %s", map->name);
+        result = FAILURE;
+    }
+    else if (map_cache_save_file(map_cache_file(map), &buffer)) {
+        TraceLog(LOG_ERROR, "Failed to write map cache for %s", map->name);
+        result = FAILURE;
+    }
+
+    listUcharDeinit(&buffer);
+    return result;
+    #endif
+}
@@ -0,0 +1,13 @@
+#ifndef MAP_CACHE_H_
+#define MAP_CACHE_H_
+
+#include "types.h"
+
+/// Restores prepared geometry, nav grids and meshes of the map from the disk cache
+/// Returns FAILURE when there's no valid cache, map is left untouched in that case
+/// Returns FATAL when the cache was valid but the map couldn't be restored from it
+Result map_cache_load (Map * map);
+/// Saves map that went through preparation to the disk cache
+Result map_cache_save (const Map * map);
+
+#endif // MAP_CACHE_H_
@@ -0,0 +1,186 @@
+#include "map_file.h"
+#include "constants.h"
+#include "std.h"
+#include "alloc.h"
+
+#define MAP_FILE_MAGIC 0x504D4C4C
+#define MAP_FILE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t player_count;
+    uint32_t name_length;
+    uint32_t region_count;
+    uint32_t path_count;
+} MapFileHeader;
+
+typedef struct {
+    uint32_t region_id;
+    uint32_t player_id;
+    Vector2  castle;
+    uint32_t building_count;
+    uint32_t line_count;
+} MapFileRegion;
+
+typedef struct {
+    uint32_t path_id;
+    uint32_t line_count;
+} MapFilePath;
+
+/* Reading *******************************************************************/
+Test map_file_is_compiled (const uchar * data, usize len) {
+    uint32_t magic;
+    if (len < sizeof(MapFileHeader))
+        return NO;
+    copy_memory(&magic, data, sizeof(uint32_t));
+    return magic == MAP_FILE_MAGIC ? YES : NO;
+}
+Result map_file_read_lines (const uchar * data, usize len, usize * cursor, ListLine * lines, usize count) {
+    if (count > (len - *cursor) / sizeof(Line)) {
+        TraceLog(LOG_ERROR, "Compiled map has more lines than data");
+        return FAILURE;
+    }
+    *lines = listLineInit(count, perm_allocator());
+    if (count && lines->items == NULL) {
+        TraceLog(LOG_ERROR, "Failed to allocate lines of compiled map");
+        return FAILURE;
+    }
+    if (read_bytes(data, len, cursor, lines->items, sizeof(Line) * count)) return FAILURE;
+    lines->len = count;
+    return SUCCESS;
+}
+Result map_file_read_region (Region * region, const uchar * data, usize len, usize * cursor) {
+    MapFileRegion info;
+    if (read_bytes(data, len, cursor, &info, sizeof(MapFileRegion))) return FAILURE;
+
+    region->region_id = info.region_id;
+    region->player_id = info.player_id;
+    region->castle.position = info.castle;
+    region->paths = listPathPInit(5, perm_allocator());
+
+    if (info.building_count > (len - *cursor) / sizeof(Vector2)) {
+        TraceLog(LOG_ERROR, "Compiled map has more buildings than data");
+        return FAILURE;
+    }
+    region->buildings = listBuildingInit(info.building_count ? info.building_count : 1, perm_allocator());
+    for (usize b = 0; b < info.building_count; b++) {
+        Building building = {0};
+        if (read_bytes(data, len, cursor, &building.position, sizeof(Vector2))) return FAILURE;
+        if (listBuildingAppend(&region->buildings, building)) return FAILURE;
+    }
+
+    return map_file_read_lines(data, len, cursor, &region->area.lines, info.line_count);
+}
+Result map_file_read_header (MapFileHeader * header, const uchar * data, usize len, usize * cursor) {
+    if (read_bytes(data, len, cursor, header, sizeof(MapFileHeader))) return FAILURE;
+    if (header->magic != MAP_FILE_MAGIC || header->version != MAP_FILE_VERSION) {
+        TraceLog(LOG_ERROR, "Compiled map has unsupported version %u, recompile it", header->version);
+        return FAILURE;
+    }
+    // need one space for neutral faction
+    if (header->player_count >= PLAYERS_MAX) {
+        TraceLog(LOG_ERROR, "Compiled map has too many players");
+        return FAILURE;
+    }
+    if (header->name_length > len - *cursor) {
+        TraceLog(LOG_ERROR, "Compiled map name is longer than the file");
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+Result map_file_read_info (Map * result, const uchar * data, usize len, usize * cursor) {
+    MapFileHeader header;
+    if (map_file_read_header(&header, data, len, cursor)) return FAILURE;
+
+    result->width = header.width;
+    result->height = header.height;
+    result->player_count = header.player_count;
+    result->name = MemAlloc(header.name_length + 1);
+    if (NULL == result->name) return FAILURE;
+    if (read_bytes(data, len, cursor, result->name, header.name_length)) return FAILURE;
+    result->name[header.name_length] = '\0';
+    return SUCCESS;
+}
+Result map_file_read (Map * result, const uchar * data, usize len) {
+    usize cursor = 0;
+    MapFileHeader header;
+    if (map_file_read_header(&header, data, len, &cursor)) return FAILURE;
+    cursor = 0;
+    if (map_file_read_info(result, data, len, &cursor)) return FAILURE;
+
+    result->regions = listRegionInit(header.region_count ? header.region_count : 1, perm_allocator());
+    result->paths = listPathInit(header.path_count ? header.path_count : 1, perm_allocator());
+    if (result->regions.items == NULL || result->paths.items == NULL) {
+        TraceLog(LOG_ERROR, "Failed to allocate compiled map");
+        return FAILURE;
+    }
+
+    for (usize r = 0; r < header.region_count; r++) {
+        if (listRegionAppend(&result->regions, (Region){0})) return FAILURE;
+        if (map_file_read_region(&result->regions.items[r], data, len, &cursor)) {
+            TraceLog(LOG_ERROR, "Failed to read region %zu of compiled map", r);
+            return FAILURE;
+        }
+    }
+
+    for (usize p = 0; p < header.path_count; p++) {
+        MapFilePath info;
+        if (read_bytes(data, len, &cursor, &info, sizeof(MapFilePath))) return FAILURE;
+        if (listPathAppend(&result->paths, (Path){ .path_id = info.path_id })) return FAILURE;
+        if (map_file_read_lines(data, len, &cursor, &result->paths.items[p].lines, info.line_count)) {
+            TraceLog(LOG_ERROR, "Failed to read path %zu of compiled map", p);
+            return FAILURE;
+        }
+    }
+
+    if (cursor != len) {
+        TraceLog(LOG_WARNING, "Compiled map %s has %zu trailing bytes", result->name, len - cursor);
+    }
+    return SUCCESS;
+}
+
+/* Writing *******************************************************************/
+Result map_file_write (const Map * map, ListUchar * buffer) {
+    MapFileHeader header = {
+        .magic        = MAP_FILE_MAGIC,
+        .version      = MAP_FILE_VERSION,
+        .width        = map->width,
+        .height       = map->height,
+        .player_count = map->player_count,
+        .name_length  = map->name ? string_length(map->name) : 0,
+        .region_count = map->regions.len,
+        .path_count   = map->paths.len,
+    };
+    if (write_bytes(buffer, &header, sizeof(MapFileHeader))) return FAILURE;
+    if (write_bytes(buffer, map->name, header.name_length)) return FAILURE;
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        const Region * region = &map->regions.items[r];
+        MapFileRegion info = {
+            .region_id      = region->region_id,
+            .player_id      = region->player_id,
+            .castle         = region->castle.position,
+            .building_count = region->buildings.len,
+            .line_count     = region->area.lines.len,
+        };
+        if (write_bytes(buffer, &info, sizeof(MapFileRegion))) return FAILURE;
+        for (usize b = 0; b < region->buildings.len; b++) {
+            if (write_bytes(buffer, &region->buildings.items[b].position, sizeof(Vector2))) return FAILURE;
+        }
+        if (write_bytes(buffer, region->area.lines.items, sizeof(Line) * info.line_count)) return FAILURE;
+    }
+
+    for (usize p = 0; p < map->paths.len; p++) {
+        const Path * path = &map->paths.items[p];
+        MapFilePath info = {
+            .path_id    = path->path_id,
+            .line_count = path->lines.len,
+        };
+        if (write_bytes(buffer, &info, sizeof(MapFilePath))) return FAILURE;
+        if (write_bytes(buffer, path->lines.items, sizeof(Line) * info.line_count)) return FAILURE;
+    }
+    return SUCCESS;
+}
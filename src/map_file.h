@@ -0,0 +1,16 @@
+#ifndef MAP_FILE_H_
+#define MAP_FILE_H_
+
+#include "types.h"
+
+/// Compiled maps are produced offline by tools/map_compiler.c out of Tiled json maps
+/// All values are stored little endian and read back without any conversion
+Test   map_file_is_compiled (const uchar * data, usize len);
+/// Fills in only name, size and player count of the map
+Result map_file_read_info   (Map * result, const uchar * data, usize len, usize * cursor);
+/// Fills in the map from compiled map data, same as load_level does from json
+Result map_file_read        (Map * result, const uchar * data, usize len);
+/// Serializes a map that was just loaded, before any preparation for play
+Result map_file_write       (const Map * map, ListUchar * buffer);
+
+#endif // MAP_FILE_H_
@@ -7,24 +7,233 @@
 #include "constants.h"
 
 /* Utilities *****************************************************************/
-Test is_clockwise (Vector2 a, Vector2 b, Vector2 c) {
-  double val = 0.0;
-  val = (b.x * c.y + a.x * b.y + a.y * c.x) - (a.y * b.x + b.y * c.x + a.x * c.y);
-  return val > 0.0f ? YES : NO;
-}
 Test is_area_clockwise(const Area * area) {
-  unsigned int cl = 0;
-  unsigned int cc = 0;
+  // signed area from the shoelace formula, positive means clockwise in screen space
+  double sum = 0.0;
   for (usize i = 0; i < area->lines.len; i++) {
     Vector2 a = area->lines.items[i].a;
     Vector2 b = area->lines.items[(i + 1) % area->lines.len].a;
-    Vector2 c = area->lines.items[(i + 2) % area->lines.len].a;
-    if (is_clockwise(a, b, c))
-      cl ++;
-    else
-      cc ++;
+    sum += (double)a.x * b.y - (double)b.x * a.y;
   }
-  return cl > cc ? YES : NO;
+  return sum > 0.0 ? YES : NO;
+}
+float triangle_cross (Vector2 a, Vector2 b, Vector2 c) {
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/* Triangulation *************************************************************/
+typedef struct {
+  const ListLine * lines;
+  usize * prev;
+  usize * next;
+  bool  * reflex;
+  bool  * removed;
+  // reflex vertices bucketed into a uniform grid, cell c owns cells[cell_start[c] .. cell_start[c + 1]]
+  usize * cells;
+  usize * cell_start;
+  usize   columns;
+  usize   rows;
+  Rectangle bounds;
+} EarClipper;
+
+Vector2 ear_point (const EarClipper * clipper, usize index) {
+  return clipper->lines->items[index].a;
+}
+bool ear_is_reflex (const EarClipper * clipper, usize index) {
+  // the ring is always walked so that convex corners have a negative cross product
+  Vector2 a = ear_point(clipper, clipper->prev[index]);
+  Vector2 b = ear_point(clipper, index);
+  Vector2 c = ear_point(clipper, clipper->next[index]);
+  return triangle_cross(a, b, c) >= 0.0f;
+}
+usize ear_cell_column (const EarClipper * clipper, float x) {
+  float progress = (x - clipper->bounds.x) / clipper->bounds.width;
+  isize column = (isize)(progress * clipper->columns);
+  if (column < 0) return 0;
+  if (column >= (isize)clipper->columns) return clipper->columns - 1;
+  return column;
+}
+usize ear_cell_row (const EarClipper * clipper, float y) {
+  float progress = (y - clipper->bounds.y) / clipper->bounds.height;
+  isize row = (isize)(progress * clipper->rows);
+  if (row < 0) return 0;
+  if (row >= (isize)clipper->rows) return clipper->rows - 1;
+  return row;
+}
+usize ear_cell (const EarClipper * clipper, Vector2 point) {
+  return ear_cell_row(clipper, point.y) * clipper->columns + ear_cell_column(clipper, point.x);
+}
+void ear_clipper_deinit (EarClipper * clipper) {
+  if (clipper->prev)       MemFree(clipper->prev);
+  if (clipper->next)       MemFree(clipper->next);
+  if (clipper->reflex)     MemFree(clipper->reflex);
+  if (clipper->removed)    MemFree(clipper->removed);
+  if (clipper->cells)      MemFree(clipper->cells);
+  if (clipper->cell_start) MemFree(clipper->cell_start);
+  clear_memory(clipper, sizeof(EarClipper));
+}
+Result ear_clipper_init (EarClipper * clipper, const Area * area) {
+  const usize count = area->lines.len;
+  const Test clockwise = is_area_clockwise(area);
+  clear_memory(clipper, sizeof(EarClipper));
+  clipper->lines = &area->lines;
+
+  clipper->prev    = MemAlloc(sizeof(usize) * count);
+  clipper->next    = MemAlloc(sizeof(usize) * count);
+  clipper->cells   = MemAlloc(sizeof(usize) * count);
+  clipper->reflex  = MemAlloc(sizeof(bool)  * count);
+  clipper->removed = MemAlloc(sizeof(bool)  * count);
+  if (NULL == clipper->prev || NULL == clipper->next || NULL == clipper->cells || NULL == clipper->reflex || NULL == clipper->removed)
+    return FAILURE;
+
+  for (usize i = 0; i < count; i++) {
+    usize forward  = (i + 1) % count;
+    usize backward = (i + count - 1) % count;
+    clipper->next[i]    = clockwise ? backward : forward;
+    clipper->prev[i]    = clockwise ? forward : backward;
+    clipper->removed[i] = false;
+  }
+
+  usize reflex_count = 0;
+  for (usize i = 0; i < count; i++) {
+    clipper->reflex[i] = ear_is_reflex(clipper, i);
+    reflex_count += clipper->reflex[i];
+  }
+
+  // about one reflex vertex per cell keeps each ear test close to constant time
+  clipper->bounds = area_bounds(area);
+  if (clipper->bounds.width  <= 0.0f) clipper->bounds.width  = 1.0f;
+  if (clipper->bounds.height <= 0.0f) clipper->bounds.height = 1.0f;
+  usize side = 1;
+  while (side * side < reflex_count) side ++;
+  clipper->columns = side;
+  clipper->rows    = side;
+
+  const usize cell_count = clipper->columns * clipper->rows;
+  clipper->cell_start = MemAlloc(sizeof(usize) * (cell_count + 1));
+  usize * cursor = MemAlloc(sizeof(usize) * cell_count);
+  if (NULL == clipper->cell_start || NULL == cursor) {
+    if (cursor) MemFree(cursor);
+    return FAILURE;
+  }
+  clear_memory(clipper->cell_start, sizeof(usize) * (cell_count + 1));
+
+  for (usize i = 0; i < count; i++) {
+    if (clipper->reflex[i])
+      clipper->cell_start[ear_cell(clipper, ear_point(clipper, i)) + 1] ++;
+  }
+  for (usize c = 0; c < cell_count; c++) {
+    clipper->cell_start[c + 1] += clipper->cell_start[c];
+    cursor[c] = clipper->cell_start[c];
+  }
+  for (usize i = 0; i < count; i++) {
+    if (clipper->reflex[i])
+      clipper->cells[cursor[ear_cell(clipper, ear_point(clipper, i))] ++] = i;
+  }
+
+  MemFree(cursor);
+  return SUCCESS;
+}
+Test ear_is_valid (const EarClipper * clipper, usize index) {
+  if (clipper->reflex[index]) return NO;
+
+  const usize ia = clipper->prev[index];
+  const usize ic = clipper->next[index];
+  const Vector2 a = ear_point(clipper, ia);
+  const Vector2 b = ear_point(clipper, index);
+  const Vector2 c = ear_point(clipper, ic);
+
+  // only reflex vertices can end up inside of a convex ear, and clipping ears never turns a convex vertex reflex
+  usize col_from = ear_cell_column(clipper, fminf(a.x, fminf(b.x, c.x)));
+  usize col_to   = ear_cell_column(clipper, fmaxf(a.x, fmaxf(b.x, c.x)));
+  usize row_from = ear_cell_row(clipper, fminf(a.y, fminf(b.y, c.y)));
+  usize row_to   = ear_cell_row(clipper, fmaxf(a.y, fmaxf(b.y, c.y)));
+
+  for (usize row = row_from; row <= row_to; row++) {
+    for (usize col = col_from; col <= col_to; col++) {
+      usize cell = row * clipper->columns + col;
+      for (usize r = clipper->cell_start[cell]; r < clipper->cell_start[cell + 1]; r++) {
+        usize candidate = clipper->cells[r];
+        if (candidate == ia || candidate == index || candidate == ic) continue;
+        if (clipper->removed[candidate] || clipper->reflex[candidate] == false) continue;
+
+        Vector2 p = ear_point(clipper, candidate);
+        // outlines touching themselves produce duplicate points which would block every ear around them
+        if (Vector2Equals(p, a) || Vector2Equals(p, b) || Vector2Equals(p, c)) continue;
+
+        if (triangle_cross(a, b, p) <= 0.0f && triangle_cross(b, c, p) <= 0.0f && triangle_cross(c, a, p) <= 0.0f)
+          return NO;
+      }
+    }
+  }
+  return YES;
+}
+void ear_clip (EarClipper * clipper, usize index) {
+  usize a = clipper->prev[index];
+  usize c = clipper->next[index];
+  clipper->next[a] = c;
+  clipper->prev[c] = a;
+  clipper->removed[index] = true;
+
+  if (clipper->reflex[a]) clipper->reflex[a] = ear_is_reflex(clipper, a);
+  if (clipper->reflex[c]) clipper->reflex[c] = ear_is_reflex(clipper, c);
+}
+Result triangulate_area (const Area * area, usize * triangles, usize * triangle_count) {
+  EarClipper clipper;
+  *triangle_count = 0;
+  if (ear_clipper_init(&clipper, area)) {
+    ear_clipper_deinit(&clipper);
+    return FAILURE;
+  }
+
+  usize remaining = area->lines.len;
+  usize current   = 0;
+  usize stalled   = 0;
+
+  while (remaining > 3) {
+    usize a = clipper.prev[current];
+    usize c = clipper.next[current];
+    float cross = triangle_cross(ear_point(&clipper, a), ear_point(&clipper, current), ear_point(&clipper, c));
+
+    if (cross == 0.0f) {
+      // point in the middle of a straight edge, doubled up or at the tip of a spike adds nothing to the surface, it can be dropped without a triangle
+      ear_clip(&clipper, current);
+    }
+    else if (ear_is_valid(&clipper, current)) {
+      usize t = *triangle_count * 3;
+      triangles[t]     = a;
+      triangles[t + 1] = current;
+      triangles[t + 2] = c;
+      *triangle_count += 1;
+      ear_clip(&clipper, current);
+    }
+    else {
+      stalled ++;
+      if (stalled > remaining) {
+        ear_clipper_deinit(&clipper);
+        return FAILURE;
+      }
+      current = c;
+      continue;
+    }
+
+    remaining --;
+    stalled = 0;
+    current = c;
+  }
+
+  usize a = clipper.prev[current];
+  usize c = clipper.next[current];
+  if (triangle_cross(ear_point(&clipper, a), ear_point(&clipper, current), ear_point(&clipper, c)) < 0.0f) {
+    usize t = *triangle_count * 3;
+    triangles[t]     = a;
+    triangles[t + 1] = current;
+    triangles[t + 2] = c;
+    *triangle_count += 1;
+  }
+
+  ear_clipper_deinit(&clipper);
+  return SUCCESS;
 }
 
 /* Generators ****************************************************************/
@@ -238,88 +447,62 @@ Result generate_line_mesh(const ListLine lines, float thickness, ushort cap_reso
   return SUCCESS;
 }
 Result generate_area_mesh (const Area * area, const float layer, Model * result) {
-  temp_reset();
   Mesh mesh = {0};
   const ListLine lines = area->lines;
-  const Test clockwise = is_area_clockwise(area);
-  {
-    mesh.vertexCount = lines.len;
-    mesh.vertices    = MemAlloc(sizeof(float) * 3 * mesh.vertexCount);
-    mesh.texcoords   = MemAlloc(sizeof(float) * 2 * mesh.vertexCount);
-
-    for (usize i = 0; i < lines.len; i++) {
-      usize vert = i * 3;
-      mesh.vertices[vert]     = lines.items[i].a.x;
-      mesh.vertices[vert + 1] = lines.items[i].a.y;
-      mesh.vertices[vert + 2] = layer;
-      usize uv = i * 2;
-      mesh.texcoords[uv]     = lines.items[i].a.x * 0.01;
-      mesh.texcoords[uv + 1] = lines.items[i].a.y * 0.01;
-    }
+  if (lines.len < 3) {
+    TraceLog(LOG_ERROR, "Area needs at least 3 points to build a mesh");
+    return FAILURE;
   }
 
-  {
-    ListUshort indices = listUshortInit(3, perm_allocator());
-    ListUsize points   = listUsizeInit(lines.len, perm_allocator());
-    usize index   = 0;
-    usize counter = 0;
-
-    for (usize i = 0; i < lines.len; i ++) {
-      listUsizeAppend(&points, i);
-    }
-
-    while (points.len > 2) {
-      usize index_m = (index + (clockwise ? points.len - 1 : 1)) % points.len;
-      usize index_e = (index + (clockwise ? points.len - 2 : 2)) % points.len;
+  usize   triangle_count = 0;
+  usize * triangles = MemAlloc(sizeof(usize) * 3 * (lines.len - 2));
+  if (NULL == triangles) return FAILURE;
 
-      usize point_ib = points.items[index];
-      usize point_im = points.items[index_m];
-      usize point_ie = points.items[index_e];
+  if (triangulate_area(area, triangles, &triangle_count)) {
+    TraceLog(LOG_ERROR, "Failed to generate mesh for area");
+    MemFree(triangles);
+    return FAILURE;
+  }
+  TraceLog(LOG_INFO, "Built %zu triangles", triangle_count);
+
+  // raylib indices are 16 bit, outlines with more points than that are unrolled into a plain triangle list instead
+  const Test indexed = lines.len <= 0xFFFF;
+
+  mesh.triangleCount = triangle_count;
+  mesh.vertexCount   = indexed ? lines.len : triangle_count * 3;
+  mesh.vertices      = MemAlloc(sizeof(float) * 3 * mesh.vertexCount);
+  mesh.texcoords     = MemAlloc(sizeof(float) * 2 * mesh.vertexCount);
+  if (NULL == mesh.vertices || NULL == mesh.texcoords) {
+    if (mesh.vertices) MemFree(mesh.vertices);
+    if (mesh.texcoords) MemFree(mesh.texcoords);
+    MemFree(triangles);
+    return FAILURE;
+  }
 
-      Vector2 start = lines.items[point_ib].a;
-      Vector2 mid   = lines.items[point_im].a;
-      Vector2 end   = lines.items[point_ie].a;
+  for (usize i = 0; i < (usize)mesh.vertexCount; i++) {
+    Vector2 point = lines.items[indexed ? i : triangles[i]].a;
+    usize vert = i * 3;
+    mesh.vertices[vert]     = point.x;
+    mesh.vertices[vert + 1] = point.y;
+    mesh.vertices[vert + 2] = layer;
+    usize uv = i * 2;
+    mesh.texcoords[uv]     = point.x * 0.01;
+    mesh.texcoords[uv + 1] = point.y * 0.01;
+  }
 
-      Test tri_clockwise = is_clockwise(start, mid, end);
-      Vector2 test_point = Vector2Lerp(start, end, 0.5f);
-      Test outside = ! area_contains_point(area, test_point);
-      Line test_line = {
-        Vector2MoveTowards(start, end, 1.0f),
-        Vector2MoveTowards(end, start, 1.0f)
-      };
-      Test cuts_through = area_line_intersects(area, test_line);
-      Test invalid = tri_clockwise || outside || cuts_through;
-
-      if (invalid) {
-        if (counter > lines.len) {
-          TraceLog(LOG_ERROR, "Failed to generate mesh for area");
-          listUshortDeinit(&indices);
-          listUsizeDeinit(&points);
-          MemFree(mesh.vertices);
-          return FAILURE;
-        }
-        counter ++;
-        index = index_m;
-        continue;
-      }
-      counter = 0;
-
-      listUshortAppend(&indices, point_ib);
-      listUshortAppend(&indices, point_im);
-      listUshortAppend(&indices, point_ie);
-      listUsizeRemove (&points , index_m);
-      if (index > index_m)
-        index--;
+  if (indexed) {
+    mesh.indices = MemAlloc(sizeof(ushort) * 3 * triangle_count);
+    if (NULL == mesh.indices) {
+      MemFree(mesh.vertices);
+      MemFree(mesh.texcoords);
+      MemFree(triangles);
+      return FAILURE;
+    }
+    for (usize i = 0; i < triangle_count * 3; i++) {
+      mesh.indices[i] = (ushort)triangles[i];
     }
-
-    mesh.triangleCount = indices.len / 3;
-    TraceLog(LOG_INFO, "Built %d triangles", mesh.triangleCount);
-    mesh.indices = MemAlloc(sizeof(ushort) * indices.len);
-    copy_memory(mesh.indices, indices.items, sizeof(ushort) * indices.len);
-
-    listUshortDeinit(&indices);
-    listUsizeDeinit(&points);
   }
+  MemFree(triangles);
 
   UploadMesh(&mesh, false);
   *result = LoadModelFromMesh(mesh);
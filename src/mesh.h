@@ -5,5 +5,6 @@
 #include "types.h"
 
 Result generate_map_mesh  (Map * map);
+Result generate_area_mesh (const Area * area, const float layer, Model * result);
 
 #endif // MESH_H_
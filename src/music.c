@@ -0,0 +1,169 @@
+#include "music.h"
+#include "constants.h"
+#include "std.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+typedef enum {
+    MUSIC_COMMAND_PLAY,
+    MUSIC_COMMAND_STOP,
+    MUSIC_COMMAND_VOLUME,
+} MusicCommandKind;
+
+typedef struct {
+    MusicCommandKind kind;
+    Music            track;
+    float            value;
+} MusicCommand;
+
+typedef struct {
+    pthread_t     thread;
+    bool          running;
+    atomic_bool   quit;
+    // single producer single consumer ring, head is written by the main thread and tail by the music thread
+    MusicCommand  commands[MUSIC_COMMAND_QUEUE];
+    atomic_size_t head;
+    atomic_size_t tail;
+    // main thread only, repeated volume commands are not queued so dragging the slider can't fill the ring
+    float         sent_volume;
+    // music thread only
+    float         volume;
+    Music         current;
+    Music         fading;
+    float         fade_time;
+    float         fade_length;
+} MusicPlayer;
+
+MusicPlayer player = {0};
+
+/* Music Thread **************************************************************/
+bool music_loaded (Music track) {
+    return track.stream.buffer != NULL;
+}
+bool music_same (Music a, Music b) {
+    return a.stream.buffer == b.stream.buffer;
+}
+void music_apply_volume () {
+    float volume = player.volume;
+    float fade = 1.0f;
+    if (player.fade_length > 0.0f) {
+        fade = player.fade_time / player.fade_length;
+        if (fade > 1.0f) fade = 1.0f;
+    }
+    if (music_loaded(player.current)) SetMusicVolume(player.current, volume * fade);
+    if (music_loaded(player.fading)) SetMusicVolume(player.fading, volume * (1.0f - fade));
+}
+void music_fade_out (float fade) {
+    if (music_loaded(player.fading)) StopMusicStream(player.fading);
+    player.fading = player.current;
+    player.current = (Music){0};
+    player.fade_time = 0.0f;
+    player.fade_length = fade;
+    // nothing to fade from, the fade only advances while the fading track plays so the next one would stay silent
+    if (music_loaded(player.fading) == false) {
+        player.fade_time = fade;
+    }
+    if (fade <= 0.0f && music_loaded(player.fading)) {
+        StopMusicStream(player.fading);
+        player.fading = (Music){0};
+    }
+}
+void music_run_command (const MusicCommand * command) {
+    switch (command->kind) {
+        case MUSIC_COMMAND_PLAY: {
+            if (music_same(command->track, player.current)) break;
+            music_fade_out(command->value);
+            player.current = command->track;
+            if (music_loaded(player.current)) PlayMusicStream(player.current);
+        } break;
+        case MUSIC_COMMAND_STOP: {
+            music_fade_out(command->value);
+        } break;
+        case MUSIC_COMMAND_VOLUME: {
+            player.volume = command->value;
+        } break;
+    }
+}
+void music_run_commands () {
+    usize tail = atomic_load_explicit(&player.tail, memory_order_relaxed);
+    usize head = atomic_load_explicit(&player.head, memory_order_acquire);
+    while (tail != head) {
+        music_run_command(&player.commands[tail % MUSIC_COMMAND_QUEUE]);
+        tail ++;
+    }
+    atomic_store_explicit(&player.tail, tail, memory_order_release);
+}
+void * music_thread (void * arg) {
+    (void)arg;
+    const float interval = MUSIC_UPDATE_INTERVAL / 1000.0f;
+    const struct timespec sleep = { 0, MUSIC_UPDATE_INTERVAL * 1000000L };
+
+    while (atomic_load_explicit(&player.quit, memory_order_acquire) == false) {
+        music_run_commands();
+
+        if (music_loaded(player.fading)) {
+            player.fade_time += interval;
+            if (player.fade_time >= player.fade_length) {
+                StopMusicStream(player.fading);
+                player.fading = (Music){0};
+            }
+            else {
+                UpdateMusicStream(player.fading);
+            }
+        }
+        music_apply_volume();
+        if (music_loaded(player.current)) UpdateMusicStream(player.current);
+
+        nanosleep(&sleep, NULL);
+    }
+    // the stop pushed on shutdown may still be waiting
+    music_run_commands();
+    return NULL;
+}
+
+/* Lifetime ******************************************************************/
+Result music_init () {
+    clear_memory(&player, sizeof(MusicPlayer));
+    player.volume = 1.0f;
+    player.sent_volume = 1.0f;
+    atomic_init(&player.quit, false);
+    atomic_init(&player.head, 0);
+    atomic_init(&player.tail, 0);
+    if (pthread_create(&player.thread, NULL, music_thread, NULL)) {
+        return FAILURE;
+    }
+    player.running = true;
+    return SUCCESS;
+}
+void music_deinit () {
+    if (player.running == false) return;
+    music_stop(0.0f);
+    atomic_store_explicit(&player.quit, true, memory_order_release);
+    pthread_join(player.thread, NULL);
+    clear_memory(&player, sizeof(MusicPlayer));
+}
+
+/* Commands ******************************************************************/
+void music_push (MusicCommand command) {
+    if (player.running == false) return;
+    usize head = atomic_load_explicit(&player.head, memory_order_relaxed);
+    usize tail = atomic_load_explicit(&player.tail, memory_order_acquire);
+    if (head - tail >= MUSIC_COMMAND_QUEUE) {
+        TraceLog(LOG_WARNING, "Music command queue is full, command dropped");
+        return;
+    }
+    player.commands[head % MUSIC_COMMAND_QUEUE] = command;
+    atomic_store_explicit(&player.head, head + 1, memory_order_release);
+}
+void music_play (Music track, float fade) {
+    music_push((MusicCommand){ .kind = MUSIC_COMMAND_PLAY, .track = track, .value = fade });
+}
+void music_stop (float fade) {
+    music_push((MusicCommand){ .kind = MUSIC_COMMAND_STOP, .value = fade });
+}
+void music_volume (float volume) {
+    if (player.running == false || volume == player.sent_volume) return;
+    player.sent_volume = volume;
+    music_push((MusicCommand){ .kind = MUSIC_COMMAND_VOLUME, .value = volume });
+}
@@ -0,0 +1,21 @@
+#ifndef MUSIC_H_
+#define MUSIC_H_
+
+#include <raylib.h>
+#include "types.h"
+
+/* Lifetime ******************************************************************/
+/// Starts the thread that owns music playback, needs the audio device to be open
+Result music_init   ();
+/// Stops playback and the thread, call before the music streams are unloaded
+void   music_deinit ();
+
+/* Commands ******************************************************************/
+/// Commands are queued for the music thread, the main thread never touches the music streams
+/// Starts the track from the beginning, fading out the previous one over the fade time in seconds
+void   music_play   (Music track, float fade);
+/// Fades out whatever is playing over the fade time in seconds
+void   music_stop   (float fade);
+void   music_volume (float volume);
+
+#endif // MUSIC_H_
@@ -0,0 +1,164 @@
+#include "nav_stats.h"
+#include "constants.h"
+#include "std.h"
+#include <math.h>
+
+#if !defined(RELEASE)
+typedef struct {
+    float value;
+    float time;
+} NavHeat;
+
+typedef struct {
+    NavPathStats  path[NAV_CALLER_COUNT];
+    NavRangeStats range[NAV_CALLER_COUNT];
+} NavTickStats;
+
+typedef struct {
+    NavTickStats          current;
+    // sums over the window in progress and the last finished one, divided on display
+    NavTickStats          window;
+    NavTickStats          shown;
+    usize                 peak_expanded;
+    usize                 shown_peak;
+    usize                 ticks;
+    bool                  overlay;
+    const GlobalNavGrid * grid;
+    NavHeat             * heat;
+} NavStats;
+
+NavStats nav_stats = {0};
+
+const char * nav_caller_names[NAV_CALLER_COUNT] = {
+    [NAV_CALLER_OTHER]   = "other",
+    [NAV_CALLER_CHASE]   = "chase",
+    [NAV_CALLER_TRANSIT] = "transit",
+    [NAV_CALLER_WANDER]  = "wander",
+    [NAV_CALLER_SIGHT]   = "sight",
+    [NAV_CALLER_ATTACK]  = "attack",
+    [NAV_CALLER_SUPPORT] = "support",
+};
+
+/* Counting ******************************************************************/
+void nav_stats_path (NavCaller caller, const NavPathStats * stats) {
+    NavPathStats * total = &nav_stats.current.path[caller];
+    total->calls        += stats->calls;
+    total->failures     += stats->failures;
+    total->expanded     += stats->expanded;
+    total->pushed       += stats->pushed;
+    total->heap_updates += stats->heap_updates;
+    total->path_length  += stats->path_length;
+}
+void nav_stats_range (NavCaller caller, usize cells) {
+    nav_stats.current.range[caller].calls ++;
+    nav_stats.current.range[caller].cells += cells;
+}
+float nav_heat_value (const NavHeat * heat, float now) {
+    if (heat->value <= 0.0f) return 0.0f;
+    return heat->value * expf((heat->time - now) / NAV_HEAT_SECONDS);
+}
+void nav_stats_expand (const GlobalNavGrid * grid, usize index, float now) {
+    if (nav_stats.grid != grid) {
+        nav_stats_forget(nav_stats.grid);
+        nav_stats.heat = MemAlloc(sizeof(NavHeat) * grid->width * grid->height);
+        if (nav_stats.heat == NULL) return;
+        clear_memory(nav_stats.heat, sizeof(NavHeat) * grid->width * grid->height);
+        nav_stats.grid = grid;
+    }
+    NavHeat * heat = &nav_stats.heat[index];
+    heat->value = nav_heat_value(heat, now) + 1.0f;
+    heat->time = now;
+}
+void nav_stats_forget (const GlobalNavGrid * grid) {
+    if (grid == NULL || nav_stats.grid != grid) return;
+    if (nav_stats.heat) MemFree(nav_stats.heat);
+    nav_stats.heat = NULL;
+    nav_stats.grid = NULL;
+}
+void nav_stats_tick () {
+    usize expanded = 0;
+    for (usize c = 0; c < NAV_CALLER_COUNT; c++) {
+        const NavPathStats * path = &nav_stats.current.path[c];
+        NavPathStats * sum = &nav_stats.window.path[c];
+        sum->calls        += path->calls;
+        sum->failures     += path->failures;
+        sum->expanded     += path->expanded;
+        sum->pushed       += path->pushed;
+        sum->heap_updates += path->heap_updates;
+        sum->path_length  += path->path_length;
+        nav_stats.window.range[c].calls += nav_stats.current.range[c].calls;
+        nav_stats.window.range[c].cells += nav_stats.current.range[c].cells;
+        expanded += path->expanded;
+    }
+    if (expanded > nav_stats.peak_expanded) nav_stats.peak_expanded = expanded;
+    clear_memory(&nav_stats.current, sizeof(NavTickStats));
+
+    if (++ nav_stats.ticks >= NAV_STATS_TICKS) {
+        nav_stats.shown = nav_stats.window;
+        nav_stats.shown_peak = nav_stats.peak_expanded;
+        clear_memory(&nav_stats.window, sizeof(NavTickStats));
+        nav_stats.peak_expanded = 0;
+        nav_stats.ticks = 0;
+    }
+}
+
+/* Drawing *******************************************************************/
+void nav_stats_render (const Theme * theme) {
+    if (IsKeyPressed(NAV_STATS_KEY)) nav_stats.overlay = ! nav_stats.overlay;
+    if (nav_stats.overlay == false) return;
+
+    float ticks = NAV_STATS_TICKS;
+    float x = GetScreenWidth() * 0.5f;
+    float y = theme->info_bar_height + theme->margin;
+    DrawText(TextFormat("Per tick, peak expanded: %zu", nav_stats.shown_peak), x, y, theme->font_size, theme->text);
+    y += theme->font_size;
+
+    for (usize c = 0; c < NAV_CALLER_COUNT; c++) {
+        const NavPathStats * path = &nav_stats.shown.path[c];
+        const NavRangeStats * range = &nav_stats.shown.range[c];
+        if (path->calls == 0 && range->calls == 0) continue;
+
+        const char * text;
+        if (path->calls) {
+            text = TextFormat("%s: %.1f paths, %.1f failed, %.0f expanded, %.0f pushed, %.0f updates, length %.1f",
+                nav_caller_names[c],
+                path->calls / ticks,
+                path->failures / ticks,
+                path->expanded / ticks,
+                path->pushed / ticks,
+                path->heap_updates / ticks,
+                path->calls > path->failures ? (float)path->path_length / (path->calls - path->failures) : 0.0f
+            );
+        }
+        else {
+            text = TextFormat("%s: %.1f range searches, %.0f cells", nav_caller_names[c], range->calls / ticks, range->cells / ticks);
+        }
+        DrawText(text, x, y, theme->font_size, theme->text);
+        y += theme->font_size;
+    }
+}
+void nav_stats_render_heat (const GlobalNavGrid * grid, Rectangle view) {
+    if (nav_stats.overlay == false || nav_stats.grid != grid || nav_stats.heat == NULL) return;
+
+    float now = GetTime();
+    // waypoints sit on the far corner of their cell, see nav_position_global_world
+    isize x_min = view.x / NAV_GRID_SIZE - 1;
+    isize y_min = view.y / NAV_GRID_SIZE - 1;
+    isize x_max = (view.x + view.width) / NAV_GRID_SIZE;
+    isize y_max = (view.y + view.height) / NAV_GRID_SIZE;
+    if (x_min < 0) x_min = 0;
+    if (y_min < 0) y_min = 0;
+    if (x_max >= (isize)grid->width) x_max = grid->width - 1;
+    if (y_max >= (isize)grid->height) y_max = grid->height - 1;
+
+    for (isize y = y_min; y <= y_max; y++) {
+        for (isize x = x_min; x <= x_max; x++) {
+            float heat = nav_heat_value(&nav_stats.heat[y * grid->width + x], now) / NAV_HEAT_SCALE;
+            if (heat < 0.02f) continue;
+            if (heat > 1.0f) heat = 1.0f;
+            Rectangle cell = { x * NAV_GRID_SIZE + NAV_GRID_SIZE * 0.5f, y * NAV_GRID_SIZE + NAV_GRID_SIZE * 0.5f, NAV_GRID_SIZE, NAV_GRID_SIZE };
+            DrawRectangleRec(cell, Fade(RED, heat * 0.6f));
+        }
+    }
+}
+#endif
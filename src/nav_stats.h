@@ -0,0 +1,42 @@
+#ifndef NAV_STATS_H_
+#define NAV_STATS_H_
+
+#include <raylib.h>
+#include "types.h"
+#include "pathfinding.h"
+
+/// Counters for pathfinding and range searches, they compile to nothing in release builds
+#if !defined(RELEASE)
+#define NAV_STAT(code) code
+
+typedef struct {
+    usize calls;
+    usize failures;
+    usize expanded;
+    usize pushed;
+    usize heap_updates;
+    usize path_length;
+} NavPathStats;
+
+typedef struct {
+    usize calls;
+    usize cells;
+} NavRangeStats;
+
+void nav_stats_path   (NavCaller caller, const NavPathStats * stats);
+void nav_stats_range  (NavCaller caller, usize cells);
+/// Adds the expanded cell to the heatmap, now is passed in so a search reads the clock once
+void nav_stats_expand (const GlobalNavGrid * grid, usize index, float now);
+/// Closes the counters of the previous tick, call at the start of each tick
+void nav_stats_tick   ();
+/// Drops the heatmap of a grid that is going away
+void nav_stats_forget (const GlobalNavGrid * grid);
+
+/// Overlay and heatmap are toggled together with NAV_STATS_KEY
+void nav_stats_render      (const Theme * theme);
+void nav_stats_render_heat (const GlobalNavGrid * grid, Rectangle view);
+#else
+#define NAV_STAT(code)
+#endif
+
+#endif // NAV_STATS_H_
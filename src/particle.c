@@ -2,6 +2,10 @@
 #include "std.h"
 #include "math.h"
 #include "constants.h"
+#include "sprite.h"
+#include "visibility.h"
+#include "quality.h"
+#include "random.h"
 #include <raymath.h>
 
 /* Animation Curves ****************************************************************/
@@ -67,15 +71,161 @@ AnimationCurve curve_timeline (float start, float start_handle, float end_handle
     };
 }
 
+/* Particle System ***********************************************************/
+float particle_curves[PARTICLE_PRESET_COUNT][PARTICLE_CURVE_COUNT][PARTICLE_CURVE_STEPS + 1];
+
+void particles_bake_curves () {
+    AnimationCurve presets[PARTICLE_PRESET_COUNT][PARTICLE_CURVE_COUNT] = {
+        [PARTICLE_PRESET_BLOOD] = {
+            [PARTICLE_CURVE_VELOCITY] = curve_timeline(1.0f, 1.0f, 0.5f, 0.0f),
+            [PARTICLE_CURVE_ROTATION] = curve_linear(0.0f, 1.0f),
+            [PARTICLE_CURVE_SCALE]    = curve_timeline(2.0f, 1.5f, 1.5f, 1.0f),
+            [PARTICLE_CURVE_ALPHA]    = curve_constant(1.0f),
+            [PARTICLE_CURVE_COLOR]    = curve_timeline(0.0f, 0.0f, 0.2f, 1.0f),
+        },
+        [PARTICLE_PRESET_CAST] = {
+            [PARTICLE_CURVE_VELOCITY] = curve_constant(1.0f),
+            [PARTICLE_CURVE_ROTATION] = curve_constant(0.0f),
+            [PARTICLE_CURVE_SCALE]    = curve_smooth(2.0f, 8.0f),
+            [PARTICLE_CURVE_ALPHA]    = curve_bell(),
+            [PARTICLE_CURVE_COLOR]    = curve_constant(0.0f),
+        },
+        [PARTICLE_PRESET_BLESSING] = {
+            [PARTICLE_CURVE_VELOCITY] = curve_smooth(0.0f, 1.0f),
+            [PARTICLE_CURVE_ROTATION] = curve_constant(0.0f),
+            [PARTICLE_CURVE_SCALE]    = curve_smooth(2.0f, 4.0f),
+            [PARTICLE_CURVE_ALPHA]    = curve_bell(),
+            [PARTICLE_CURVE_COLOR]    = curve_constant(0.0f),
+        },
+        [PARTICLE_PRESET_WHIRL] = {
+            [PARTICLE_CURVE_VELOCITY] = curve_constant(1.0f),
+            [PARTICLE_CURVE_ROTATION] = curve_constant(0.0f),
+            [PARTICLE_CURVE_SCALE]    = curve_smooth(2.0f, 4.0f),
+            [PARTICLE_CURVE_ALPHA]    = curve_bell(),
+            [PARTICLE_CURVE_COLOR]    = curve_constant(0.0f),
+        },
+    };
+    for (usize p = 0; p < PARTICLE_PRESET_COUNT; p++) {
+        for (usize c = 0; c < PARTICLE_CURVE_COUNT; c++) {
+            for (usize i = 0; i <= PARTICLE_CURVE_STEPS; i++) {
+                particle_curves[p][c][i] = animation_curve_evaluate(presets[p][c], (float)i / PARTICLE_CURVE_STEPS);
+            }
+        }
+    }
+}
+float particle_curve (uint8_t preset, ParticleCurve curve, float t) {
+    const float * samples = particle_curves[preset][curve];
+    float step = t * PARTICLE_CURVE_STEPS;
+    if (step <= 0.0f) return samples[0];
+    if (step >= PARTICLE_CURVE_STEPS) return samples[PARTICLE_CURVE_STEPS];
+    usize i = step;
+    return samples[i] + (samples[i + 1] - samples[i]) * (step - i);
+}
+void * particles_carve (uchar ** memory, usize size) {
+    void * result = *memory;
+    *memory += size * PARTICLES_MAX;
+    return result;
+}
+Result particles_init (ParticleSystem * particles) {
+    clear_memory(particles, sizeof(ParticleSystem));
+    usize size = PARTICLES_MAX * (sizeof(usize) * 3 + sizeof(float) * 7 + sizeof(Color) * 2 + sizeof(uint8_t) * 2);
+    uchar * memory = MemAlloc(size);
+    if (memory == NULL) {
+        TraceLog(LOG_ERROR, "Failed to allocate memory for particles");
+        return FAILURE;
+    }
+    clear_memory(memory, size);
+    particles->memory = memory;
+    // widest fields first so each array stays aligned
+    particles->chunk       = particles_carve(&memory, sizeof(usize));
+    particles->chunk_prev  = particles_carve(&memory, sizeof(usize));
+    particles->chunk_next  = particles_carve(&memory, sizeof(usize));
+    particles->position_x  = particles_carve(&memory, sizeof(float));
+    particles->position_y  = particles_carve(&memory, sizeof(float));
+    particles->velocity_x  = particles_carve(&memory, sizeof(float));
+    particles->velocity_y  = particles_carve(&memory, sizeof(float));
+    particles->time_lived  = particles_carve(&memory, sizeof(float));
+    particles->lifetime    = particles_carve(&memory, sizeof(float));
+    particles->spin        = particles_carve(&memory, sizeof(float));
+    particles->color_start = particles_carve(&memory, sizeof(Color));
+    particles->color_end   = particles_carve(&memory, sizeof(Color));
+    particles->preset      = particles_carve(&memory, sizeof(uint8_t));
+    particles->sprite      = particles_carve(&memory, sizeof(uint8_t));
+
+    particles_bake_curves();
+    return SUCCESS;
+}
+void particles_deinit (ParticleSystem * particles) {
+    if (particles->memory) MemFree(particles->memory);
+    clear_memory(particles, sizeof(ParticleSystem));
+}
+usize particle_emit (GameState * state, ParticlePreset preset, Vector2 position, Vector2 velocity, float lifetime) {
+    ParticleSystem * particles = &state->particles;
+    if (particles->count >= PARTICLES_MAX) return PARTICLES_MAX;
+    usize i = particles->count ++;
+
+    particles->position_x[i]  = position.x;
+    particles->position_y[i]  = position.y;
+    particles->velocity_x[i]  = velocity.x;
+    particles->velocity_y[i]  = velocity.y;
+    particles->time_lived[i]  = 0.0f;
+    particles->lifetime[i]    = lifetime;
+    particles->spin[i]        = 0.0f;
+    particles->color_start[i] = WHITE;
+    particles->color_end[i]   = WHITE;
+    particles->preset[i]      = preset;
+    particles->sprite[i]      = PARTICLE_NO_SPRITE;
+    particles->chunk[i]       = 0;
+    particles->chunk_prev[i]  = 0;
+    particles->chunk_next[i]  = 0;
+    visibility_move_particle(&state->visibility, particles, i);
+    return i;
+}
+void particle_remove (GameState * state, usize index) {
+    ParticleSystem * particles = &state->particles;
+    visibility_remove_particle(&state->visibility, particles, index);
+    usize last = -- particles->count;
+    if (index == last) return;
+
+    particles->position_x[index]  = particles->position_x[last];
+    particles->position_y[index]  = particles->position_y[last];
+    particles->velocity_x[index]  = particles->velocity_x[last];
+    particles->velocity_y[index]  = particles->velocity_y[last];
+    particles->time_lived[index]  = particles->time_lived[last];
+    particles->lifetime[index]    = particles->lifetime[last];
+    particles->spin[index]        = particles->spin[last];
+    particles->color_start[index] = particles->color_start[last];
+    particles->color_end[index]   = particles->color_end[last];
+    particles->preset[index]      = particles->preset[last];
+    particles->sprite[index]      = particles->sprite[last];
+    particles->chunk[index]       = particles->chunk[last];
+    particles->chunk_prev[index]  = particles->chunk_prev[last];
+    particles->chunk_next[index]  = particles->chunk_next[last];
+    visibility_renumber_particle(&state->visibility, particles, index);
+}
+// the quality governor lowers the budget when frames run late
+Test particles_full (const GameState * state) {
+    usize budget = quality_settings(&state->quality).particles;
+    if (budget > PARTICLES_MAX) budget = PARTICLES_MAX;
+    return state->particles.count >= budget ? YES : NO;
+}
+// particles only live for a moment, ones starting out of view are never seen
+Test particles_visible (const GameState * state, Vector2 position) {
+    return CheckCollisionPointRec(position, visibility_view(state->camera, NAV_GRID_SIZE)) ? YES : NO;
+}
+
 /* Particles *****************************************************************/
 void particles_blood (GameState * state, Unit * attacked, Attack attack) {
+    if (particles_visible(state, attacked->position) == NO) return;
+    Random * random = &state->random[RANDOM_PRESENTATION];
+
     usize amount;
     switch (attacked->type) {
         case UNIT_GUARDIAN: {
-            amount = attacked->health > 0.0f ? GetRandomValue(2, 8) : GetRandomValue(4, 20);
+            amount = attacked->health > 0.0f ? random_range(random, 2, 8) : random_range(random, 4, 20);
         } break;
         default: {
-            amount = attacked->health > 0.0f ? GetRandomValue(3, 10) : GetRandomValue(10, 20);
+            amount = attacked->health > 0.0f ? random_range(random, 3, 10) : random_range(random, 10, 20);
         } break;
     }
     Vector2 direction;
@@ -97,180 +247,166 @@ void particles_blood (GameState * state, Unit * attacked, Attack attack) {
         direction = (Vector2){ attack.origin_position.x > attacked->position.x ? 0.3f : -0.3f, -0.7f };
     }
 
+    ParticleSystem * particles = &state->particles;
     for (usize i = 0; i < amount; i++) {
-        if (state->particles_available.len == 0) {
-            TraceLog(LOG_WARNING, "Ran out of particles");
+        if (particles_full(state)) {
+            TraceLog(LOG_DEBUG, "Ran out of particles");
             break;
         }
-        state->particles_available.len --;
-        Particle * particle = state->particles_available.items[state->particles_available.len];
-        clear_memory(particle, sizeof(Particle));
-
-        particle->lifetime = GetRandomValue(20, 60) * 0.01f;
 
+        float lifetime = random_range(random, 20, 60) * 0.01f;
+        Color color_start;
+        Color color_end;
         switch (attacked->type) {
             case UNIT_GUARDIAN: switch (attacked->faction) {
                 case FACTION_KNIGHTS: {
-                    unsigned char col = GetRandomValue(132, 164);
-                    particle->color_start = (Color){ col, col, col, 255 };
-                    particle->color_end = (Color){ 92, 92, 92, 255 };
+                    unsigned char col = random_range(random, 132, 164);
+                    color_start = (Color){ col, col, col, 255 };
+                    color_end = (Color){ 92, 92, 92, 255 };
                 } break;
                 case FACTION_MAGES: {
-                    unsigned char col = GetRandomValue(132, 164);
-                    particle->color_start = (Color){ GetRandomValue(152, 192), col, col, 255 };
-                    particle->color_end = (Color){ 92, 92, 92, 255 };
+                    unsigned char col = random_range(random, 132, 164);
+                    color_start = (Color){ random_range(random, 152, 192), col, col, 255 };
+                    color_end = (Color){ 92, 92, 92, 255 };
+                } break;
+                default: {
+                    color_start = color_end = WHITE;
                 } break;
             } break;
             default: {
-                particle->color_start = (Color){ GetRandomValue(192, 255), 32, 16, 255 };
-                particle->color_end = (Color){ 128, 64, 32, 255 };
+                color_start = (Color){ random_range(random, 192, 255), 32, 16, 255 };
+                color_end = (Color){ 128, 64, 32, 255 };
             } break;
         }
-        particle->color_curve = curve_timeline(0.0f, 0.0f, 0.2f, 1.0f);
-        particle->alpha_curve = curve_constant(1.0f);
-
-        particle->position = Vector2Add(attacked->position, (Vector2){ GetRandomValue(-2, 2), GetRandomValue(-2, 2)});
-
-        float angle = attacked->health > 0.0f ? GetRandomValue(-20, 20) : GetRandomValue(0, 360);
-        particle->velocity = Vector2Rotate(direction, angle * DEG2RAD);
-        particle->velocity_curve = curve_timeline(1.0f, 1.0f, 0.5f, 0.0f);
 
-        float rotation = GetRandomValue(-80, 80);
-        particle->rotation_curve = curve_linear(0.0f, rotation);
+        Vector2 position = Vector2Add(attacked->position, (Vector2){ random_range(random, -2, 2), random_range(random, -2, 2)});
+        float angle = attacked->health > 0.0f ? random_range(random, -20, 20) : random_range(random, 0, 360);
+        Vector2 velocity = Vector2Rotate(direction, angle * DEG2RAD);
 
-        particle->scale_curve = curve_timeline(2.0f, 1.5f, 1.5f, 1.0f);
-        listParticleAppend(&state->particles_in_use, particle);
+        usize p = particle_emit(state, PARTICLE_PRESET_BLOOD, position, velocity, lifetime);
+        particles->color_start[p] = color_start;
+        particles->color_end[p] = color_end;
+        particles->spin[p] = random_range(random, -80, 80);
     }
 }
 void particles_magic (GameState * state, Unit * caster, Unit * target) {
+    ParticleSystem * particles = &state->particles;
+    Random * random = &state->random[RANDOM_PRESENTATION];
     // caster particle
-    {
-        if (state->particles_available.len == 0) return;
-        state->particles_available.len --;
-        Particle * particle = state->particles_available.items[state->particles_available.len];
-        clear_memory(particle, sizeof(Particle));
-
-        particle->lifetime = 1.0f;
-        particle->color_start = particle->color_end = WHITE;
-        particle->color_curve = curve_constant(0.0f);
-        particle->alpha_curve = curve_bell();
-        particle->rotation_curve = curve_constant(0.0f);
-        particle->scale_curve = curve_smooth(2.0f, 8.0f);
-        particle->position = caster->position;
-        particle->velocity = (Vector2){ 0.0f, -0.1f};
-        particle->velocity_curve = curve_constant(1.0f);
+    if (particles_visible(state, caster->position)) {
+        if (particles_full(state)) return;
+        usize p = particle_emit(state, PARTICLE_PRESET_CAST, caster->position, (Vector2){ 0.0f, -0.1f }, 1.0f);
 
         switch(caster->faction) {
             case FACTION_KNIGHTS: {
-                particle->sprite = (Texture2D*)&state->resources->particles[PARTICLE_PLUS];
+                particles->sprite[p] = PARTICLE_PLUS;
             } break;
             case FACTION_MAGES: {
-                particle->sprite = (Texture2D*)&state->resources->particles[PARTICLE_TORNADO];
+                particles->sprite[p] = PARTICLE_TORNADO;
             } break;
         }
-        listParticleAppend(&state->particles_in_use, particle);
     }
 
+    if (particles_visible(state, target->position) == NO) return;
+
     usize amount;
     switch (caster->faction) {
-        case FACTION_KNIGHTS: amount = GetRandomValue(3, 5); break;
-        case FACTION_MAGES: amount = GetRandomValue(3, 5); break;
+        case FACTION_KNIGHTS: amount = random_range(random, 3, 5); break;
+        case FACTION_MAGES: amount = random_range(random, 3, 5); break;
         default: TraceLog(LOG_FATAL, "Invalid caster faction"); return;
     }
 
     // magic effect particle on the target
     while (amount --> 0) {
-        if (state->particles_available.len == 0) break;
-        state->particles_available.len --;
-        Particle * particle = state->particles_available.items[state->particles_available.len];
-        clear_memory(particle, sizeof(Particle));
-
-        particle->lifetime = 1.0f;
-        particle->color_start = particle->color_end = WHITE;
-        particle->color_curve = curve_constant(0.0f);
-        particle->alpha_curve = curve_bell();
-        particle->rotation_curve = curve_constant(0.0f);
-        particle->scale_curve = curve_smooth(2.0f, 4.0f);
+        if (particles_full(state)) break;
 
         switch(caster->faction) {
             case FACTION_KNIGHTS: {
-                particle->position = (Vector2){ GetRandomValue(-UNIT_SIZE * 50, UNIT_SIZE * 50) * 0.01f, GetRandomValue(-UNIT_SIZE * 75, -UNIT_SIZE * 100) * 0.01f };
-                particle->position = Vector2Add(particle->position, target->position);
-                particle->velocity = (Vector2){ 0.0f, 0.2f};
-                particle->velocity_curve = curve_smooth(0.0f, 1.0f);
-                particle->sprite = (Texture2D*)&state->resources->particles[PARTICLE_PLUS];
+                Vector2 position = (Vector2){ random_range(random, -UNIT_SIZE * 50, UNIT_SIZE * 50) * 0.01f, random_range(random, -UNIT_SIZE * 75, -UNIT_SIZE * 100) * 0.01f };
+                position = Vector2Add(position, target->position);
+                usize p = particle_emit(state, PARTICLE_PRESET_BLESSING, position, (Vector2){ 0.0f, 0.2f }, 1.0f);
+                particles->sprite[p] = PARTICLE_PLUS;
             } break;
             case FACTION_MAGES: {
-                particle->position = (Vector2){ GetRandomValue(-UNIT_SIZE * 10, UNIT_SIZE * 10) * 0.01f, GetRandomValue(UNIT_SIZE * 25, UNIT_SIZE * 50) * 0.01f };
-                particle->position = Vector2Add(particle->position, target->position);
-                particle->velocity = (Vector2){ GetRandomValue(-10, 10) * 0.01f, GetRandomValue(-20, -10) * 0.01f };
-                particle->velocity_curve = curve_constant(1.0f);
-                particle->sprite = (Texture2D*)&state->resources->particles[PARTICLE_TORNADO];
+                Vector2 position = (Vector2){ random_range(random, -UNIT_SIZE * 10, UNIT_SIZE * 10) * 0.01f, random_range(random, UNIT_SIZE * 25, UNIT_SIZE * 50) * 0.01f };
+                position = Vector2Add(position, target->position);
+                Vector2 velocity = (Vector2){ random_range(random, -10, 10) * 0.01f, random_range(random, -20, -10) * 0.01f };
+                usize p = particle_emit(state, PARTICLE_PRESET_WHIRL, position, velocity, 1.0f);
+                particles->sprite[p] = PARTICLE_TORNADO;
             } break;
         }
-
-        listParticleAppend(&state->particles_in_use, particle);
     }
 }
 void particles_clean (GameState * state) {
-    if (state->particles_in_use.len == 0) return;
-
-    usize i = state->particles_in_use.len;
+    ParticleSystem * particles = &state->particles;
+    // going from the back, whatever gets swapped into a removed slot was already checked
+    usize i = particles->count;
     while (i --> 0) {
-        Particle * particle = state->particles_in_use.items[i];
-        if (particle->lifetime < particle->time_lived) {
-            listParticleRemove(&state->particles_in_use, i);
-            listParticleAppend(&state->particles_available, particle);
+        if (particles->lifetime[i] < particles->time_lived[i]) {
+            particle_remove(state, i);
         }
     }
 }
-void particles_advance (Particle ** particles, usize len, float delta_time) {
-    for (usize i = 0; i < len; i++) {
-        Particle * particle = particles[i];
-
-        particle->time_lived += delta_time;
-        if (particle->time_lived > particle->lifetime) continue;
-
-        float t = particle->time_lived / particle->lifetime;
-        float velocity = animation_curve_evaluate(particle->velocity_curve, t);
-        if (! FloatEquals(velocity, 0.0f)) {
-            Vector2 diff = Vector2Scale(particle->velocity, velocity);
-            particle->position = Vector2Add(particle->position, diff);
-        }
+void particles_advance (GameState * state, float delta_time) {
+    ParticleSystem * particles = &state->particles;
+    const usize count = particles->count;
+
+    for (usize i = 0; i < count; i++) {
+        particles->time_lived[i] += delta_time;
+    }
+    for (usize i = 0; i < count; i++) {
+        float velocity = particle_curve(particles->preset[i], PARTICLE_CURVE_VELOCITY, particles->time_lived[i] / particles->lifetime[i]);
+        particles->position_x[i] += particles->velocity_x[i] * velocity;
+        particles->position_y[i] += particles->velocity_y[i] * velocity;
+    }
+    for (usize i = 0; i < count; i++) {
+        visibility_move_particle(&state->visibility, particles, i);
     }
 }
-void particles_render (Particle ** particles, usize len) {
-    for (usize i = 0; i < len; i++) {
-        const Particle * particle = particles[i];
-        float t = particle->time_lived / particle->lifetime;
-
-        float rotation = animation_curve_evaluate(particle->rotation_curve, t);
-        float scale = animation_curve_evaluate(particle->scale_curve, t);
-
-        float t_color = animation_curve_evaluate(particle->color_curve, t);
-        Color color = particle->color_end;
-        color.a = (unsigned char)( t_color * 255 );
-        color = ColorAlphaBlend(particle->color_start, color, WHITE);
-        color.a = (unsigned char)( 255 * animation_curve_evaluate(particle->alpha_curve, t) );
-
-        if (particle->sprite) {
-            Rectangle sprite_rect = (Rectangle){ 0, 0, particle->sprite->width, particle->sprite->height };
-            Vector2 origin = (Vector2){ 0.5f * scale, 0.5f * scale };
-            Rectangle world_rect = (Rectangle) { particle->position.x, particle->position.y, scale, scale };
-            DrawTexturePro(*particle->sprite, sprite_rect, world_rect, origin, rotation, color);
-        }
-        else {
-            Rectangle rect = {
-                .x = particle->position.x,
-                .y = particle->position.y,
-                .width = scale,
-                .height = scale,
-            };
-            DrawRectanglePro(rect, (Vector2){0}, rotation, color);
+void particle_render (const GameState * state, usize index) {
+    const ParticleSystem * particles = &state->particles;
+    uint8_t preset = particles->preset[index];
+    float t = particles->time_lived[index] / particles->lifetime[index];
+
+    float rotation = particle_curve(preset, PARTICLE_CURVE_ROTATION, t) * particles->spin[index];
+    float scale = particle_curve(preset, PARTICLE_CURVE_SCALE, t);
+
+    float t_color = particle_curve(preset, PARTICLE_CURVE_COLOR, t);
+    Color color = particles->color_end[index];
+    color.a = (unsigned char)( t_color * 255 );
+    color = ColorAlphaBlend(particles->color_start[index], color, WHITE);
+    color.a = (unsigned char)( 255 * particle_curve(preset, PARTICLE_CURVE_ALPHA, t) );
+
+    Vector2 position = { particles->position_x[index], particles->position_y[index] };
+    if (particles->sprite[index] != PARTICLE_NO_SPRITE) {
+        Vector2 origin = (Vector2){ 0.5f * scale, 0.5f * scale };
+        Rectangle world_rect = (Rectangle) { position.x, position.y, scale, scale };
+        draw_sprite(state->resources->particles[particles->sprite[index]], world_rect, origin, rotation, color);
+    }
+    else {
+        Rectangle rect = {
+            .x = position.x,
+            .y = position.y,
+            .width = scale,
+            .height = scale,
+        };
+        DrawRectanglePro(rect, (Vector2){0}, rotation, color);
+    }
+}
+void particles_render (const GameState * state) {
+    const VisibilityGrid * grid = &state->visibility;
+    if (grid->chunks == NULL) return;
+    // particles are scaled up to 8 units, the margin covers the ones sticking in from outside
+    ChunkRange range = visibility_range(grid, visibility_view(state->camera, NAV_GRID_SIZE));
+    for (usize y = range.y_min; y <= range.y_max; y++) {
+        for (usize x = range.x_min; x <= range.x_max; x++) {
+            for (usize p = visibility_chunk(grid, x, y)->particles; p; p = state->particles.chunk_next[p - 1]) {
+                particle_render(state, p - 1);
+            }
         }
     }
 }
-void particles_render_attacks (const GameState * state, Unit * attacked) {
+void particles_render_attacks (const GameState * state, const Unit * attacked, ListSpriteQuad * batch) {
     if (attacked->incoming_attacks.len == 0)
         return;
 
@@ -278,7 +414,7 @@ void particles_render_attacks (const GameState * state, Unit * attacked) {
     const float half_size = size * 0.5f;
 
     for (usize i = 0; i < attacked->incoming_attacks.len; i++) {
-        Attack * attack = &attacked->incoming_attacks.items[i];
+        const Attack * attack = &attacked->incoming_attacks.items[i];
         float t = attack->timer / attack->delay;
 
         Vector2 attack_position;
@@ -341,17 +477,18 @@ void particles_render_attacks (const GameState * state, Unit * attacked) {
             attack_rotation = 0.0f;
         }
 
-        Texture2D sprite = state->resources->particles[attack_type];
-        Rectangle source = (Rectangle){ 0, 0, sprite.width, ( attack_rotation >= 90.0f ) || (attack_rotation <= -90.0f) ? -sprite.height : sprite.height };
+        Sprite sprite = state->resources->particles[attack_type];
+        Rectangle source = sprite_source(sprite);
+        Rectangle part = (Rectangle){ 0, 0, source.width, ( attack_rotation >= 90.0f ) || (attack_rotation <= -90.0f) ? -source.height : source.height };
         Rectangle target = (Rectangle){ attack_position.x - half_size, attack_position.y - half_size, size, size};
 
-        DrawTexturePro(sprite, source, target, origin, attack_rotation, WHITE);
+        batch_sprite_part(batch, sprite, part, target, origin, attack_rotation, WHITE);
     }
 }
-void particles_render_effects (const GameState * state, Unit * unit) {
+void particles_render_effects (const GameState * state, const Unit * unit, ListSpriteQuad * batch) {
     usize i = unit->effects.len;
     while (i --> 0) {
-        MagicEffect * effect = &unit->effects.items[i];
+        const MagicEffect * effect = &unit->effects.items[i];
         isize frame = (isize)(state->turn) % 100;
 
         switch (effect->type) {
@@ -361,21 +498,17 @@ void particles_render_effects (const GameState * state, Unit * unit) {
                 float half_scale = scale * 0.5f;
                 Rectangle target = (Rectangle){unit->position.x, unit->position.y, scale, scale};
 
-                Texture2D sprite = state->resources->particles[PARTICLE_PLUS];
-                Rectangle source = (Rectangle){0, 0, sprite.width, sprite.height};
-                DrawTexturePro(sprite, source, target, (Vector2){half_scale, half_scale}, 0.0f, WHITE);
+                batch_sprite(batch, state->resources->particles[PARTICLE_PLUS], target, (Vector2){half_scale, half_scale}, 0.0f, WHITE);
             } break;
             case MAGIC_WEAKNESS: {
                 isize actual_frame = frame >= 50 ? 100 - frame : frame;
                 float horizontal = ( actual_frame - 25 ) * 0.1f;
                 float vertical = (actual_frame >= 25 ? 50 - actual_frame : actual_frame) * (frame >= 50 ? 0.1f : -0.1f);
 
-                Texture2D sprite = state->resources->particles[PARTICLE_TORNADO];
                 float size = UNIT_SIZE * 0.5f;
                 float half_size = size * 0.5f;
                 Rectangle target = (Rectangle){horizontal + unit->position.x, vertical + unit->position.y, size, size};
-                Rectangle source = (Rectangle){0, 0, sprite.width, sprite.height};
-                DrawTexturePro(sprite, source, target, (Vector2){half_size, half_size}, 0.0f, WHITE);
+                batch_sprite(batch, state->resources->particles[PARTICLE_TORNADO], target, (Vector2){half_size, half_size}, 0.0f, WHITE);
             } break;
         }
 
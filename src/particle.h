@@ -7,12 +7,14 @@
 float animation_curve_evaluate (AnimationCurve curve, float point);
 
 /* Particles *****************************************************************/
+Result particles_init (ParticleSystem * particles);
+void particles_deinit (ParticleSystem * particles);
 void particles_blood (GameState * state, Unit * unit, Attack attack);
 void particles_magic (GameState * state, Unit * caster, Unit * target);
-void particles_render (Particle ** particles, usize len);
-void particles_render_effects (const GameState * state, Unit * unit);
-void particles_render_attacks (const GameState * state, Unit * attacked);
-void particles_advance (Particle ** particles, usize len, float delta_time);
+void particles_render (const GameState * state);
+void particles_render_effects (const GameState * state, const Unit * unit, ListSpriteQuad * batch);
+void particles_render_attacks (const GameState * state, const Unit * attacked, ListSpriteQuad * batch);
+void particles_advance (GameState * state, float delta_time);
 void particles_clean (GameState * state);
 
 
@@ -5,6 +5,7 @@
 #include "units.h"
 #include "math.h"
 #include "alloc.h"
+#include "nav_stats.h"
 #include <raymath.h>
 
 implementList(WayPoint*, WayPoint)
@@ -225,6 +226,7 @@ Result nav_init_region (Region * region) {
             intersections.len = 0;
         }
     }
+    listVector2Deinit(&intersections);
 
     if (actual_points == 0) {
         TraceLog(LOG_ERROR, " !Couldn't create any waypoint");
@@ -236,7 +238,143 @@ Result nav_init_region (Region * region) {
 
     return SUCCESS;
 }
+Result nav_init_from_mask (NavGraph * graph, const uchar * mask) {
+    GlobalNavGrid * global = graph->global;
+    if (graph->offset_x + graph->width > global->width || graph->offset_y + graph->height > global->height) {
+        TraceLog(LOG_ERROR, " !Nav graph doesn't fit inside of the global grid");
+        return FAILURE;
+    }
+
+    graph->waypoints = listWayPointInit(graph->width * graph->height, perm_allocator());
+    if (graph->waypoints.items == NULL) {
+        TraceLog(LOG_ERROR, " !Failed to initialize waypoint array");
+        return FAILURE;
+    }
+    clear_memory(graph->waypoints.items, sizeof(WayPoint *) * graph->waypoints.cap);
+    graph->waypoints.len = graph->waypoints.cap;
+
+    for (usize yi = 0; yi < graph->height; yi ++) {
+        for (usize xi = 0; xi < graph->width; xi ++) {
+            usize index = graph->width * yi + xi;
+            if (mask[index] == 0) continue;
+
+            usize global_x = xi + graph->offset_x;
+            usize global_y = yi + graph->offset_y;
+            usize global_index = global->width * global_y + global_x;
+            if (global->waypoints.items[global_index] != NULL) {
+                TraceLog(LOG_ERROR, " !Nav graph overlaps with another graph");
+                goto fail;
+            }
+
+            WayPoint * way = MemAlloc(sizeof(WayPoint));
+            if (way == NULL) {
+                TraceLog(LOG_ERROR, " !Failed to allocate waypoint");
+                goto fail;
+            }
+            clear_memory(way, sizeof(WayPoint));
+            way->graph = graph;
+            way->nav_world_pos_x = global_x;
+            way->nav_world_pos_y = global_y;
+            nav_position_global_world(global, global_x, global_y, &way->world_position);
+
+            graph->waypoints.items[index] = way;
+            global->waypoints.items[global_index] = way;
+        }
+    }
+    return SUCCESS;
+
+    fail:
+    // waypoints are owned by the global grid, only the graph slots need to be released here
+    listWayPointDeinit(&graph->waypoints);
+    return FAILURE;
+}
+Result nav_instance_graph (NavGraph * graph, const NavGraph * prefab, GlobalNavGrid * global) {
+    graph->type = prefab->type;
+    graph->width = prefab->width;
+    graph->height = prefab->height;
+    graph->offset_x = prefab->offset_x;
+    graph->offset_y = prefab->offset_y;
+    graph->global = global;
+
+    // paths that didn't connect to regions never got a graph
+    if (prefab->waypoints.items == NULL)
+        return SUCCESS;
+
+    graph->waypoints = listWayPointInit(prefab->waypoints.len, perm_allocator());
+    if (graph->waypoints.items == NULL) {
+        TraceLog(LOG_ERROR, " !Failed to initialize waypoint array");
+        return FAILURE;
+    }
+    graph->waypoints.len = prefab->waypoints.len;
+    for (usize w = 0; w < prefab->waypoints.len; w++) {
+        const WayPoint * point = prefab->waypoints.items[w];
+        graph->waypoints.items[w] = point ? nav_instance_waypoint(global, point) : NULL;
+    }
+    return SUCCESS;
+}
+Result nav_init_instance (Map * map, const Map * prefab) {
+    const GlobalNavGrid * source = &prefab->nav_grid;
+    if (nav_init_global_grid(map)) {
+        return FAILURE;
+    }
+    GlobalNavGrid * global = &map->nav_grid;
+    if (global->width != source->width || global->height != source->height) {
+        TraceLog(LOG_ERROR, "!Map size doesn't match its prefab");
+        return FAILURE;
+    }
+
+    usize count = 0;
+    for (usize i = 0; i < source->waypoints.len; i++) {
+        if (source->waypoints.items[i]) count ++;
+    }
+    global->pool = MemAlloc(sizeof(WayPoint) * (count ? count : 1));
+    if (global->pool == NULL) {
+        TraceLog(LOG_ERROR, "!Failed to allocate waypoints for the map");
+        return FAILURE;
+    }
+
+    usize next = 0;
+    for (usize i = 0; i < source->waypoints.len; i++) {
+        const WayPoint * from = source->waypoints.items[i];
+        if (from == NULL) continue;
+
+        WayPoint * way = &global->pool[next ++];
+        *way = *from;
+        way->unit = NULL;
+        if (from->graph->type == GRAPH_REGION) {
+            way->graph = &map->regions.items[from->graph->region - prefab->regions.items].nav_graph;
+        }
+        else {
+            way->graph = &map->paths.items[from->graph->path - prefab->paths.items].nav_graph;
+        }
+        global->waypoints.items[i] = way;
+    }
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        NavGraph * graph = &map->regions.items[r].nav_graph;
+        if (nav_instance_graph(graph, &prefab->regions.items[r].nav_graph, global)) {
+            return FAILURE;
+        }
+        graph->region = &map->regions.items[r];
+    }
+    for (usize p = 0; p < map->paths.len; p++) {
+        NavGraph * graph = &map->paths.items[p].nav_graph;
+        if (nav_instance_graph(graph, &prefab->paths.items[p].nav_graph, global)) {
+            return FAILURE;
+        }
+        graph->path = &map->paths.items[p];
+    }
+    return SUCCESS;
+}
 void nav_deinit_global (GlobalNavGrid * nav) {
+    NAV_STAT(nav_stats_forget(nav));
+    if (nav->pool) {
+        MemFree(nav->pool);
+        nav->pool = NULL;
+        listWayPointDeinit(&nav->waypoints);
+        listFindPointDeinit(&nav->find_buffer);
+        return;
+    }
     for (usize y = 0; y < nav->height; y++) {
         for (usize x = 0; x < nav->width; x++) {
             WayPoint * point = nav->waypoints.items[nav->width * y + x];
@@ -250,6 +388,9 @@ void nav_deinit_global (GlobalNavGrid * nav) {
 }
 
 /* Lookups *******************************************************************/
+WayPoint * nav_instance_waypoint (const GlobalNavGrid * nav, const WayPoint * prefab_point) {
+    return nav->waypoints.items[nav->width * prefab_point->nav_world_pos_y + prefab_point->nav_world_pos_x];
+}
 Result nav_find_waypoint (const NavGraph * graph, Vector2 point, WayPoint ** nullable_result) {
     if (point.x < 0.0f || point.y < 0.0f)
         return FAILURE;
@@ -285,6 +426,7 @@ Result nav_range_search (WayPoint * start, NavRangeSearchContext * context) {
     isize height = grid->height;
     isize x = start->nav_world_pos_x - 1;
     isize y = start->nav_world_pos_y - 1;
+    NAV_STAT(usize probed = 0);
 
     while (remaining > 0) {
         while (step --> 0) {
@@ -293,6 +435,7 @@ Result nav_range_search (WayPoint * start, NavRangeSearchContext * context) {
             if (x >= width || y >= height)
                 goto skip;
 
+            NAV_STAT(probed ++);
             WayPoint * point = grid->waypoints.items[grid->width * y + x];
             if (point && point->unit) {
                 bool found;
@@ -309,6 +452,7 @@ Result nav_range_search (WayPoint * start, NavRangeSearchContext * context) {
                     switch (context->amount) {
                         case NAV_CONTEXT_SINGLE: {
                             context->unit_found = point->unit;
+                            NAV_STAT(nav_stats_range(context->caller, probed));
                             return SUCCESS;
                         } break;
                         case NAV_CONTEXT_LIST: {
@@ -337,6 +481,7 @@ Result nav_range_search (WayPoint * start, NavRangeSearchContext * context) {
         dir = (dir + 1) % 4;
         step = length;
     }
+    NAV_STAT(nav_stats_range(context->caller, probed));
 
     switch (context->amount) {
         case NAV_CONTEXT_SINGLE: return FAILURE;
@@ -429,6 +574,8 @@ int find_point_eql(FindPoint * a, FindPoint * b) {
 
 Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result) {
     HeapFindPoint heap;
+    NAV_STAT(NavPathStats stats = { .calls = 1 });
+    NAV_STAT(float now = GetTime());
     if (heapFindPointInit(start->graph->waypoints.len, &heap, temp_allocator(), find_point_compare, find_point_eql)) {
         goto failure;
     }
@@ -457,6 +604,7 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
     wayfind->visited = true;
     wayfind->queued = true;
     heapFindPointAppend(&heap, wayfind);
+    NAV_STAT(stats.pushed ++);
 
     isize neighbor_index[8] = {
         -grid->width - 1, -grid->width, 1 - grid->width,
@@ -471,6 +619,8 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
         usize index = (usize)wayfind - (usize)&grid->find_buffer.items[0];
         index /= sizeof(FindPoint);
         WayPoint * point = grid->waypoints.items[index];
+        NAV_STAT(stats.expanded ++);
+        NAV_STAT(nav_stats_expand(grid, index, now));
 
         switch (target.type) {
             case NAV_TARGET_REGION: {
@@ -592,6 +742,7 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
                             TraceLog(LOG_ERROR, "Failed to update waypoint in the heap");
                             goto failure;
                         }
+                        NAV_STAT(stats.heap_updates ++);
                     }
                     else {
                         find->queued = true;
@@ -599,6 +750,7 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
                             TraceLog(LOG_ERROR, "Failed to reappend waypoint to the heap");
                             goto failure;
                         }
+                        NAV_STAT(stats.pushed ++);
                     }
                 }
             }
@@ -611,6 +763,7 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
                     TraceLog(LOG_ERROR, "Failed to append waypoint find to the heap");
                     goto failure;
                 }
+                NAV_STAT(stats.pushed ++);
             }
         }
 
@@ -618,6 +771,8 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
 
     failure:
     result->len = 0;
+    NAV_STAT(stats.failures = 1);
+    NAV_STAT(nav_stats_path(target.caller, &stats));
     return FAILURE;
 
     success:
@@ -646,6 +801,8 @@ Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result)
         result->items[other_side] = result->items[i];
         result->items[i] = swap;
     }
+    NAV_STAT(stats.path_length = result->len);
+    NAV_STAT(nav_stats_path(target.caller, &stats));
     return SUCCESS;
 }
 
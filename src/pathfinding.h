@@ -14,9 +14,22 @@ typedef enum {
     NAV_CONTEXT_HOSTILE,
 } NavContextType;
 
+/// What asked for the search, only used to break down the debug statistics
+typedef enum {
+    NAV_CALLER_OTHER,
+    NAV_CALLER_CHASE,
+    NAV_CALLER_TRANSIT,
+    NAV_CALLER_WANDER,
+    NAV_CALLER_SIGHT,
+    NAV_CALLER_ATTACK,
+    NAV_CALLER_SUPPORT,
+    NAV_CALLER_COUNT,
+} NavCaller;
+
 typedef struct {
     NavContextType type;
     NavContextCounter amount;
+    NavCaller caller;
     usize player_id;
     usize range;
     union {
@@ -32,6 +45,7 @@ typedef enum {
 
 typedef struct {
     NavTargetType type;
+    NavCaller caller;
     bool approach_only;
     union {
         Region * region;
@@ -43,13 +57,16 @@ typedef struct {
 Result nav_init_global_grid (Map * map);
 Result nav_init_path        (Path * path);
 Result nav_init_region      (Region * region);
+Result nav_init_from_mask   (NavGraph * graph, const uchar * mask);
+Result nav_init_instance    (Map * map, const Map * prefab);
 void   nav_deinit_global    (GlobalNavGrid * nav);
 
 /* Lookup *********************************************************************/
-Result nav_find_waypoint (const NavGraph * graph, Vector2 point, WayPoint ** nullable_result);
-Result nav_range_search  (WayPoint * start, NavRangeSearchContext * context);
-Test   nav_find_enemies  (NavGraph * graph, usize player_id, ListUnit * result);
-Result nav_gather_points (WayPoint * around, ListWayPoint * result);
+Result     nav_find_waypoint     (const NavGraph * graph, Vector2 point, WayPoint ** nullable_result);
+Result     nav_range_search      (WayPoint * start, NavRangeSearchContext * context);
+Test       nav_find_enemies      (NavGraph * graph, usize player_id, ListUnit * result);
+Result     nav_gather_points     (WayPoint * around, ListWayPoint * result);
+WayPoint * nav_instance_waypoint (const GlobalNavGrid * nav, const WayPoint * prefab_point);
 
 /* Pathfinding ***************************************************************/
 Result nav_find_path (WayPoint * start, NavTarget target, ListWayPoint * result);
@@ -0,0 +1,156 @@
+#include "picking.h"
+#include "level.h"
+#include "constants.h"
+#include "std.h"
+#include <math.h>
+
+/* Building ******************************************************************/
+usize picking_column (const PickingGrid * grid, float x) {
+    if (x <= 0.0f) return 0;
+    usize column = x / NAV_GRID_SIZE;
+    return column < grid->width ? column : grid->width - 1;
+}
+usize picking_row (const PickingGrid * grid, float y) {
+    if (y <= 0.0f) return 0;
+    usize row = y / NAV_GRID_SIZE;
+    return row < grid->height ? row : grid->height - 1;
+}
+void picking_fill_region (PickingGrid * grid, const Region * region, uint16_t index, float * crossings) {
+    const ListLine * lines = &region->area.lines;
+    if (lines->len == 0) return;
+    Rectangle bounds = area_bounds(&region->area);
+    usize row_min = picking_row(grid, bounds.y);
+    usize row_max = picking_row(grid, bounds.y + bounds.height);
+
+    // cells are filled by whether their center is inside, same even-odd rule area_contains_point uses
+    for (usize y = row_min; y <= row_max; y++) {
+        float center = (y + 0.5f) * NAV_GRID_SIZE;
+        usize count = 0;
+        for (usize i = 0; i < lines->len; i++) {
+            Vector2 a = lines->items[i].a;
+            Vector2 b = lines->items[i].b;
+            if ((a.y <= center) == (b.y <= center)) continue;
+            float x = a.x + (center - a.y) * (b.x - a.x) / (b.y - a.y);
+            usize at = count ++;
+            while (at > 0 && crossings[at - 1] > x) {
+                crossings[at] = crossings[at - 1];
+                at --;
+            }
+            crossings[at] = x;
+        }
+        for (usize i = 0; i + 1 < count; i += 2) {
+            float from = ceilf(crossings[i] / NAV_GRID_SIZE - 0.5f);
+            float to = floorf(crossings[i + 1] / NAV_GRID_SIZE - 0.5f);
+            if (to < 0.0f || from >= grid->width) continue;
+            for (usize x = from < 0.0f ? 0 : from; x <= to && x < grid->width; x++) {
+                PickCell * cell = &grid->cells[y * grid->width + x];
+                // overlapping regions go to the first one, like in region_by_position
+                if (cell->region == 0) cell->region = index;
+            }
+        }
+    }
+
+    // anything an edge passes through can't be decided by the cell center alone
+    for (usize i = 0; i < lines->len; i++) {
+        Rectangle edge = get_line_bounds(lines->items[i]);
+        usize x_max = picking_column(grid, edge.x + edge.width);
+        usize y_max = picking_row(grid, edge.y + edge.height);
+        for (usize y = picking_row(grid, edge.y); y <= y_max; y++) {
+            for (usize x = picking_column(grid, edge.x); x <= x_max; x++) {
+                grid->cells[y * grid->width + x].flags |= PICK_REGION_EDGE;
+            }
+        }
+    }
+}
+void picking_mark_point (PickingGrid * grid, Vector2 point, uint16_t first, uint16_t second, uint8_t end, Test building) {
+    usize x_min = picking_column(grid, point.x - PICKING_RADIUS);
+    usize x_max = picking_column(grid, point.x + PICKING_RADIUS);
+    usize y_min = picking_row(grid, point.y - PICKING_RADIUS);
+    usize y_max = picking_row(grid, point.y + PICKING_RADIUS);
+    for (usize y = y_min; y <= y_max; y++) {
+        for (usize x = x_min; x <= x_max; x++) {
+            Rectangle rect = { x * NAV_GRID_SIZE, y * NAV_GRID_SIZE, NAV_GRID_SIZE, NAV_GRID_SIZE };
+            if (CheckCollisionCircleRec(point, PICKING_RADIUS, rect) == false) continue;
+
+            PickCell * cell = &grid->cells[y * grid->width + x];
+            if (building) {
+                if (cell->building) cell->flags |= PICK_BUILDING_OVERLAP;
+                else {
+                    cell->building_region = first;
+                    cell->building = second;
+                }
+            }
+            else {
+                if (cell->path) cell->flags |= PICK_PATH_OVERLAP;
+                else {
+                    cell->path = first;
+                    cell->path_end = end;
+                }
+            }
+        }
+    }
+}
+
+/* Lifetime ******************************************************************/
+Result picking_init (Map * map) {
+    PickingGrid * grid = &map->picking;
+    clear_memory(grid, sizeof(PickingGrid));
+    if (map->regions.len >= UINT16_MAX || map->paths.len >= UINT16_MAX) {
+        TraceLog(LOG_WARNING, "Map has too many regions or paths for picking grid, picking will test every object");
+        return SUCCESS;
+    }
+
+    usize max_lines = 0;
+    for (usize r = 0; r < map->regions.len; r++) {
+        const Region * region = &map->regions.items[r];
+        if (region->area.lines.len > max_lines) max_lines = region->area.lines.len;
+        if (region->buildings.len >= UINT16_MAX) {
+            TraceLog(LOG_WARNING, "Region has too many buildings for picking grid, picking will test every object");
+            return SUCCESS;
+        }
+    }
+
+    grid->width = map->width / NAV_GRID_SIZE + 1;
+    grid->height = map->height / NAV_GRID_SIZE + 1;
+    usize count = grid->width * grid->height;
+    grid->cells = MemAlloc(sizeof(PickCell) * count);
+    float * crossings = MemAlloc(sizeof(float) * (max_lines + 1));
+    if (grid->cells == NULL || crossings == NULL) {
+        TraceLog(LOG_ERROR, "Failed to allocate picking grid of %zux%zu cells", grid->width, grid->height);
+        if (crossings) MemFree(crossings);
+        picking_deinit(map);
+        return FAILURE;
+    }
+    clear_memory(grid->cells, sizeof(PickCell) * count);
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        const Region * region = &map->regions.items[r];
+        picking_fill_region(grid, region, r + 1, crossings);
+        for (usize b = 0; b < region->buildings.len; b++) {
+            picking_mark_point(grid, region->buildings.items[b].position, r + 1, b + 1, 0, YES);
+        }
+    }
+    for (usize p = 0; p < map->paths.len; p++) {
+        const Path * path = &map->paths.items[p];
+        if (path->lines.len == 0) continue;
+        picking_mark_point(grid, path->lines.items[0].a, p + 1, 0, 0, NO);
+        picking_mark_point(grid, path->lines.items[path->lines.len - 1].b, p + 1, 0, 1, NO);
+    }
+
+    MemFree(crossings);
+    return SUCCESS;
+}
+void picking_deinit (Map * map) {
+    if (map->picking.cells) MemFree(map->picking.cells);
+    clear_memory(&map->picking, sizeof(PickingGrid));
+}
+
+/* Queries *******************************************************************/
+const PickCell * picking_cell (const Map * map, Vector2 point) {
+    const PickingGrid * grid = &map->picking;
+    if (grid->cells == NULL || point.x < 0.0f || point.y < 0.0f) return NULL;
+    usize x = point.x / NAV_GRID_SIZE;
+    usize y = point.y / NAV_GRID_SIZE;
+    if (x >= grid->width || y >= grid->height) return NULL;
+    return &grid->cells[y * grid->width + x];
+}
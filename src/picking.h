@@ -0,0 +1,20 @@
+#ifndef PICKING_H_
+#define PICKING_H_
+
+#include <raylib.h>
+#include "types.h"
+
+typedef enum {
+    // region edge crosses the cell, the point needs to be tested against the area
+    PICK_REGION_EDGE      = 1 << 0,
+    // more than one building or path end is within picking radius of the cell
+    PICK_BUILDING_OVERLAP = 1 << 1,
+    PICK_PATH_OVERLAP     = 1 << 2,
+} PickFlags;
+
+Result           picking_init   (Map * map);
+void             picking_deinit (Map * map);
+/// Cell under the point, NULL when it's outside of the map or the map has no picking grid
+const PickCell * picking_cell   (const Map * map, Vector2 point);
+
+#endif // PICKING_H_
@@ -0,0 +1,186 @@
+#include "profiler.h"
+#include "constants.h"
+#include "std.h"
+#include "alloc.h"
+#include "assets.h"
+#include <stdio.h>
+
+#if defined(PROFILER)
+typedef struct {
+    const char * name;
+    double       start;
+    double       end;
+    usize        depth;
+} ProfileEvent;
+
+typedef struct {
+    const char * name;
+    usize        depth;
+    double       time;
+    usize        calls;
+} ProfileTotal;
+
+typedef struct {
+    // zones of the frame in progress, in the order they started
+    ProfileEvent   events[PROFILER_EVENTS];
+    usize          event_count;
+    usize          stack[PROFILER_DEPTH];
+    usize          depth;
+    double         frame_start;
+    bool           running;
+    // times added up over frames for the overlay
+    ProfileTotal   totals[PROFILER_EVENTS];
+    usize          total_count;
+    usize          total_frames;
+    ProfileTotal   shown[PROFILER_EVENTS];
+    usize          shown_count;
+    bool           overlay;
+    // most fingers down since the screen was last let go of
+    int            touches;
+    // frames being recorded for a trace
+    ProfileEvent * capture;
+    usize          capture_count;
+    usize          capture_cap;
+    usize          capture_frames;
+} Profiler;
+
+Profiler profiler = {0};
+
+/* Zones *********************************************************************/
+void profiler_begin (const char * name) {
+    if (profiler.event_count >= PROFILER_EVENTS || profiler.depth >= PROFILER_DEPTH) {
+        // still counted so the matching end doesn't close the wrong zone, the slot is marked as not recorded
+        if (profiler.depth < PROFILER_DEPTH) profiler.stack[profiler.depth] = PROFILER_EVENTS;
+        profiler.depth ++;
+        return;
+    }
+    usize index = profiler.event_count ++;
+    profiler.events[index] = (ProfileEvent){ .name = name, .start = GetTime(), .depth = profiler.depth + 1 };
+    profiler.stack[profiler.depth ++] = index;
+}
+void profiler_end () {
+    if (profiler.depth == 0) {
+        TraceLog(LOG_WARNING, "Profiler zone ended without being started");
+        return;
+    }
+    profiler.depth --;
+    if (profiler.depth >= PROFILER_DEPTH) return;
+    usize index = profiler.stack[profiler.depth];
+    if (index == PROFILER_EVENTS) return;
+    profiler.events[index].end = GetTime();
+}
+
+/* Frames ********************************************************************/
+void profiler_add_total (const ProfileEvent * event) {
+    for (usize i = 0; i < profiler.total_count; i++) {
+        ProfileTotal * total = &profiler.totals[i];
+        if (total->name == event->name && total->depth == event->depth) {
+            total->time += event->end - event->start;
+            total->calls ++;
+            return;
+        }
+    }
+    if (profiler.total_count >= PROFILER_EVENTS) return;
+    profiler.totals[profiler.total_count ++] = (ProfileTotal){
+        .name  = event->name,
+        .depth = event->depth,
+        .time  = event->end - event->start,
+        .calls = 1,
+    };
+}
+void profiler_write_trace () {
+    // the working directory isn't writable on android
+    const char * path = cache_path(TextFormat("trace-%.0f.json", GetTime() * 1000.0), &temp_alloc);
+    FILE * file = fopen(path, "w");
+    if (file == NULL) {
+        TraceLog(LOG_ERROR, "Failed to open %s for the profiler trace", path);
+        return;
+    }
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (usize i = 0; i < profiler.capture_count; i++) {
+        const ProfileEvent * event = &profiler.capture[i];
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}\n",
+            i ? "," : "", event->name, event->start * 1000000.0, (event->end - event->start) * 1000000.0);
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+    TraceLog(LOG_INFO, "Profiler trace of %zu events written to %s", profiler.capture_count, path);
+}
+void profiler_capture (usize frames) {
+    if (profiler.capture) return;
+    profiler.capture_cap = frames * (PROFILER_EVENTS + 1);
+    profiler.capture = MemAlloc(sizeof(ProfileEvent) * profiler.capture_cap);
+    if (profiler.capture == NULL) {
+        TraceLog(LOG_ERROR, "Failed to allocate profiler capture of %zu frames", frames);
+        return;
+    }
+    profiler.capture_count = 0;
+    profiler.capture_frames = frames;
+    TraceLog(LOG_INFO, "Profiler capturing %zu frames", frames);
+}
+void profiler_frame () {
+    double now = GetTime();
+    if (profiler.depth) {
+        TraceLog(LOG_WARNING, "Profiler frame closed with %zu zones still open", profiler.depth);
+        profiler.depth = 0;
+    }
+    ProfileEvent frame = { .name = "frame", .start = profiler.frame_start, .end = now, .depth = 0 };
+
+    if (profiler.running) {
+        profiler_add_total(&frame);
+        for (usize i = 0; i < profiler.event_count; i++) {
+            profiler_add_total(&profiler.events[i]);
+        }
+        if (++ profiler.total_frames >= PROFILER_OVERLAY_FRAMES) {
+            for (usize i = 0; i < profiler.total_count; i++) {
+                profiler.totals[i].time /= profiler.total_frames;
+                profiler.shown[i] = profiler.totals[i];
+            }
+            profiler.shown_count = profiler.total_count;
+            profiler.total_count = 0;
+            profiler.total_frames = 0;
+        }
+
+        if (profiler.capture) {
+            profiler.capture[profiler.capture_count ++] = frame;
+            for (usize i = 0; i < profiler.event_count; i++) {
+                profiler.capture[profiler.capture_count ++] = profiler.events[i];
+            }
+            if (-- profiler.capture_frames == 0) {
+                profiler_write_trace();
+                MemFree(profiler.capture);
+                profiler.capture = NULL;
+            }
+        }
+    }
+
+    if (IsKeyPressed(PROFILER_OVERLAY_KEY)) profiler.overlay = ! profiler.overlay;
+    if (IsKeyPressed(PROFILER_CAPTURE_KEY)) profiler_capture(PROFILER_CAPTURE_FRAMES);
+
+    // fingers rarely land on the same frame so the gesture is decided once they are all lifted
+    int touches = GetTouchPointCount();
+    if (touches > profiler.touches) profiler.touches = touches;
+    if (touches == 0 && profiler.touches) {
+        if (profiler.touches == PROFILER_OVERLAY_TOUCHES) profiler.overlay = ! profiler.overlay;
+        if (profiler.touches == PROFILER_CAPTURE_TOUCHES) profiler_capture(PROFILER_CAPTURE_FRAMES);
+        profiler.touches = 0;
+    }
+
+    profiler.event_count = 0;
+    profiler.frame_start = now;
+    profiler.running = true;
+}
+
+/* Overlay *******************************************************************/
+void profiler_render (const Theme * theme) {
+    if (profiler.overlay == false) return;
+    float y = theme->info_bar_height + theme->margin;
+    for (usize i = 0; i < profiler.shown_count; i++) {
+        const ProfileTotal * total = &profiler.shown[i];
+        const char * text = TextFormat("%*s%s: %.3fms (%zu)",
+            (int)total->depth * 2, "", total->name, total->time * 1000.0, total->calls / PROFILER_OVERLAY_FRAMES);
+        DrawText(text, theme->margin, y, theme->font_size, theme->text);
+        y += theme->font_size;
+    }
+}
+#endif
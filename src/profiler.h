@@ -0,0 +1,27 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "types.h"
+
+/// Scoped timers for finding where frame time goes, they compile to nothing unless PROFILER is defined
+/// Zone names need to be string literals, only their pointers are kept
+#if defined(PROFILER)
+#define PROFILE_BEGIN(name) profiler_begin(name)
+#define PROFILE_END()       profiler_end()
+/// Closes the frame, call once per frame after EndDrawing
+#define PROFILE_FRAME()     profiler_frame()
+
+void profiler_begin  (const char * name);
+void profiler_end    ();
+void profiler_frame  ();
+/// Overlay with zone times averaged over recent frames, toggled with PROFILER_OVERLAY_KEY or PROFILER_OVERLAY_TOUCHES
+void profiler_render (const Theme * theme);
+/// Records the following frames and writes them out as Chrome trace events to the cache folder once done
+void profiler_capture (usize frames);
+#else
+#define PROFILE_BEGIN(name)
+#define PROFILE_END()
+#define PROFILE_FRAME()
+#endif
+
+#endif // PROFILER_H_
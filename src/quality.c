@@ -0,0 +1,77 @@
+#include "quality.h"
+#include "std.h"
+#include <math.h>
+
+const QualitySettings quality_levels[QUALITY_LEVEL_COUNT] = {
+    [QUALITY_HIGH] = {
+        .particles      = PARTICLES_MAX,
+        .health_rings   = true,
+        .animated_water = true,
+        .voices         = 32,
+    },
+    [QUALITY_MEDIUM] = {
+        .particles      = PARTICLES_MAX / 2,
+        .health_rings   = true,
+        .animated_water = true,
+        .voices         = 16,
+    },
+    [QUALITY_LOW] = {
+        .particles      = PARTICLES_MAX / 4,
+        .health_rings   = false,
+        .animated_water = true,
+        .voices         = 8,
+    },
+    [QUALITY_MINIMAL] = {
+        .particles      = PARTICLES_MAX / 8,
+        .health_rings   = false,
+        .animated_water = false,
+        .voices         = 4,
+    },
+};
+
+void quality_init (QualityGovernor * governor) {
+    clear_memory(governor, sizeof(QualityGovernor));
+    governor->level = QUALITY_HIGH;
+}
+void quality_update (QualityGovernor * governor, float frame_time, float tick_time, float interval) {
+    const float weight = 1.0f / QUALITY_AVERAGE_FRAMES;
+    const float budget = 1.0f / FPS;
+    // loading stalls would hold the average up long after they're over
+    interval = fminf(interval, budget * 4.0f);
+    governor->frame_time += (frame_time - governor->frame_time) * weight;
+    governor->tick_time += (tick_time - governor->tick_time) * weight;
+    governor->interval += (interval - governor->interval) * weight;
+    governor->frames_since_change ++;
+
+    // work time only covers submitting the frame, the interval shows when the gpu can't keep up with it
+    Test missed = governor->interval > budget * QUALITY_MISSED_AT ? YES : NO;
+    QualityLevel level = governor->level;
+    if (governor->frame_time > budget * QUALITY_LOWER_AT || missed) {
+        if (level + 1 < QUALITY_LEVEL_COUNT && governor->frames_since_change >= QUALITY_SETTLE_FRAMES) {
+            level ++;
+        }
+    }
+    else if (governor->frame_time < budget * QUALITY_RAISE_AT && missed == NO) {
+        if (level > QUALITY_HIGH && governor->frames_since_change >= QUALITY_SETTLE_FRAMES * 3) {
+            level --;
+        }
+    }
+    if (level == governor->level) return;
+
+    TraceLog(LOG_INFO, "Quality set to %s, frame %.2fms, tick %.2fms, interval %.2fms of %.2fms budget",
+        quality_name(level), governor->frame_time * 1000.0f, governor->tick_time * 1000.0f, governor->interval * 1000.0f, budget * 1000.0f);
+    governor->level = level;
+    governor->frames_since_change = 0;
+}
+QualitySettings quality_settings (const QualityGovernor * governor) {
+    return quality_levels[governor->level];
+}
+const char * quality_name (QualityLevel level) {
+    switch (level) {
+        case QUALITY_HIGH: return "high";
+        case QUALITY_MEDIUM: return "medium";
+        case QUALITY_LOW: return "low";
+        case QUALITY_MINIMAL: return "minimal";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef QUALITY_H_
+#define QUALITY_H_
+
+#include "types.h"
+
+void            quality_init     (QualityGovernor * governor);
+/// Takes the time spent working on the last frame and on its game tick, and the time between the last two frames, all in seconds
+void            quality_update   (QualityGovernor * governor, float frame_time, float tick_time, float interval);
+QualitySettings quality_settings (const QualityGovernor * governor);
+const char *    quality_name     (QualityLevel level);
+
+#endif // QUALITY_H_
@@ -0,0 +1,46 @@
+#include "random.h"
+
+uint64_t random_splitmix (uint64_t * state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+uint32_t random_rotate (uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+void random_seed (Random * random, uint64_t seed, RandomStream stream) {
+    // the stream is mixed in before expanding the seed, neighbouring streams would otherwise be the same sequence shifted by a step
+    uint64_t state = seed;
+    uint64_t stream_state = stream + 1;
+    state ^= random_splitmix(&stream_state);
+    uint64_t a = random_splitmix(&state);
+    uint64_t b = random_splitmix(&state);
+    random->state[0] = (uint32_t)a;
+    random->state[1] = (uint32_t)(a >> 32);
+    random->state[2] = (uint32_t)b;
+    random->state[3] = (uint32_t)(b >> 32);
+}
+uint32_t random_next (Random * random) {
+    uint32_t * s = random->state;
+    uint32_t result = random_rotate(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random_rotate(s[3], 11);
+    return result;
+}
+int random_range (Random * random, int min, int max) {
+    if (min > max) {
+        int swap = min;
+        min = max;
+        max = swap;
+    }
+    uint64_t span = (uint64_t)((int64_t)max - (int64_t)min) + 1;
+    // multiplying into the high bits spreads the value over the range without a division
+    return (int)((int64_t)min + (int64_t)(((uint64_t)random_next(random) * span) >> 32));
+}
@@ -0,0 +1,12 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include "types.h"
+
+/// Streams seeded with the same seed but a different stream number don't repeat each other
+void     random_seed  (Random * random, uint64_t seed, RandomStream stream);
+uint32_t random_next  (Random * random);
+/// Inclusive on both ends, same as GetRandomValue
+int      random_range (Random * random, int min, int max);
+
+#endif // RANDOM_H_
@@ -0,0 +1,100 @@
+#include "sprite.h"
+#include <rlgl.h>
+#include <stdlib.h>
+
+typedef struct {
+    SpriteStats  current;
+    SpriteStats  last;
+    unsigned int texture;
+} SpriteCounter;
+
+SpriteCounter sprite_counter = {0};
+
+/* Drawing *******************************************************************/
+Test sprite_loaded (Sprite sprite) {
+    return sprite.texture && sprite.texture->id ? YES : NO;
+}
+Rectangle sprite_source (Sprite sprite) {
+    if (sprite.source.width > 0 && sprite.source.height > 0) return sprite.source;
+    if (sprite.texture == NULL) return (Rectangle){0};
+    return (Rectangle){ 0, 0, sprite.texture->width, sprite.texture->height };
+}
+void draw_sprite_part (Sprite sprite, Rectangle part, Rectangle target, Vector2 origin, float rotation, Color tint) {
+    if (sprite_loaded(sprite) == NO) return;
+
+    Rectangle source = sprite_source(sprite);
+    source.x += part.x;
+    source.y += part.y;
+    source.width = part.width;
+    source.height = part.height;
+
+    sprite_counter.current.sprites ++;
+    if (sprite_counter.texture != sprite.texture->id) {
+        sprite_counter.texture = sprite.texture->id;
+        sprite_counter.current.texture_switches ++;
+    }
+    DrawTexturePro(*sprite.texture, source, target, origin, rotation, tint);
+}
+void draw_sprite (Sprite sprite, Rectangle target, Vector2 origin, float rotation, Color tint) {
+    Rectangle source = sprite_source(sprite);
+    draw_sprite_part(sprite, (Rectangle){ 0, 0, source.width, source.height }, target, origin, rotation, tint);
+}
+
+/* Batching ******************************************************************/
+void batch_sprite_part (ListSpriteQuad * batch, Sprite sprite, Rectangle part, Rectangle target, Vector2 origin, float rotation, Color tint) {
+    if (sprite_loaded(sprite) == NO) return;
+    SpriteQuad quad = {
+        .sprite   = sprite,
+        .part     = part,
+        .target   = target,
+        .origin   = origin,
+        .rotation = rotation,
+        .tint     = tint,
+        .order    = batch->len,
+    };
+    if (listSpriteQuadAppend(batch, quad)) {
+        // drawing right away keeps the sprite on screen, only out of order
+        draw_sprite_part(sprite, part, target, origin, rotation, tint);
+    }
+}
+void batch_sprite (ListSpriteQuad * batch, Sprite sprite, Rectangle target, Vector2 origin, float rotation, Color tint) {
+    Rectangle source = sprite_source(sprite);
+    batch_sprite_part(batch, sprite, (Rectangle){ 0, 0, source.width, source.height }, target, origin, rotation, tint);
+}
+int sprite_quad_compare (const void * a, const void * b) {
+    const SpriteQuad * left = a;
+    const SpriteQuad * right = b;
+    if (left->sprite.texture->id != right->sprite.texture->id) {
+        return left->sprite.texture->id < right->sprite.texture->id ? -1 : 1;
+    }
+    if (left->order != right->order) return left->order < right->order ? -1 : 1;
+    return 0;
+}
+void draw_sprite_batch (ListSpriteQuad * batch, Shader shader, int texel_location) {
+    if (batch->len == 0) return;
+    qsort(batch->items, batch->len, sizeof(SpriteQuad), sprite_quad_compare);
+
+    unsigned int texture = 0;
+    for (usize i = 0; i < batch->len; i++) {
+        const SpriteQuad * quad = &batch->items[i];
+        if (texel_location >= 0 && quad->sprite.texture->id != texture) {
+            texture = quad->sprite.texture->id;
+            // uniforms aren't part of the draw batch, sprites queued with the previous texture have to go out first
+            rlDrawRenderBatchActive();
+            Vector2 texel = { 1.0f / quad->sprite.texture->width, 1.0f / quad->sprite.texture->height };
+            SetShaderValue(shader, texel_location, &texel, SHADER_UNIFORM_VEC2);
+        }
+        draw_sprite_part(quad->sprite, quad->part, quad->target, quad->origin, quad->rotation, quad->tint);
+    }
+    batch->len = 0;
+}
+
+/* Stats *********************************************************************/
+void sprite_stats_frame () {
+    sprite_counter.last = sprite_counter.current;
+    sprite_counter.current = (SpriteStats){0};
+    sprite_counter.texture = 0;
+}
+SpriteStats sprite_stats () {
+    return sprite_counter.last;
+}
@@ -0,0 +1,31 @@
+#ifndef SPRITE_H_
+#define SPRITE_H_
+
+#include <raylib.h>
+#include "types.h"
+
+typedef struct {
+    usize sprites;
+    /// every texture change starts a new draw call inside raylib's render batch, so this is about the number of sprite draw calls
+    usize texture_switches;
+} SpriteStats;
+
+Test        sprite_loaded      (Sprite sprite);
+/// Area of the texture covered by the sprite
+Rectangle   sprite_source      (Sprite sprite);
+void        draw_sprite        (Sprite sprite, Rectangle target, Vector2 origin, float rotation, Color tint);
+/// Part is relative to the sprite, negative size flips it the same as with DrawTexturePro
+void        draw_sprite_part   (Sprite sprite, Rectangle part, Rectangle target, Vector2 origin, float rotation, Color tint);
+
+/// Queues the sprite to be drawn later together with others sharing its texture
+void        batch_sprite       (ListSpriteQuad * batch, Sprite sprite, Rectangle target, Vector2 origin, float rotation, Color tint);
+void        batch_sprite_part  (ListSpriteQuad * batch, Sprite sprite, Rectangle part, Rectangle target, Vector2 origin, float rotation, Color tint);
+/// Draws and empties the batch grouped by texture, texel size of each texture is passed to the shader when location isn't -1
+void        draw_sprite_batch  (ListSpriteQuad * batch, Shader shader, int texel_location);
+
+/// Finishes counting of the previous frame, called once at the start of each frame
+void        sprite_stats_frame ();
+/// Counts of the last finished frame
+SpriteStats sprite_stats       ();
+
+#endif // SPRITE_H_
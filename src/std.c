@@ -136,6 +136,36 @@ usize string_length (const char * string) {
     return len;
 }
 
+uint64_t hash_memory (const void * data, usize bytes) {
+    const uchar * d = (const uchar *) data;
+    uint64_t hash = 14695981039346656037ULL;
+    for (usize i = 0; i < bytes; i++) {
+        hash ^= d[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+Result write_bytes (ListUchar * buffer, const void * data, usize bytes) {
+    if (buffer->len + bytes > buffer->cap) {
+        usize cap = buffer->cap ? buffer->cap * 2 : 1024;
+        while (cap < buffer->len + bytes) cap *= 2;
+        if (listUcharGrow(buffer, cap)) {
+            return FAILURE;
+        }
+    }
+    copy_memory(&buffer->items[buffer->len], data, bytes);
+    buffer->len += bytes;
+    return SUCCESS;
+}
+Result read_bytes (const uchar * data, usize len, usize * cursor, void * out, usize bytes) {
+    if (*cursor + bytes > len) {
+        return FAILURE;
+    }
+    copy_memory(out, &data[*cursor], bytes);
+    *cursor += bytes;
+    return SUCCESS;
+}
+
 float get_time () {
     static float start_time = 0.0f;
     static int started = 0;
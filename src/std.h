@@ -23,5 +23,15 @@ char * convert_float_to_ascii (float number, unsigned int dot_count, Alloc alloc
 
 usize string_length (const char * string);
 
+/// 64 bit FNV-1a hash of the memory, used to detect changes in asset files
+uint64_t hash_memory (const void * data, usize bytes);
+
+/// Appends raw bytes at the end of the buffer
+Result write_bytes (ListUchar * buffer, const void * data, usize bytes);
+
+/// Copies bytes from data at cursor position and advances the cursor
+/// Fails without touching the output if there's not enough data left
+Result read_bytes (const uchar * data, usize len, usize * cursor, void * out, usize bytes);
+
 float get_time ();
 #endif // STD_H_
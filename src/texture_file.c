@@ -0,0 +1,77 @@
+#include "texture_file.h"
+#include "std.h"
+
+#define TEXTURE_FILE_MAGIC 0x54584C4C
+#define TEXTURE_FILE_VERSION 1
+
+// padded so pixels stay aligned the same as the archive blobs
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t mipmaps;
+    uint64_t data_size;
+} TextureFileHeader;
+
+usize texture_file_data_size (int width, int height, int format, int mipmaps) {
+    usize size = 0;
+    for (int level = 0; level < mipmaps; level++) {
+        size += GetPixelDataSize(width, height, format);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+/* Reading *******************************************************************/
+Test texture_file_is_raw (const uchar * data, usize len) {
+    uint32_t magic;
+    if (len < sizeof(TextureFileHeader))
+        return NO;
+    copy_memory(&magic, data, sizeof(uint32_t));
+    return magic == TEXTURE_FILE_MAGIC ? YES : NO;
+}
+Result texture_file_read (Image * result, const uchar * data, usize len) {
+    TextureFileHeader header;
+    usize cursor = 0;
+    if (read_bytes(data, len, &cursor, &header, sizeof(TextureFileHeader))) return FAILURE;
+    if (header.magic != TEXTURE_FILE_MAGIC || header.version != TEXTURE_FILE_VERSION) {
+        TraceLog(LOG_ERROR, "Texture has unsupported version %u, pack assets again", header.version);
+        return FAILURE;
+    }
+    if (header.width == 0 || header.height == 0 || header.mipmaps == 0 || header.width > INT16_MAX || header.height > INT16_MAX || header.mipmaps > 16) {
+        TraceLog(LOG_ERROR, "Texture has invalid size");
+        return FAILURE;
+    }
+    usize expected = texture_file_data_size(header.width, header.height, header.format, header.mipmaps);
+    if (expected == 0 || expected != header.data_size || header.data_size > len - cursor) {
+        TraceLog(LOG_ERROR, "Texture data doesn't match its size");
+        return FAILURE;
+    }
+
+    result->data    = (void *)&data[cursor];
+    result->width   = header.width;
+    result->height  = header.height;
+    result->format  = header.format;
+    result->mipmaps = header.mipmaps;
+    return SUCCESS;
+}
+
+/* Writing *******************************************************************/
+Result texture_file_write (const Image * image, ListUchar * buffer) {
+    TextureFileHeader header = {
+        .magic     = TEXTURE_FILE_MAGIC,
+        .version   = TEXTURE_FILE_VERSION,
+        .width     = image->width,
+        .height    = image->height,
+        .format    = image->format,
+        .mipmaps   = image->mipmaps,
+        .data_size = texture_file_data_size(image->width, image->height, image->format, image->mipmaps),
+    };
+    if (header.data_size == 0) return FAILURE;
+    if (write_bytes(buffer, &header, sizeof(TextureFileHeader))) return FAILURE;
+    if (write_bytes(buffer, image->data, header.data_size)) return FAILURE;
+    return SUCCESS;
+}
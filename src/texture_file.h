@@ -0,0 +1,14 @@
+#ifndef TEXTURE_FILE_H_
+#define TEXTURE_FILE_H_
+
+#include <raylib.h>
+#include "types.h"
+
+/// Pre-decoded textures are produced by tools/asset_packer.c out of png files
+/// Pixels are stored in a layout that can be uploaded to the gpu as it is, mipmaps follow the base level
+Test   texture_file_is_raw (const uchar * data, usize len);
+/// Image data points into the texture file, it must not be unloaded with UnloadImage
+Result texture_file_read   (Image * result, const uchar * data, usize len);
+Result texture_file_write  (const Image * image, ListUchar * buffer);
+
+#endif // TEXTURE_FILE_H_
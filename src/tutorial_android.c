@@ -7,9 +7,16 @@
 #include "ui.h"
 #include "audio.h"
 #include "level.h"
+#include "assets.h"
 #include "units.h"
 #include "cake.h"
 #include "particle.h"
+#include "sprite.h"
+#include "music.h"
+#include "ui_cache.h"
+#include "quality.h"
+#include "profiler.h"
+#include "nav_stats.h"
 #include "input.h"
 
 const char * blank_line = " ";
@@ -147,10 +154,10 @@ const char * tutorial_outro4 = "Tap here to play";
     X(blank_line, a, b) \
     X(tutorial_outro4, a, b)
 
-#define UPDATE_WIDTH(txt, theme, max_width) { int w = MeasureText(txt, theme->font_size); if (w > max_width) max_width = w; }
+#define UPDATE_WIDTH(txt, theme, max_width) { int w = measure_text(txt, theme->font_size); if (w > max_width) max_width = w; }
 #define UPDATE_HEIGHT(txt, theme, max_height) { max_height += theme->font_size + theme->spacing; }
 #define DRAW_TEXT(txt, theme, rec) { \
-    int w = MeasureText(txt, theme->font_size); \
+    int w = measure_text(txt, theme->font_size); \
     if (w > rec.width) { \
         rec = cake_grow_to(rec, w, theme->font_size); \
     } \
@@ -418,6 +425,11 @@ ExecutionMode tutorial_mode (Assets * assets, GameState * game) {
         listPlayerDataDeinit(&game->players);
         return EXE_MODE_MAIN_MENU;
     }
+    if (load_level_geometry(&assets->maps, map)) {
+        TraceLog(LOG_ERROR, "Couldn't load tutorial map");
+        listPlayerDataDeinit(&game->players);
+        return EXE_MODE_MAIN_MENU;
+    }
 
     if (game_state_prepare(game, map)) {
         listPlayerDataDeinit(&game->players);
@@ -446,8 +458,7 @@ ExecutionMode tutorial_mode (Assets * assets, GameState * game) {
     }
 
     Color player_color = get_player_color(1);
-    Music music = assets->faction_themes[FACTION_KNIGHTS];
-    PlayMusicStream(music);
+    music_play(assets->faction_themes[FACTION_KNIGHTS], MUSIC_CROSSFADE);
     InfoBarAction play_state = INFO_BAR_ACTION_NONE;
     usize winner = 0;
 
@@ -456,21 +467,28 @@ ExecutionMode tutorial_mode (Assets * assets, GameState * game) {
             break;
         }
         BeginDrawing();
+        double frame_start = GetTime();
+        sprite_stats_frame();
         ClearBackground(BLACK);
-        UpdateMusicStream(music);
+        float tick_time = 0.0f;
         if (play_state == INFO_BAR_ACTION_NONE) {
+            double tick_start = GetTime();
             game_tick(game);
+            tick_time = GetTime() - tick_start;
             if (tutorial_stage == TUTORIAL_DONE) winner = game_winner(game);
         }
 
         BeginMode2D(game->camera);
+            PROFILE_BEGIN("render");
             if (play_state == INFO_BAR_ACTION_NONE) {
-                render_interaction_hints(game);
+                PROFILE_BEGIN("hints"); render_interaction_hints(game); PROFILE_END();
             }
-            render_map_mesh(game);
-            render_units(game);
-            particles_render(game->particles_in_use.items, game->particles_in_use.len);
+            PROFILE_BEGIN("map");          render_map_mesh(game);  PROFILE_END();
+            PROFILE_BEGIN("render units"); render_units(game);     PROFILE_END();
+            PROFILE_BEGIN("particles");    particles_render(game); PROFILE_END();
+            PROFILE_END();
         EndMode2D();
+        PROFILE_BEGIN("ui");
 
         if (play_state == INFO_BAR_ACTION_NONE) {
             if (game->current_input != INPUT_MOVE_MAP) {
@@ -534,11 +552,22 @@ ExecutionMode tutorial_mode (Assets * assets, GameState * game) {
                 }
             } break;
         }
-        EndDrawing();
+        PROFILE_END();
+        quality_update(&game->quality, GetTime() - frame_start, tick_time, GetFrameTime());
+        #if !defined(RELEASE)
+        render_sprite_stats(&game->settings->theme);
+        render_quality_stats(&game->settings->theme, &game->quality);
+        nav_stats_render(&game->settings->theme);
+        #endif
+        #if defined(PROFILER)
+        profiler_render(&game->settings->theme);
+        #endif
+        PROFILE_BEGIN("present"); EndDrawing(); PROFILE_END();
+        PROFILE_FRAME();
         temp_reset();
     }
 
-    StopMusicStream(music);
+    music_play(assets->main_theme, MUSIC_CROSSFADE);
     end:
     game_state_deinit(game);
     return EXE_MODE_MAIN_MENU;
@@ -1,6 +1,7 @@
 #include "types.h"
 #include "std.h"
 
+implementList(uchar, Uchar)
 implementList(ushort, Ushort)
 implementList(usize, Usize)
 implementList(Vector2, Vector2)
@@ -13,7 +14,6 @@ implementList(Map, Map)
 implementList(MagicEffect, MagicEffect)
 implementList(Attack, Attack)
 implementList(Path*, PathP)
-implementList(Particle*, Particle)
 implementList(SoundEffect, SFX)
 implementList(AIRegionScore, AIRegionScore)
 implementList(AIRegionScore*, AIRegionScoreP)
@@ -21,6 +21,8 @@ implementList(AnimationFrame, Frame)
 
 implementList(Unit*, Unit)
 implementList(Region*, RegionP)
+implementList(SpriteQuad, SpriteQuad)
+implementList(HealthRing, HealthRing)
 
 char * faction_to_string (FactionType faction) {
     switch (faction) {
@@ -28,7 +28,6 @@ typedef struct WayPoint WayPoint;
 typedef struct FindPoint FindPoint;
 typedef struct NavGraph NavGraph;
 typedef struct GlobalNavGrid GlobalNavGrid;
-typedef struct Particle Particle;
 typedef struct SoundEffect SoundEffect;
 typedef struct AIRegionScore AIRegionScore;
 typedef struct AnimationFrame AnimationFrame;
@@ -67,7 +66,32 @@ typedef enum {
 #define true 1
 #endif
 
+/// Texture is shared between sprites packed into the same atlas
+/// Source with no size covers the whole texture
+typedef struct {
+    const Texture2D * texture;
+    Rectangle         source;
+} Sprite;
+
+/// Sprite waiting in a batch, drawn the same as with draw_sprite_part once the batch is flushed
+typedef struct {
+    Sprite    sprite;
+    Rectangle part;
+    Rectangle target;
+    Vector2   origin;
+    float     rotation;
+    Color     tint;
+    /// queueing order, kept between sprites sharing a texture
+    usize     order;
+} SpriteQuad;
+
+typedef struct {
+    Vector2 position;
+    float   percent;
+} HealthRing;
+
 makeList(Vector2, Vector2);
+makeList(uchar, Uchar);
 makeList(ushort, Ushort);
 makeList(usize, Usize);
 makeList(Line, Line);
@@ -79,7 +103,6 @@ makeList(Map, Map);
 makeList(MagicEffect, MagicEffect);
 makeList(Attack, Attack);
 makeList(Path*, PathP);
-makeList(Particle*, Particle);
 makeList(SoundEffect, SFX);
 makeList(AIRegionScore, AIRegionScore);
 makeList(AIRegionScore*, AIRegionScoreP);
@@ -90,6 +113,8 @@ makeList(WayPoint*, WayPoint);
 makeList(NavGraph, NavGraph);
 makeList(Unit*, Unit);
 makeList(Region*, RegionP);
+makeList(SpriteQuad, SpriteQuad);
+makeList(HealthRing, HealthRing);
 
 // @volitile=faction
 typedef enum FactionType {
@@ -164,6 +189,7 @@ typedef enum {
     ANIMATION_WALK,
     ANIMATION_ATTACK,
     ANIMATION_CAST,
+    ANIMATION_TYPE_COUNT,
 } AnimationType;
 
 typedef enum {
@@ -200,11 +226,40 @@ typedef enum {
     SOUND_UI_CLICK,
 } SoundEffectType;
 
+#define SOUND_EFFECT_COUNT (SOUND_UI_CLICK + 1)
+
 struct SoundEffect {
     SoundEffectType kind;
     Sound sound;
 };
 
+typedef struct {
+    /// alias of the sound effect, made when the match starts
+    Sound           sound;
+    SoundEffectType kind;
+    float           volume;
+    double          started;
+} Voice;
+
+/// Sound aliases for effects that play over each other, the pool doesn't grow during the match
+typedef struct {
+    Voice voices[VOICE_POOL_SIZE];
+    usize len;
+} VoicePool;
+
+/// Sounds of one kind requested close to each other on screen during a tick
+typedef struct {
+    SoundEffectType kind;
+    /// average screen position of the requests
+    Vector2         position;
+    usize           count;
+} SoundCluster;
+
+typedef struct {
+    SoundCluster clusters[SOUND_QUEUE_SIZE];
+    usize        len;
+} SoundQueue;
+
 typedef struct {
     Vector2 start;
     Vector2 start_handle;
@@ -212,20 +267,48 @@ typedef struct {
     Vector2 end;
 } AnimationCurve;
 
-struct Particle {
-    float lifetime;
-    float time_lived;
-    Color color_start;
-    Color color_end;
-    Vector2 position;
-    Vector2 velocity;
-    AnimationCurve velocity_curve;
-    AnimationCurve rotation_curve;
-    AnimationCurve scale_curve;
-    AnimationCurve alpha_curve;
-    AnimationCurve color_curve;
-    Texture2D * sprite;
-};
+typedef enum {
+    PARTICLE_PRESET_BLOOD,
+    PARTICLE_PRESET_CAST,
+    PARTICLE_PRESET_BLESSING,
+    PARTICLE_PRESET_WHIRL,
+    PARTICLE_PRESET_COUNT,
+} ParticlePreset;
+
+typedef enum {
+    PARTICLE_CURVE_VELOCITY,
+    PARTICLE_CURVE_ROTATION,
+    PARTICLE_CURVE_SCALE,
+    PARTICLE_CURVE_ALPHA,
+    PARTICLE_CURVE_COLOR,
+    PARTICLE_CURVE_COUNT,
+} ParticleCurve;
+
+#define PARTICLE_NO_SPRITE 0xff
+
+/// Particles kept field by field, live ones are packed at the front
+/// Removing a particle moves the last one into its place
+typedef struct {
+    usize     count;
+    float   * position_x;
+    float   * position_y;
+    float   * velocity_x;
+    float   * velocity_y;
+    float   * time_lived;
+    float   * lifetime;
+    /// rotation reached at the end of the rotation curve
+    float   * spin;
+    Color   * color_start;
+    Color   * color_end;
+    uint8_t * preset;
+    /// index into particle sprites or PARTICLE_NO_SPRITE for a plain square
+    uint8_t * sprite;
+    /// placement in the visibility grid, chunks and links are offset by one so 0 means none
+    usize   * chunk;
+    usize   * chunk_prev;
+    usize   * chunk_next;
+    void    * memory;
+} ParticleSystem;
 
 struct WayPoint {
     Vector2    world_position;
@@ -262,6 +345,8 @@ struct GlobalNavGrid {
     usize height;
     ListWayPoint waypoints;
     ListFindPoint find_buffer;
+    // maps instanced for a match keep all of their waypoints in one allocation
+    WayPoint * pool;
 } ;
 
 struct MagicEffect {
@@ -304,6 +389,11 @@ struct Unit {
     bool attacked;
 
     Building * origin;
+
+    // placement in the visibility grid, chunk is 0 while the unit isn't in it
+    usize  chunk;
+    Unit * chunk_prev;
+    Unit * chunk_next;
 };
 
 struct AnimationFrame {
@@ -312,7 +402,7 @@ struct AnimationFrame {
 };
 
 struct AnimationSet {
-    Texture2D sprite_sheet;
+    Sprite sprite_sheet;
     ListFrame frames;
 
     float idle_duration;
@@ -326,6 +416,9 @@ struct AnimationSet {
     uint8_t cast_start;
     uint8_t attack_trigger;
     uint8_t cast_trigger;
+
+    /// frame index for each animation sampled at even steps of its duration
+    uint8_t lookup[ANIMATION_TYPE_COUNT][ANIMATION_LOOKUP_SIZE];
 };
 
 struct Animations {
@@ -394,15 +487,42 @@ struct Region {
     Map         * map;
 };
 
+/// What can be picked at a spot of the map, indexes start at 1 so 0 means nothing is there
+typedef struct {
+    uint16_t region;
+    uint16_t building_region;
+    uint16_t building;
+    uint16_t path;
+    // 0 for the start of the path, 1 for its end
+    uint8_t  path_end;
+    uint8_t  flags;
+} PickCell;
+
+/// Nav sized cells over the whole map, built when the map is instanced for a match
+typedef struct {
+    PickCell * cells;
+    usize      width;
+    usize      height;
+} PickingGrid;
+
 struct Map {
     char        * name;
+    char        * path;
+    uint64_t      hash;
     usize         width;
     usize         height;
     uchar         player_count;
     ListRegion    regions;
     ListPath      paths;
     GlobalNavGrid nav_grid;
+    PickingGrid   picking;
     Model         background;
+    // maps are listed with only the metadata above, geometry is loaded when the map is picked
+    bool          loaded;
+    usize         last_used;
+    bool          prepared;
+    // set on maps instanced for a match, lines and models are borrowed from the prefab
+    const Map   * prefab;
 };
 
 typedef enum PlayerType {
@@ -452,14 +572,26 @@ typedef enum {
 } ExecutionMode;
 
 typedef struct {
-    Texture2D castle;
-    Texture2D fighter[3];
-    Texture2D archer[3];
-    Texture2D support[3];
-    Texture2D special[3];
-    Texture2D resource[3];
+    Sprite castle;
+    Sprite fighter[3];
+    Sprite archer[3];
+    Sprite support[3];
+    Sprite special[3];
+    Sprite resource[3];
 } BuildingSpriteSet;
 
+typedef struct {
+    /// sprites point at these, so they stay in place once loading starts
+    Texture2D     textures[SPRITE_TEXTURES_MAX];
+    usize         texture_count;
+    const uchar * atlas;
+    int           atlas_len;
+    /// texture slot of each atlas page, loaded once a sprite on it is requested
+    usize         pages[ATLAS_PAGES_MAX];
+    int           page_stage[ATLAS_PAGES_MAX];
+    Test          page_required[ATLAS_PAGES_MAX];
+} SpriteTextures;
+
 typedef struct {
     Texture2D  background_box;
     NPatchInfo background_box_info;
@@ -491,18 +623,20 @@ typedef struct {
 struct Assets {
     ListMap maps;
     Shader water_shader;
+    int water_time_location;
     Shader outline_shader;
-    Texture2D particles[PARTICLE_LAST + 1];
-    Particle particle_pool[PARTICLES_MAX];
+    int outline_texel_location;
+    SpriteTextures sprites;
+    Sprite particles[PARTICLE_LAST + 1];
     BuildingSpriteSet buildings[FACTION_LAST + 1];
-    Texture2D neutral_castle;
-    Texture2D flag;
+    Sprite neutral_castle;
+    Sprite flag;
     Music faction_themes[FACTION_LAST + 1];
     Music main_theme;
     Texture2D water_texture;
     Texture2D ground_texture;
     Texture2D bridge_texture;
-    Texture2D empty_building;
+    Sprite empty_building;
     ListSFX sound_effects;
     Animations animations;
     UiAssets ui;
@@ -546,6 +680,85 @@ typedef enum {
     INPUT_MOVE_MAP,
 } PlayerState;
 
+typedef struct {
+    /// regions, paths and buildings as seen through the camera, drawn again only when any of them changes
+    RenderTexture2D texture;
+    /// world area covered by the texture, a bit bigger than the screen so panning can reuse it
+    Rectangle       area;
+    float           zoom;
+    uint64_t        signature;
+} WorldLayer;
+
+typedef struct {
+    /// regions and paths overlapping the chunk, by index into the map lists
+    ListUsize  regions;
+    ListUsize  paths;
+    Unit     * units;
+    /// first particle in the chunk, offset by one
+    usize      particles;
+} VisibilityChunk;
+
+/// Coarse grid over the map so rendering only visits what the camera can see
+typedef struct {
+    VisibilityChunk * chunks;
+    usize             width;
+    usize             height;
+    /// regions and paths found by the last query have their stamp set to this
+    usize             stamp;
+    usize           * region_stamps;
+    usize           * path_stamps;
+} VisibilityGrid;
+
+typedef enum {
+    QUALITY_HIGH,
+    QUALITY_MEDIUM,
+    QUALITY_LOW,
+    QUALITY_MINIMAL,
+    QUALITY_LEVEL_COUNT,
+} QualityLevel;
+
+typedef struct {
+    /// particles alive at once, at most PARTICLES_MAX
+    usize particles;
+    bool  health_rings;
+    /// still water is drawn once into the world layer instead of every frame
+    bool  animated_water;
+    /// sound effects playing over each other
+    usize voices;
+} QualitySettings;
+
+/// Steps the quality down when frames take too long and back up once there's room again
+typedef struct {
+    QualityLevel level;
+    /// moving averages of the work done each frame and in the game tick, in seconds
+    float        frame_time;
+    float        tick_time;
+    /// moving average of the whole frame including the buffer swap, catches frames held up by the gpu
+    float        interval;
+    usize        frames_since_change;
+} QualityGovernor;
+
+typedef enum {
+    RANDOM_SIMULATION,
+    RANDOM_AI,
+    /// particles and sounds, they can be skipped by quality settings without changing how the match goes
+    RANDOM_PRESENTATION,
+    RANDOM_STREAMS,
+} RandomStream;
+
+/// xoshiro128** generator, each stream of a match owns one
+typedef struct {
+    uint32_t state[4];
+} Random;
+
+typedef struct {
+    /// unit sprites, drawn with the outline shader
+    ListSpriteQuad sprites;
+    /// attacks and magic effects drawn over the units
+    ListSpriteQuad effects;
+    ListHealthRing health;
+} UnitBatch;
+
 struct GameState {
     PlayerState      current_input;
     Vector2          selected_point;
@@ -555,12 +768,18 @@ struct GameState {
     Map              map;
     ListUnit         units;
     ListPlayerData   players;
-    ListParticle     particles_in_use;
-    ListParticle     particles_available;
+    ParticleSystem   particles;
     usize            turn;
     Camera2D         camera;
-    ListSFX          active_sounds;
-    ListSFX          disabled_sounds;
+    WorldLayer       world_layer;
+    VisibilityGrid   visibility;
+    UnitBatch        unit_batch;
+    QualityGovernor  quality;
+    VoicePool        voices;
+    SoundQueue       sound_queue;
+    /// same seed and player input play out the same match, picked at random when left at 0
+    uint64_t         seed;
+    Random           random[RANDOM_STREAMS];
     const Assets   * resources;
     const Settings * settings;
 };
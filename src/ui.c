@@ -10,6 +10,10 @@
 #include <raymath.h>
 #include <stdio.h>
 #include "audio.h"
+#include "sprite.h"
+#include "quality.h"
+#include "music.h"
+#include "ui_cache.h"
 
 /* Drawers *******************************************************************/
 void draw_button (
@@ -24,18 +28,18 @@ void draw_button (
     switch (label_layout) {
         case UI_LAYOUT_LEFT: {
             text_area = cake_carve_to(area, area.width - sides_width, theme->font_size);
-            int space = MeasureText(" ", theme->font_size);
+            int space = measure_text(" ", theme->font_size);
             text_area.x += space;
         } break;
         case UI_LAYOUT_CENTER: {
-            int label_width = MeasureText(text, theme->font_size);
+            int label_width = measure_text(text, theme->font_size);
             text_area = cake_carve_to(area, label_width, theme->font_size);
         } break;
         case UI_LAYOUT_RIGHT: {
-            int label_width = MeasureText(text, theme->font_size);
+            int label_width = measure_text(text, theme->font_size);
             text_area = cake_carve_to(area, area.width - sides_width, theme->font_size);
             text_area.x += area.width - label_width;
-            int space = MeasureText(" ", theme->font_size);
+            int space = measure_text(" ", theme->font_size);
             text_area.x -= space;
         } break;
     }
@@ -51,7 +55,7 @@ void draw_button (
 }
 void draw_building_button (
     Rectangle     area,
-    Texture2D     icon,
+    Sprite        icon,
     const char  * text,
     const char  * cost,
     float         cost_offset,
@@ -80,7 +84,7 @@ void draw_building_button (
         tex_color = theme->text_dark;
     }
     DrawTextureNPatch(theme->assets->button, theme->assets->button_info, area, (Vector2){0}, 0, but_color);
-    DrawTexturePro(icon, (Rectangle){0, 0, icon.width, icon.height}, image, Vector2Zero(), 0, WHITE);
+    draw_sprite(icon, image, Vector2Zero(), 0, WHITE);
     DrawText(text, label.x, label.y, theme->font_size, tex_color);
     DrawText(cost, label_cost.x, label_cost.y, theme->font_size, tex_color);
 }
@@ -105,11 +109,11 @@ void label (Rectangle area, const char * text, float size, UiLayout layout, cons
             text_area = cake_carve_to(area, area.width - sides_width - theme->margin * 2, size);
         } break;
         case UI_LAYOUT_CENTER: {
-            int label_width = MeasureText(text, size);
+            int label_width = measure_text(text, size);
             text_area = cake_carve_to(area, label_width, size);
         } break;
         case UI_LAYOUT_RIGHT: {
-            int label_width = MeasureText(text, size);
+            int label_width = measure_text(text, size);
             text_area = cake_carve_to(area, area.width - sides_width - theme->margin * 2, theme->font_size);
             text_area.x += area.width - label_width;
         } break;
@@ -169,27 +173,14 @@ void render_interaction_hints (const GameState * state) {
         #endif
     }
 
-    for (usize i = 0; i < region->buildings.len; i++) {
-        Building * b = &region->buildings.items[i];
-        if (CheckCollisionPointCircle(mouse, b->position, PLAYER_SELECTION_RADIUS)) {
-            render_interaction(state, b->position, player);
-            break;
-        }
+    Building * b = get_building_by_position(&state->map, mouse, PLAYER_SELECTION_RADIUS);
+    if (b && b->region == region) {
+        render_interaction(state, b->position, player);
     }
 
-    for (usize i = 0; i < region->paths.len; i++) {
-        Path * path = region->paths.items[i];
-        Vector2 point;
-        if (path->region_a == region) {
-            point = path->lines.items[0].a;
-        }
-        else {
-            point = path->lines.items[path->lines.len - 1].b;
-        }
-        if (CheckCollisionPointCircle(mouse, point, PLAYER_SELECTION_RADIUS)) {
-            render_interaction(state, point, player);
-            return;
-        }
+    Path * path = region_path_by_position(region, mouse, PLAYER_SELECTION_RADIUS);
+    if (path) {
+        render_interaction(state, path_end_in_region(path, region), player);
     }
 }
 void theme_update (Theme * theme) {
@@ -392,21 +383,21 @@ void render_empty_building_dialog (const GameState * state) {
 
     draw_background(dialog.area, theme);
 
-    Texture2D icon_fighter  = state->resources->buildings[faction].fighter[0];
-    Texture2D icon_archer   = state->resources->buildings[faction].archer[0];
-    Texture2D icon_support  = state->resources->buildings[faction].support[0];
-    Texture2D icon_special  = state->resources->buildings[faction].special[0];
-    Texture2D icon_resource = state->resources->buildings[faction].resource[0];
+    Sprite icon_fighter  = state->resources->buildings[faction].fighter[0];
+    Sprite icon_archer   = state->resources->buildings[faction].archer[0];
+    Sprite icon_support  = state->resources->buildings[faction].support[0];
+    Sprite icon_special  = state->resources->buildings[faction].special[0];
+    Sprite icon_resource = state->resources->buildings[faction].resource[0];
 
     const char * name_fighter  = building_name(BUILDING_FIGHTER  , faction, 0);
     const char * name_archer   = building_name(BUILDING_ARCHER   , faction, 0);
     const char * name_support  = building_name(BUILDING_SUPPORT  , faction, 0);
     const char * name_special  = building_name(BUILDING_SPECIAL  , faction, 0);
     const char * name_resource = building_name(BUILDING_RESOURCE , faction, 0);
-    float max_width = MeasureText(name_fighter, theme->font_size);
+    float max_width = measure_text(name_fighter, theme->font_size);
     {
         float width;
-        #define UPDATE_WIDTH(x) width = MeasureText(x, theme->font_size); \
+        #define UPDATE_WIDTH(x) width = measure_text(x, theme->font_size); \
         if (width > max_width) max_width = width;
 
         UPDATE_WIDTH(name_archer)
@@ -525,7 +516,7 @@ void render_upgrade_building_dialog (const GameState * state) {
     Rectangle r_level = cake_cut_horizontal(&dialog.label, theme->font_size, theme->spacing);
     Rectangle r_units = cake_cut_horizontal(&dialog.label, theme->font_size, theme->spacing);
 
-    r_title = cake_carve_width(r_title, MeasureText(text, theme->font_size * title_scale), 0.5f);
+    r_title = cake_carve_width(r_title, measure_text(text, theme->font_size * title_scale), 0.5f);
 
     DrawText(text, r_title.x, r_title.y, theme->font_size * title_scale, theme->text_dark);
     DrawText(lvl, r_level.x, r_level.y, theme->font_size, theme->text_dark);
@@ -543,7 +534,7 @@ void render_upgrade_building_dialog (const GameState * state) {
         else {
             snprintf(u_cost, 10, "Cost: %zu", cost);
         }
-        Texture2D icon = building_image(state->resources, faction, building->type, building->upgrades + 1);
+        Sprite icon = building_image(state->resources, faction, building->type, building->upgrades + 1);
         Test active = cost <= player->resource_gold;
 
         Rectangle button = cake_margin_all(dialog.upgrade, theme->margin + theme->frame_thickness);
@@ -568,13 +559,13 @@ void render_upgrade_building_dialog (const GameState * state) {
             tex_color = theme->text_dark;
         }
         DrawTextureNPatch(theme->assets->button, theme->assets->button_info, dialog.upgrade, (Vector2){0}, 0, but_color);
-        DrawTexturePro(icon, (Rectangle){0, 0, icon.width, icon.height}, image, Vector2Zero(), 0, WHITE);
+        draw_sprite(icon, image, Vector2Zero(), 0, WHITE);
         DrawText(u_label, label.x, label.y, theme->font_size, tex_color);
         DrawText(u_cost, label_cost.x, label_cost.y, theme->font_size, tex_color);
     }
     else {
         DrawTextureNPatch(theme->assets->button, theme->assets->button_info, dialog.upgrade, (Vector2){0}, 0, theme->button_inactive);
-        dialog.upgrade = cake_carve_to(dialog.upgrade, MeasureText("Max Level", theme->font_size), theme->font_size);
+        dialog.upgrade = cake_carve_to(dialog.upgrade, measure_text("Max Level", theme->font_size), theme->font_size);
         DrawText("Max Level", dialog.upgrade.x, dialog.upgrade.y, theme->font_size, theme->text_dark);
     }
 
@@ -590,8 +581,7 @@ void render_path_button (const GameState * state) {
     if (get_local_player_index(state, &player)) {
         player = 1;
     }
-    Texture2D flag = state->resources->flag;
-    DrawTexturePro(flag, (Rectangle) { 0, 0, flag.width, flag.height }, area, Vector2Zero(), 0, get_player_color(player));
+    draw_sprite(state->resources->flag, area, Vector2Zero(), 0, get_player_color(player));
 }
 void render_camera_controls (const GameState * state) {
     const Theme * theme = &state->settings->theme;
@@ -636,7 +626,7 @@ void render_winner (const GameState * state, usize winner) {
             snprintf(text, 256, "You lost! Player %zu is the Winner!", winner);
         }
     }
-    int width = MeasureText(text, theme->font_size) + theme->margin * 4 + theme->frame_thickness * 4;
+    int width = measure_text(text, theme->font_size) + theme->margin * 4 + theme->frame_thickness * 4;
 
     screen = cake_cut_horizontal(&screen, 0.5, 0);
     screen = cake_carve_to(screen, width, theme->font_size * 4.0f);
@@ -652,90 +642,122 @@ void render_winner (const GameState * state, usize winner) {
         winner_color.a -= alpha_step;
     }
 }
+typedef struct {
+    // what the layout was made for
+    usize       player;
+    FactionType faction;
+    usize       gold;
+    float       income;
+    float       upkeep;
+    int         screen_width;
+    Theme       theme;
+    // the layout
+    Rectangle   bar;
+    Rectangle   quit;
+    Rectangle   menu;
+    Rectangle   color;
+    Rectangle   fields[3];
+    char        labels[3][32];
+} ResourceBarLayout;
+
+ResourceBarLayout resource_bar = { .player = -1 };
+
+Test theme_same_layout (const Theme * a, const Theme * b) {
+    return a->font_size == b->font_size
+        && a->margin == b->margin
+        && a->spacing == b->spacing
+        && a->frame_thickness == b->frame_thickness
+        && a->info_bar_height == b->info_bar_height
+        && a->info_bar_field_width == b->info_bar_field_width ? YES : NO;
+}
+void resource_bar_label (ResourceBarLayout * layout, usize field, Rectangle * bar, const Theme * theme) {
+    int label_width = measure_text(layout->labels[field], theme->font_size);
+    if (label_width < theme->info_bar_field_width)
+        label_width = theme->info_bar_field_width;
+    layout->fields[field] = cake_cut_vertical(bar, label_width, theme->spacing);
+}
+void resource_bar_layout (ResourceBarLayout * layout, const Theme * theme) {
+    char * menu_label = "Settings";
+    char * quit_label = "Exit to Menu";
+    Rectangle bar = cake_rect(GetScreenWidth(), theme->info_bar_height);
+    layout->bar = bar;
+    bar = cake_margin_all(bar, theme->frame_thickness);
+
+    float quit_width = measure_text(quit_label, theme->font_size) + theme->margin * 2 + theme->frame_thickness * 2;
+    float menu_width = measure_text(menu_label, theme->font_size) + theme->margin * 2 + theme->frame_thickness * 2;
+    layout->quit = cake_cut_vertical(&bar, -quit_width, theme->spacing);
+    layout->menu = cake_cut_vertical(&bar, -menu_width, theme->spacing);
+
+    bar = cake_shrink_to(bar, theme->font_size);
+    layout->color = cake_cut_vertical(&bar, bar.height, theme->spacing);
+
+    const char * fmt = layout->faction == FACTION_KNIGHTS ? "Gold: %zu" : "Mana: %zu";
+    if (snprintf(layout->labels[0], sizeof(layout->labels[0]), fmt, layout->gold) <= 0) {
+        TextCopy(layout->labels[0], "too much...");
+    }
+    if (snprintf(layout->labels[1], sizeof(layout->labels[1]), "Income: %.1f/s ", layout->income) <= 0) {
+        TextCopy(layout->labels[1], "too much ...");
+    }
+    if (snprintf(layout->labels[2], sizeof(layout->labels[2]), "Upkeep: %.1f/s ", layout->upkeep) <= 0) {
+        TextCopy(layout->labels[2], "too much ...");
+    }
+    for (usize i = 0; i < 3; i++) {
+        resource_bar_label(layout, i, &bar, theme);
+    }
+}
 InfoBarAction render_resource_bar (const GameState * state) {
     usize player_index;
     if (get_local_player_index(state, &player_index)) {
         player_index = 1;
     }
     PlayerData * player = &state->players.items[player_index];
+    if (player->faction != FACTION_KNIGHTS && player->faction != FACTION_MAGES) {
+        TraceLog(LOG_FATAL, "Invalid player faction");
+        return 0;
+    }
 
     float income = get_expected_income(&state->map, player_index);
     float upkeep = get_expected_maintenance_cost(&state->map, player_index);
-
     const Theme * theme = &state->settings->theme;
-    Rectangle bar = cake_rect(GetScreenWidth(), theme->info_bar_height);
 
-    draw_background(bar, theme);
-    bar = cake_margin_all(bar, theme->frame_thickness);
+    // labels are formatted and measured again only when something on the bar changes
+    ResourceBarLayout * layout = &resource_bar;
+    bool changed = layout->player != player_index
+        || layout->faction != player->faction
+        || layout->gold != player->resource_gold
+        || layout->income != income
+        || layout->upkeep != upkeep
+        || layout->screen_width != GetScreenWidth()
+        || theme_same_layout(&layout->theme, theme) == NO;
+    if (changed) {
+        layout->player = player_index;
+        layout->faction = player->faction;
+        layout->gold = player->resource_gold;
+        layout->income = income;
+        layout->upkeep = upkeep;
+        layout->screen_width = GetScreenWidth();
+        layout->theme = *theme;
+        resource_bar_layout(layout, theme);
+    }
 
-    char * menu_label = "Settings";
-    char * quit_label = "Exit to Menu";
-    float quit_width = MeasureText(quit_label, theme->font_size) + theme->margin * 2 + theme->frame_thickness * 2;
-    float menu_width = MeasureText(menu_label, theme->font_size) + theme->margin * 2 + theme->frame_thickness * 2;
-    Rectangle quit = cake_cut_vertical(&bar, -quit_width, theme->spacing);
-    Rectangle menu = cake_cut_vertical(&bar, -menu_width, theme->spacing);
+    draw_background(layout->bar, theme);
     Vector2 cursor = GetMousePosition();
-    draw_button(quit, quit_label, cursor, UI_LAYOUT_CENTER, theme);
-    draw_button(menu, menu_label, cursor, UI_LAYOUT_CENTER, theme);
-
-    bar = cake_shrink_to(bar, theme->font_size);
+    draw_button(layout->quit, "Exit to Menu", cursor, UI_LAYOUT_CENTER, theme);
+    draw_button(layout->menu, "Settings", cursor, UI_LAYOUT_CENTER, theme);
 
-    Rectangle rect = cake_cut_vertical(&bar, bar.height, theme->spacing);
     Color player_color = get_player_color(player_index);
-    DrawRectangleRec(rect, theme->text_dark);
-    DrawRectangleRec(cake_margin_all(rect, 1), player_color);
+    DrawRectangleRec(layout->color, theme->text_dark);
+    DrawRectangleRec(cake_margin_all(layout->color, 1), player_color);
 
-    const usize buffer_size = 256;
-    char buffer[buffer_size];
-
-    const char * fmt;
-    switch (player->faction) {
-        case FACTION_KNIGHTS: fmt = "Gold: %zu"; break;
-        case FACTION_MAGES:   fmt = "Mana: %zu"; break;
-        default: TraceLog(LOG_FATAL, "Invalid player faction"); return 0;
-    }
-    char * label;
-    if (snprintf(buffer, buffer_size, fmt, player->resource_gold) <= 0) {
-        label = "too much...";
-    }
-    else {
-        label = buffer;
+    for (usize i = 0; i < 3; i++) {
+        DrawText(layout->labels[i], layout->fields[i].x, layout->fields[i].y, theme->font_size, theme->text_dark);
     }
-    int label_width = MeasureText(label, theme->font_size);
-    if (label_width < theme->info_bar_field_width)
-        label_width = theme->info_bar_field_width;
-    rect = cake_cut_vertical(&bar, label_width, theme->spacing);
-    DrawText(label , rect.x, rect.y, theme->font_size, theme->text_dark);
-
-    if (snprintf(buffer, buffer_size, "Income: %.1f/s ", income) <= 0) {
-        label = "too much ...";
-    }
-    else {
-        label = buffer;
-    }
-    label_width = MeasureText(label, theme->font_size);
-    if (label_width < theme->info_bar_field_width)
-        label_width = theme->info_bar_field_width;
-    rect = cake_cut_vertical(&bar, label_width, theme->spacing);
-    DrawText(label , rect.x, rect.y, theme->font_size, theme->text_dark);
-
-    if (snprintf(buffer, buffer_size, "Upkeep: %.1f/s ", upkeep) <= 0) {
-        label = "too much ...";
-    }
-    else {
-        label = buffer;
-    }
-    label_width = MeasureText(label, theme->font_size);
-    if (label_width < theme->info_bar_field_width)
-        label_width = theme->info_bar_field_width;
-    rect = cake_cut_vertical(&bar, label_width, theme->spacing);
-    DrawText(label , rect.x, rect.y, theme->font_size, theme->text_dark);
 
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-        if (CheckCollisionPointRec(cursor, menu)) {
+        if (CheckCollisionPointRec(cursor, layout->menu)) {
             return INFO_BAR_ACTION_SETTINGS;
         }
-        if (CheckCollisionPointRec(cursor, quit)) {
+        if (CheckCollisionPointRec(cursor, layout->quit)) {
             return INFO_BAR_ACTION_QUIT;
         }
     }
@@ -829,7 +851,7 @@ void render_player_select (Rectangle area, GameState * state, int selected_map)
     float frame = theme->frame_thickness + theme->margin;
 
     Rectangle title = cake_cut_horizontal(&area, theme->font_size + frame * 2, 0);
-    title = cake_diet_to(title, MeasureText(map->name, theme->font_size) + frame * 2);
+    title = cake_diet_to(title, measure_text(map->name, theme->font_size) + frame * 2);
     label(title, map->name, theme->font_size, UI_LAYOUT_CENTER, theme);
 
     area = cake_margin_all(area, theme->frame_thickness);
@@ -847,8 +869,8 @@ void render_player_select (Rectangle area, GameState * state, int selected_map)
     char name[64];
     char * player_control = "Controlling: ";
     char * player_faction = "Faction: ";
-    int player_control_size = MeasureText(player_control, theme->font_size);
-    int player_faction_size = MeasureText(player_faction, theme->font_size);
+    int player_control_size = measure_text(player_control, theme->font_size);
+    int player_faction_size = measure_text(player_faction, theme->font_size);
 
     static int selected_player = -1;
     static int choosing = -1; // 0 - PC/CPU, 1 - Faction
@@ -891,7 +913,7 @@ void render_player_select (Rectangle area, GameState * state, int selected_map)
         DrawTextureNPatch(drop_arrow, drop_arrow_patch, drop_area, (Vector2){0}, 0, mouse_over ? theme->button_hover : theme->button);
 
         char * player_control_label = player->type == PLAYER_LOCAL ? "Player" : "CPU";
-        int player_control_label_size = MeasureText(player_control_label, theme->font_size);
+        int player_control_label_size = measure_text(player_control_label, theme->font_size);
         label = cake_carve_to(select_player, player_control_label_size, theme->font_size);
         DrawText(player_control_label, label.x, label.y, theme->font_size, mouse_over ? theme->text : theme->text_dark);
 
@@ -907,7 +929,7 @@ void render_player_select (Rectangle area, GameState * state, int selected_map)
         DrawTextureNPatch(drop_arrow, drop_arrow_patch, drop_area, (Vector2){0}, 0, mouse_over ? theme->button_hover : theme->button);
 
         char * faction_name = faction_to_string(state->players.items[i + 1].faction);
-        int faction_name_size = MeasureText(faction_name, theme->font_size);
+        int faction_name_size = measure_text(faction_name, theme->font_size);
         label = cake_carve_to(select_player, faction_name_size, theme->font_size);
         DrawText(faction_name, label.x, label.y, theme->font_size, mouse_over ? theme->text : theme->text_dark);
     }
@@ -934,7 +956,7 @@ void render_player_select (Rectangle area, GameState * state, int selected_map)
                 }
 
                 draw_button(rect, faction_to_string(i), mouse, UI_LAYOUT_CENTER, theme);
-                /* rect = cake_carve_to(rect, MeasureText(faction_to_string(i), theme->font_size), theme->font_size); */
+                /* rect = cake_carve_to(rect, measure_text(faction_to_string(i), theme->font_size), theme->font_size); */
                 /* DrawText(faction_to_string(i), rect.x, rect.y, theme->font_size, mouse_over ? theme->text : theme->text_dark); */
             }
             if (clicked) {
@@ -1048,7 +1070,7 @@ Test render_settings (Rectangle area, Settings * settings, const Assets * assets
 
     Rectangle top_label = cake_cut_horizontal(&center, theme->font_size * 2 + frame, theme->font_size);
 
-    top_label = cake_carve_width(top_label, MeasureText(top_label_text, theme->font_size * 2) + frame, 0.5f);
+    top_label = cake_carve_width(top_label, measure_text(top_label_text, theme->font_size * 2) + frame, 0.5f);
 
     Rectangle master_volume_slider = cake_cut_horizontal(&center, line_height, theme->font_size);
     Rectangle music_volume_slider  = cake_cut_horizontal(&center, line_height, theme->font_size);
@@ -1058,10 +1080,10 @@ Test render_settings (Rectangle area, Settings * settings, const Assets * assets
     Rectangle fullscreen_check     = cake_cut_horizontal(&center, line_height, theme->font_size);
     #endif
 
-    float labels_width = MeasureText(master_label, theme->font_size);
+    float labels_width = measure_text(master_label, theme->font_size);
 
     {
-        #define UPDATE_WIDTH(x) width = MeasureText(x, theme->font_size); \
+        #define UPDATE_WIDTH(x) width = measure_text(x, theme->font_size); \
         if (width > labels_width) labels_width = width;
 
         float width;
@@ -1132,10 +1154,7 @@ Test render_settings (Rectangle area, Settings * settings, const Assets * assets
             else if (over_music) {
                 float local_pos = ( cursor.x - music_volume_slider.x ) / music_volume_slider.width;
                 settings->volume_music = local_pos;
-                for (usize i = 0; i <= FACTION_LAST; i++) {
-                    SetMusicVolume(assets->faction_themes[i], local_pos);
-                }
-                SetMusicVolume(assets->main_theme, local_pos);
+                music_volume(local_pos);
             }
             else if (over_sfx) {
                 float local_pos = ( cursor.x - sfx_volume_slider.x ) / sfx_volume_slider.width;
@@ -1204,3 +1223,20 @@ Test render_settings (Rectangle area, Settings * settings, const Assets * assets
     }
     return NO;
 }
+#if !defined(RELEASE)
+void render_sprite_stats (const Theme * theme) {
+    SpriteStats stats = sprite_stats();
+    const char * text = TextFormat("Sprites: %zu, texture switches: %zu", stats.sprites, stats.texture_switches);
+    DrawText(text, theme->margin, GetScreenHeight() - theme->font_size - theme->margin, theme->font_size, theme->text);
+}
+void render_quality_stats (const Theme * theme, const QualityGovernor * governor) {
+    const char * text = TextFormat(
+        "Quality: %s, frame: %.2fms, tick: %.2fms, interval: %.2fms",
+        quality_name(governor->level),
+        governor->frame_time * 1000.0f,
+        governor->tick_time * 1000.0f,
+        governor->interval * 1000.0f
+    );
+    DrawText(text, theme->margin, GetScreenHeight() - (theme->font_size + theme->margin) * 2, theme->font_size, theme->text);
+}
+#endif
@@ -96,5 +96,9 @@ void render_upgrade_building_dialog (const GameState * state);
 void render_empty_building_dialog   (const GameState * state);
 void render_path_button             (const GameState * state);
 void render_camera_controls         (const GameState * state);
+#if !defined(RELEASE)
+void render_sprite_stats            (const Theme * theme);
+void render_quality_stats           (const Theme * theme, const QualityGovernor * governor);
+#endif
 
 #endif // UI_H_
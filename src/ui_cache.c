@@ -0,0 +1,97 @@
+#include "ui_cache.h"
+#include "constants.h"
+#include "std.h"
+#include <rlgl.h>
+#include <raymath.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t hash;
+    usize    length;
+    float    size;
+    Vector2  measured;
+} TextMeasure;
+
+TextMeasure text_measures[UI_TEXT_CACHE_SIZE] = {0};
+
+/* Text Measuring ************************************************************/
+uint64_t ui_hash (uint64_t hash, const void * data, usize len) {
+    const uchar * bytes = data;
+    for (usize i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+Vector2 measure_text_size (const char * text, float size) {
+    usize length = strlen(text);
+    uint64_t hash = ui_hash(0xcbf29ce484222325ULL, text, length);
+    hash = ui_hash(hash, &size, sizeof(float));
+    // zero hash marks an empty slot
+    if (hash == 0) hash = 1;
+
+    TextMeasure * slot = &text_measures[hash % UI_TEXT_CACHE_SIZE];
+    if (slot->hash == hash && slot->length == length && slot->size == size) {
+        return slot->measured;
+    }
+    // DrawText truncates the size and spaces letters by whole pixels, measuring has to do the same
+    int font_size = (int)size;
+    if (font_size < 10) font_size = 10;
+    int spacing = font_size / 10;
+    slot->hash = hash;
+    slot->length = length;
+    slot->size = size;
+    slot->measured = MeasureTextEx(GetFontDefault(), text, (float)font_size, (float)spacing);
+    return slot->measured;
+}
+int measure_text (const char * text, float size) {
+    return measure_text_size(text, size).x;
+}
+
+/* Panels ********************************************************************/
+Test ui_panel_begin (UiPanel * panel, Rectangle area, uint64_t key) {
+    int width = area.width;
+    int height = area.height;
+    if (width <= 0 || height <= 0) return NO;
+
+    if (panel->texture.id == 0 || panel->texture.texture.width != width || panel->texture.texture.height != height) {
+        if (panel->texture.id) UnloadRenderTexture(panel->texture);
+        panel->texture = LoadRenderTexture(width, height);
+        if (panel->texture.id == 0) {
+            // drawn directly every frame instead
+            return YES;
+        }
+    }
+    else if (panel->key == key && panel->area.x == area.x && panel->area.y == area.y) {
+        return NO;
+    }
+    panel->area = area;
+    panel->key = key;
+
+    Camera2D camera = { .target = { area.x, area.y }, .zoom = 1.0f };
+    BeginTextureMode(panel->texture);
+    ClearBackground(BLANK);
+    BeginMode2D(camera);
+    // alpha is kept premultiplied so the panel blends the same as if it was drawn directly
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    return YES;
+}
+void ui_panel_end (UiPanel * panel) {
+    if (panel->texture.id == 0) return;
+    EndBlendMode();
+    EndMode2D();
+    EndTextureMode();
+}
+void ui_panel_draw (const UiPanel * panel) {
+    if (panel->texture.id == 0) return;
+    // render textures are stored upside down
+    Rectangle source = { 0, 0, panel->texture.texture.width, -panel->texture.texture.height };
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTexturePro(panel->texture.texture, source, panel->area, Vector2Zero(), 0.0f, WHITE);
+    EndBlendMode();
+}
+void ui_panel_unload (UiPanel * panel) {
+    if (panel->texture.id) UnloadRenderTexture(panel->texture);
+    clear_memory(panel, sizeof(UiPanel));
+}
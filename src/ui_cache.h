@@ -0,0 +1,28 @@
+#ifndef UI_CACHE_H_
+#define UI_CACHE_H_
+
+#include <raylib.h>
+#include "types.h"
+
+/// Part of the screen drawn once into a texture and reused until its area or key changes
+typedef struct {
+    RenderTexture2D texture;
+    Rectangle       area;
+    uint64_t        key;
+} UiPanel;
+
+/* Text Measuring ************************************************************/
+/// Same as MeasureText, the height comes along in the vector, results are cached by text contents and size
+int       measure_text      (const char * text, float size);
+Vector2   measure_text_size (const char * text, float size);
+
+/* Panels ********************************************************************/
+/// Returns YES when the panel needs to be drawn, drawing goes into the panel until ui_panel_end
+/// Key should cover everything that changes how the panel looks other than its area
+Test      ui_panel_begin    (UiPanel * panel, Rectangle area, uint64_t key);
+void      ui_panel_end      (UiPanel * panel);
+void      ui_panel_draw     (const UiPanel * panel);
+void      ui_panel_unload   (UiPanel * panel);
+uint64_t  ui_hash           (uint64_t hash, const void * data, usize len);
+
+#endif // UI_CACHE_H_
@@ -2,10 +2,14 @@
 #include "std.h"
 #include "game.h"
 #include "constants.h"
+#include "sprite.h"
 #include "particle.h"
 #include "animation.h"
 #include "unit_pool.h"
+#include "visibility.h"
+#include "quality.h"
 #include <raymath.h>
+#include <rlgl.h>
 
 
 /* Info **********************************************************************/
@@ -246,6 +250,7 @@ Unit * get_enemy_in_range (const Unit * unit) {
     NavRangeSearchContext context = {
         .type = NAV_CONTEXT_HOSTILE,
         .amount = NAV_CONTEXT_SINGLE,
+        .caller = NAV_CALLER_ATTACK,
         .player_id = unit->player_owned,
         .range = get_unit_range(unit),
     };
@@ -259,6 +264,7 @@ Unit * get_enemy_in_sight (const Unit * unit) {
     NavRangeSearchContext context = {
         .type = NAV_CONTEXT_HOSTILE,
         .amount = NAV_CONTEXT_SINGLE,
+        .caller = NAV_CALLER_SIGHT,
         .player_id = unit->player_owned,
         .range = UNIT_MAX_RANGE,
     };
@@ -274,6 +280,7 @@ Result get_enemies_in_range (const Unit * unit, ListUnit * result) {
     NavRangeSearchContext context = {
         .type = NAV_CONTEXT_HOSTILE,
         .amount = NAV_CONTEXT_LIST,
+        .caller = NAV_CALLER_ATTACK,
         .player_id = unit->player_owned,
         .range = get_unit_range(unit),
         .unit_list = result,
@@ -289,6 +296,7 @@ Result get_allies_in_range (const Unit * unit, ListUnit * result) {
     NavRangeSearchContext context = {
         .type = NAV_CONTEXT_FRIENDLY,
         .amount = NAV_CONTEXT_LIST,
+        .caller = NAV_CALLER_SUPPORT,
         .player_id = unit->player_owned,
         .range = get_unit_range(unit),
         .unit_list = result,
@@ -317,6 +325,7 @@ void unit_kill (GameState * state, Unit * unit) {
     for (usize i = 0; i < list->len; i++) {
         if (list->items[i] == unit) {
             listUnitRemove(list, i);
+            visibility_remove_unit(&state->visibility, unit);
             unit_deinit(unit);
             return;
         }
@@ -490,47 +499,93 @@ Result setup_unit_guardian (Region * region) {
 }
 
 /* Visuals *******************************************************************/
-void render_unit_health (const Unit * unit) {
+void batch_unit_health (ListHealthRing * batch, const Unit * unit) {
     float max_health = get_unit_health(unit->type, unit->faction, unit->upgrade);
     float health = unit->health;
     if (health >= max_health)
         return;
-    float percent = health / max_health;
-    float angle = percent * 360.0f * 0.5f + 180.0f;
-
-    Color color = (Color) {
-        .r = percent > 0.5f ? (unsigned char) (255 * (1.0f - percent)) : 255,
-        .g = percent < 0.5f ? (unsigned char) (255 * (percent + percent)) : 255,
-        .b = 0,
-        .a = 128,
-    };
+    HealthRing ring = { unit->position, health > 0.0f ? health / max_health : 0.0f };
+    listHealthRingAppend(batch, ring);
+}
+
+// directions along one half of the ring starting at its bottom, the other half mirrors them
+Vector2 health_ring_template[HEALTH_RING_SEGMENTS + 1];
+bool health_ring_template_ready = false;
 
-    DrawRing(unit->position, NAV_GRID_SIZE - 2.0f, NAV_GRID_SIZE, 360.0f - angle - 90.0f, angle - 90.0f, 16, color);
+void health_ring_segment (Vector2 center, Vector2 from, Vector2 to) {
+    const float inner = NAV_GRID_SIZE - 2.0f;
+    const float outer = NAV_GRID_SIZE;
+    rlVertex2f(center.x + from.x * inner, center.y + from.y * inner);
+    rlVertex2f(center.x + to.x * inner, center.y + to.y * inner);
+    rlVertex2f(center.x + from.x * outer, center.y + from.y * outer);
+
+    rlVertex2f(center.x + to.x * inner, center.y + to.y * inner);
+    rlVertex2f(center.x + to.x * outer, center.y + to.y * outer);
+    rlVertex2f(center.x + from.x * outer, center.y + from.y * outer);
 }
-void render_units (const GameState * state) {
-    const ListUnit * units = &state->units;
-    Vector2 top_left = GetScreenToWorld2D((Vector2) { -NAV_GRID_SIZE, -NAV_GRID_SIZE}, state->camera);
-    Vector2 bot_righ = GetScreenToWorld2D((Vector2) { GetScreenWidth() + NAV_GRID_SIZE, GetScreenHeight() + NAV_GRID_SIZE}, state->camera);
-    Rectangle screen = {
-        .x = top_left.x,
-        .y = top_left.y,
-        .width = bot_righ.x - top_left.x,
-        .height = bot_righ.y - top_left.y
-    };
+void render_health_rings (ListHealthRing * batch) {
+    if (batch->len == 0) return;
+    if (health_ring_template_ready == false) {
+        for (usize i = 0; i <= HEALTH_RING_SEGMENTS; i++) {
+            float angle = (90.0f + 180.0f * i / HEALTH_RING_SEGMENTS) * DEG2RAD;
+            health_ring_template[i] = (Vector2){ cosf(angle), sinf(angle) };
+        }
+        health_ring_template_ready = true;
+    }
+
+    for (usize i = 0; i < batch->len; i++) {
+        const HealthRing * ring = &batch->items[i];
+        float percent = ring->percent;
+        float segments = percent * HEALTH_RING_SEGMENTS;
+        usize whole = (usize)segments;
+        float end_angle = (90.0f + percent * 180.0f) * DEG2RAD;
+        Vector2 end = { cosf(end_angle), sinf(end_angle) };
+        Test partial = segments > whole ? YES : NO;
+
+        Color color = (Color) {
+            .r = percent > 0.5f ? (unsigned char) (255 * (1.0f - percent)) : 255,
+            .g = percent < 0.5f ? (unsigned char) (255 * (percent + percent)) : 255,
+            .b = 0,
+            .a = 128,
+        };
 
+        rlCheckRenderBatchLimit((whole + partial) * 12);
+        rlBegin(RL_TRIANGLES);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        for (usize s = 0; s < whole; s++) {
+            Vector2 a = health_ring_template[s];
+            Vector2 b = health_ring_template[s + 1];
+            health_ring_segment(ring->position, a, b);
+            health_ring_segment(ring->position, (Vector2){ -b.x, b.y }, (Vector2){ -a.x, a.y });
+        }
+        if (partial) {
+            Vector2 a = health_ring_template[whole];
+            health_ring_segment(ring->position, a, end);
+            health_ring_segment(ring->position, (Vector2){ -end.x, end.y }, (Vector2){ -a.x, a.y });
+        }
+        rlEnd();
+    }
+    batch->len = 0;
+}
+void render_units (GameState * state) {
+    UnitBatch * batch = &state->unit_batch;
+    VisibilityGrid * grid = &state->visibility;
+    Rectangle screen = visibility_view(state->camera, NAV_GRID_SIZE);
+    bool health_rings = quality_settings(&state->quality).health_rings;
+
+    visibility_mark(grid, screen);
     for (usize i = 0; i < state->map.regions.len; i++) {
         Region * region = &state->map.regions.items[i];
-        if (! CheckCollisionPointRec(region->castle.position, screen)) {
+        if (visibility_region_marked(grid, i) == NO || ! CheckCollisionPointRec(region->castle.position, screen)) {
             continue;
         }
-        Texture2D sprite;
+        Sprite sprite;
         if (region->player_id) {
             sprite = state->resources->buildings[region->faction].castle;
         }
         else {
             sprite = state->resources->neutral_castle;
         }
-        Rectangle source = (Rectangle) { 0, 0, sprite.width, sprite.height };
         Rectangle destination = (Rectangle){
             region->castle.position.x,
             region->castle.position.y,
@@ -538,29 +593,33 @@ void render_units (const GameState * state) {
             NAV_GRID_SIZE * 2,
         };
         Vector2 origin = (Vector2){ destination.width * 0.5f, destination.height * 0.5f };
-        DrawTexturePro(sprite, source, destination, origin, 0.0f, WHITE);
+        draw_sprite(sprite, destination, origin, 0.0f, WHITE);
 
-        particles_render_attacks(state, &region->castle);
-        particles_render_effects(state, &region->castle);
-        render_unit_health(&region->castle);
+        particles_render_attacks(state, &region->castle, &batch->effects);
+        particles_render_effects(state, &region->castle, &batch->effects);
+        if (health_rings) batch_unit_health(&batch->health, &region->castle);
     }
 
-    BeginShaderMode(state->resources->outline_shader);
-    for (usize i = 0; i < units->len; i ++) {
-        Unit * unit = units->items[i];
-
-        if (CheckCollisionPointRec(unit->position, screen)) {
-            animate_unit(state, unit);
+    // one pass queues everything, then units go out grouped by texture with effects and health drawn over them
+    ChunkRange range = visibility_range(grid, screen);
+    for (usize y = range.y_min; y <= range.y_max && grid->chunks; y++) {
+        for (usize x = range.x_min; x <= range.x_max; x++) {
+            for (const Unit * unit = visibility_chunk(grid, x, y)->units; unit; unit = unit->chunk_next) {
+                if (! CheckCollisionPointRec(unit->position, screen)) {
+                    continue;
+                }
+                animate_unit(state, unit, &batch->sprites);
+                particles_render_attacks(state, unit, &batch->effects);
+                particles_render_effects(state, unit, &batch->effects);
+                if (health_rings) batch_unit_health(&batch->health, unit);
+            }
         }
     }
-    EndShaderMode();
-    for (usize i = 0; i < units->len; i ++) {
-        Unit * unit = units->items[i];
 
-        if (CheckCollisionPointRec(unit->position, screen)) {
-            particles_render_attacks(state, unit);
-            particles_render_effects(state, unit);
-            render_unit_health(unit);
-        }
-    }
+    Shader outline = state->resources->outline_shader;
+    BeginShaderMode(outline);
+    draw_sprite_batch(&batch->sprites, outline, state->resources->outline_texel_location);
+    EndShaderMode();
+    draw_sprite_batch(&batch->effects, outline, -1);
+    render_health_rings(&batch->health);
 }
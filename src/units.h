@@ -39,6 +39,6 @@ Result get_allies_in_range    (const Unit * unit, ListUnit * result);
 void   unit_kill              (GameState * state, Unit * unit);
 
 /* Rendering *****************************************************************/
-void   render_units       (const GameState * state);
+void   render_units       (GameState * state);
 
 #endif // UNITS_H_
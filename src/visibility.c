@@ -0,0 +1,214 @@
+#include "visibility.h"
+#include "level.h"
+#include "std.h"
+#include "alloc.h"
+#include <raymath.h>
+
+#define VISIBILITY_CHUNK_SIZE ((float)NAV_GRID_SIZE * VISIBILITY_CHUNK_CELLS)
+
+/* Utilities *****************************************************************/
+Rectangle visibility_grow (Rectangle rect, Vector2 point) {
+    float right = fmaxf(rect.x + rect.width, point.x);
+    float bottom = fmaxf(rect.y + rect.height, point.y);
+    rect.x = fminf(rect.x, point.x);
+    rect.y = fminf(rect.y, point.y);
+    rect.width = right - rect.x;
+    rect.height = bottom - rect.y;
+    return rect;
+}
+Rectangle visibility_pad (Rectangle rect, float padding) {
+    return (Rectangle){ rect.x - padding, rect.y - padding, rect.width + padding * 2.0f, rect.height + padding * 2.0f };
+}
+usize visibility_column (const VisibilityGrid * grid, float x) {
+    if (x <= 0.0f) return 0;
+    usize column = x / VISIBILITY_CHUNK_SIZE;
+    return column < grid->width ? column : grid->width - 1;
+}
+usize visibility_row (const VisibilityGrid * grid, float y) {
+    if (y <= 0.0f) return 0;
+    usize row = y / VISIBILITY_CHUNK_SIZE;
+    return row < grid->height ? row : grid->height - 1;
+}
+usize visibility_chunk_at (const VisibilityGrid * grid, Vector2 point) {
+    return visibility_row(grid, point.y) * grid->width + visibility_column(grid, point.x);
+}
+// everything drawn for the region, buildings and flags stick out of the area a bit
+Rectangle visibility_region_bounds (const Region * region) {
+    Rectangle bounds = area_bounds(&region->area);
+    bounds = visibility_grow(bounds, region->castle.position);
+    for (usize b = 0; b < region->buildings.len; b++) {
+        bounds = visibility_grow(bounds, region->buildings.items[b].position);
+    }
+    for (usize p = 0; p < region->paths.len; p++) {
+        const Path * path = region->paths.items[p];
+        if (path->lines.len == 0) continue;
+        bounds = visibility_grow(bounds, path->lines.items[0].a);
+        bounds = visibility_grow(bounds, path->lines.items[path->lines.len - 1].b);
+    }
+    return visibility_pad(bounds, NAV_GRID_SIZE * 2);
+}
+
+/* Lifetime ******************************************************************/
+Result visibility_init (VisibilityGrid * grid, const Map * map) {
+    clear_memory(grid, sizeof(VisibilityGrid));
+    grid->width = map->width / VISIBILITY_CHUNK_SIZE + 1;
+    grid->height = map->height / VISIBILITY_CHUNK_SIZE + 1;
+
+    usize count = grid->width * grid->height;
+    grid->chunks = MemAlloc(sizeof(VisibilityChunk) * count);
+    grid->region_stamps = MemAlloc(sizeof(usize) * (map->regions.len + 1));
+    grid->path_stamps = MemAlloc(sizeof(usize) * (map->paths.len + 1));
+    if (grid->chunks == NULL || grid->region_stamps == NULL || grid->path_stamps == NULL) {
+        TraceLog(LOG_ERROR, "Failed to allocate visibility grid of %zux%zu chunks", grid->width, grid->height);
+        visibility_deinit(grid);
+        return FAILURE;
+    }
+    clear_memory(grid->chunks, sizeof(VisibilityChunk) * count);
+    clear_memory(grid->region_stamps, sizeof(usize) * (map->regions.len + 1));
+    clear_memory(grid->path_stamps, sizeof(usize) * (map->paths.len + 1));
+    for (usize i = 0; i < count; i++) {
+        grid->chunks[i].regions = listUsizeInit(2, perm_allocator());
+        grid->chunks[i].paths = listUsizeInit(2, perm_allocator());
+    }
+
+    for (usize r = 0; r < map->regions.len; r++) {
+        ChunkRange range = visibility_range(grid, visibility_region_bounds(&map->regions.items[r]));
+        for (usize y = range.y_min; y <= range.y_max; y++) {
+            for (usize x = range.x_min; x <= range.x_max; x++) {
+                if (listUsizeAppend(&visibility_chunk(grid, x, y)->regions, r)) goto failed;
+            }
+        }
+    }
+    for (usize p = 0; p < map->paths.len; p++) {
+        Rectangle bounds;
+        if (lines_bounds(&map->paths.items[p].lines, &bounds)) continue;
+        ChunkRange range = visibility_range(grid, visibility_pad(bounds, PATH_THICKNESS));
+        for (usize y = range.y_min; y <= range.y_max; y++) {
+            for (usize x = range.x_min; x <= range.x_max; x++) {
+                if (listUsizeAppend(&visibility_chunk(grid, x, y)->paths, p)) goto failed;
+            }
+        }
+    }
+    return SUCCESS;
+
+    failed:
+    TraceLog(LOG_ERROR, "Failed to sort the map into visibility chunks");
+    visibility_deinit(grid);
+    return FAILURE;
+}
+void visibility_deinit (VisibilityGrid * grid) {
+    if (grid->chunks) {
+        for (usize i = 0; i < grid->width * grid->height; i++) {
+            listUsizeDeinit(&grid->chunks[i].regions);
+            listUsizeDeinit(&grid->chunks[i].paths);
+        }
+        MemFree(grid->chunks);
+    }
+    if (grid->region_stamps) MemFree(grid->region_stamps);
+    if (grid->path_stamps) MemFree(grid->path_stamps);
+    clear_memory(grid, sizeof(VisibilityGrid));
+}
+
+/* Queries *******************************************************************/
+Rectangle visibility_view (Camera2D camera, float margin) {
+    Vector2 top_left = GetScreenToWorld2D((Vector2){ -margin, -margin }, camera);
+    Vector2 bot_righ = GetScreenToWorld2D((Vector2){ GetScreenWidth() + margin, GetScreenHeight() + margin }, camera);
+    return (Rectangle){
+        .x = top_left.x,
+        .y = top_left.y,
+        .width = bot_righ.x - top_left.x,
+        .height = bot_righ.y - top_left.y,
+    };
+}
+ChunkRange visibility_range (const VisibilityGrid * grid, Rectangle area) {
+    return (ChunkRange){
+        .x_min = visibility_column(grid, area.x),
+        .y_min = visibility_row(grid, area.y),
+        .x_max = visibility_column(grid, area.x + area.width),
+        .y_max = visibility_row(grid, area.y + area.height),
+    };
+}
+VisibilityChunk * visibility_chunk (const VisibilityGrid * grid, usize x, usize y) {
+    return &grid->chunks[y * grid->width + x];
+}
+void visibility_mark (VisibilityGrid * grid, Rectangle area) {
+    if (grid->chunks == NULL) return;
+    grid->stamp ++;
+    ChunkRange range = visibility_range(grid, area);
+    for (usize y = range.y_min; y <= range.y_max; y++) {
+        for (usize x = range.x_min; x <= range.x_max; x++) {
+            const VisibilityChunk * chunk = visibility_chunk(grid, x, y);
+            for (usize i = 0; i < chunk->regions.len; i++) {
+                grid->region_stamps[chunk->regions.items[i]] = grid->stamp;
+            }
+            for (usize i = 0; i < chunk->paths.len; i++) {
+                grid->path_stamps[chunk->paths.items[i]] = grid->stamp;
+            }
+        }
+    }
+}
+Test visibility_region_marked (const VisibilityGrid * grid, usize region) {
+    // without the grid everything counts as visible
+    if (grid->chunks == NULL) return YES;
+    return grid->region_stamps[region] == grid->stamp ? YES : NO;
+}
+Test visibility_path_marked (const VisibilityGrid * grid, usize path) {
+    if (grid->chunks == NULL) return YES;
+    return grid->path_stamps[path] == grid->stamp ? YES : NO;
+}
+
+/* Moving Things *************************************************************/
+void visibility_move_unit (VisibilityGrid * grid, Unit * unit) {
+    if (grid->chunks == NULL) return;
+    usize chunk = visibility_chunk_at(grid, unit->position) + 1;
+    if (unit->chunk == chunk) return;
+    visibility_remove_unit(grid, unit);
+
+    VisibilityChunk * target = &grid->chunks[chunk - 1];
+    unit->chunk = chunk;
+    unit->chunk_prev = NULL;
+    unit->chunk_next = target->units;
+    if (target->units) target->units->chunk_prev = unit;
+    target->units = unit;
+}
+void visibility_remove_unit (VisibilityGrid * grid, Unit * unit) {
+    if (grid->chunks == NULL || unit->chunk == 0) return;
+    if (unit->chunk_prev) unit->chunk_prev->chunk_next = unit->chunk_next;
+    else grid->chunks[unit->chunk - 1].units = unit->chunk_next;
+    if (unit->chunk_next) unit->chunk_next->chunk_prev = unit->chunk_prev;
+    unit->chunk = 0;
+    unit->chunk_prev = NULL;
+    unit->chunk_next = NULL;
+}
+void visibility_move_particle (VisibilityGrid * grid, ParticleSystem * particles, usize index) {
+    if (grid->chunks == NULL) return;
+    usize chunk = visibility_chunk_at(grid, (Vector2){ particles->position_x[index], particles->position_y[index] }) + 1;
+    if (particles->chunk[index] == chunk) return;
+    visibility_remove_particle(grid, particles, index);
+
+    VisibilityChunk * target = &grid->chunks[chunk - 1];
+    particles->chunk[index] = chunk;
+    particles->chunk_prev[index] = 0;
+    particles->chunk_next[index] = target->particles;
+    if (target->particles) particles->chunk_prev[target->particles - 1] = index + 1;
+    target->particles = index + 1;
+}
+void visibility_remove_particle (VisibilityGrid * grid, ParticleSystem * particles, usize index) {
+    if (grid->chunks == NULL || particles->chunk[index] == 0) return;
+    usize prev = particles->chunk_prev[index];
+    usize next = particles->chunk_next[index];
+    if (prev) particles->chunk_next[prev - 1] = next;
+    else grid->chunks[particles->chunk[index] - 1].particles = next;
+    if (next) particles->chunk_prev[next - 1] = prev;
+    particles->chunk[index] = 0;
+    particles->chunk_prev[index] = 0;
+    particles->chunk_next[index] = 0;
+}
+void visibility_renumber_particle (VisibilityGrid * grid, ParticleSystem * particles, usize index) {
+    if (grid->chunks == NULL || particles->chunk[index] == 0) return;
+    usize prev = particles->chunk_prev[index];
+    usize next = particles->chunk_next[index];
+    if (prev) particles->chunk_next[prev - 1] = index + 1;
+    else grid->chunks[particles->chunk[index] - 1].particles = index + 1;
+    if (next) particles->chunk_prev[next - 1] = index + 1;
+}
@@ -0,0 +1,35 @@
+#ifndef VISIBILITY_H_
+#define VISIBILITY_H_
+
+#include <raylib.h>
+#include "types.h"
+
+/// Chunks overlapping an area, inclusive on both ends
+typedef struct {
+    usize x_min;
+    usize y_min;
+    usize x_max;
+    usize y_max;
+} ChunkRange;
+
+Result            visibility_init          (VisibilityGrid * grid, const Map * map);
+void              visibility_deinit        (VisibilityGrid * grid);
+
+/// World area seen through the camera, grown by margin on each side
+Rectangle         visibility_view          (Camera2D camera, float margin);
+ChunkRange        visibility_range         (const VisibilityGrid * grid, Rectangle area);
+VisibilityChunk * visibility_chunk         (const VisibilityGrid * grid, usize x, usize y);
+/// Marks regions and paths that overlap the area, checked afterwards with the functions below
+void              visibility_mark          (VisibilityGrid * grid, Rectangle area);
+Test              visibility_region_marked (const VisibilityGrid * grid, usize region);
+Test              visibility_path_marked   (const VisibilityGrid * grid, usize path);
+
+/// Puts the unit into the grid or moves it to the chunk it walked into
+void              visibility_move_unit       (VisibilityGrid * grid, Unit * unit);
+void              visibility_remove_unit     (VisibilityGrid * grid, Unit * unit);
+void              visibility_move_particle   (VisibilityGrid * grid, ParticleSystem * particles, usize index);
+void              visibility_remove_particle (VisibilityGrid * grid, ParticleSystem * particles, usize index);
+/// Points the links at the particle's new slot after it was moved there from another
+void              visibility_renumber_particle (VisibilityGrid * grid, ParticleSystem * particles, usize index);
+
+#endif // VISIBILITY_H_
@@ -1,61 +1,430 @@
 #include <raylib.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include "../src/types.h"
+#include "../src/alloc.h"
+#include "../src/std.h"
+#include "../src/archive.h"
+#include "../src/lz.h"
+#include "../src/texture_file.h"
+#include "../src/atlas.h"
+
+// empty space kept around each sprite so filtering and outlines don't pick up its neighbours
+#define ATLAS_PADDING 2
+
+typedef struct {
+    char      * path;
+    uchar     * data;
+    int         len;
+    ListUchar   converted;
+    ListUchar   compressed;
+    // textures going into an atlas are kept decoded until pages are put together
+    bool        atlased;
+    Image       image;
+    AtlasRegion region;
+} PackedFile;
+
+// png files are decoded here so the game can upload pixels without inflating them
+Result convert_texture (PackedFile * file, bool mipmaps) {
+    if (IsFileExtension(file->path, ".png") == false) return SUCCESS;
+
+    Image image = LoadImageFromMemory(".png", file->data, file->len);
+    if (image.data == NULL) return FAILURE;
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (mipmaps) ImageMipmaps(&image);
+
+    file->converted = listUcharInit(GetPixelDataSize(image.width, image.height, image.format) * 2, perm_allocator());
+    Result result = texture_file_write(&image, &file->converted);
+    UnloadImage(image);
+    return result;
+}
+const uchar * file_contents (const PackedFile * file, usize * len) {
+    if (file->converted.len) {
+        *len = file->converted.len;
+        return file->converted.items;
+    }
+    *len = file->len;
+    return file->data;
+}
+
+// formats which are already compressed on their own are stored as they are
+// png files are listed since they're packed as decoded pixels
+Test is_compressible (const char * path) {
+    const char * extensions[] = { ".json", ".llmap", ".wav", ".fs", ".vs", ".png" };
+    for (usize i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+        if (IsFileExtension(path, extensions[i])) return YES;
+    }
+    return NO;
+}
+Result compress_file (PackedFile * file) {
+    if (is_compressible(file->path) == NO) return SUCCESS;
+
+    usize len;
+    const uchar * data = file_contents(file, &len);
+    file->compressed = listUcharInit(len, perm_allocator());
+    if (lz_compress(data, len, &file->compressed)) return FAILURE;
+
+    // not worth decompressing at load time when it barely shrinks
+    if (file->compressed.len > len / 8 * 7) {
+        listUcharDeinit(&file->compressed);
+        file->compressed = (ListUchar){0};
+    }
+    return SUCCESS;
+}
+
+/* Atlas *********************************************************************/
+Result decode_atlased (PackedFile * file) {
+    if (IsFileExtension(file->path, ".png") == false) {
+        file->atlased = false;
+        return SUCCESS;
+    }
+    file->image = LoadImageFromMemory(".png", file->data, file->len);
+    if (file->image.data == NULL) return FAILURE;
+    ImageFormat(&file->image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    // too big to share a page with anything, it's packed as a texture of its own
+    if (file->image.width > ATLAS_PAGE_SIZE || file->image.height > ATLAS_PAGE_SIZE) {
+        UnloadImage(file->image);
+        file->image = (Image){0};
+        file->atlased = false;
+    }
+    return SUCCESS;
+}
+int compare_atlased (const void * a, const void * b) {
+    const PackedFile * file_a = *(const PackedFile **)a;
+    const PackedFile * file_b = *(const PackedFile **)b;
+    if (file_a->image.height != file_b->image.height) return file_b->image.height - file_a->image.height;
+    return file_b->image.width - file_a->image.width;
+}
+// shelf packing, tallest textures first so shelves waste little height
+usize place_atlased (PackedFile ** sorted, usize count, int * page_heights) {
+    usize page = 0;
+    int x = 0;
+    int y = 0;
+    int shelf = 0;
+    for (usize i = 0; i < count; i++) {
+        Image * image = &sorted[i]->image;
+        if (x + image->width > ATLAS_PAGE_SIZE) {
+            x = 0;
+            y += shelf + ATLAS_PADDING;
+            shelf = 0;
+        }
+        if (y + image->height > ATLAS_PAGE_SIZE) {
+            page ++;
+            x = 0;
+            y = 0;
+            shelf = 0;
+        }
+        if (page >= ATLAS_PAGES_MAX) return 0;
+        sorted[i]->region = (AtlasRegion){
+            .path   = sorted[i]->path,
+            .page   = page,
+            .source = { x, y, image->width, image->height },
+        };
+        if (image->height > shelf) shelf = image->height;
+        if (y + shelf > page_heights[page]) page_heights[page] = y + shelf;
+        x += image->width + ATLAS_PADDING;
+    }
+    return count ? page + 1 : 0;
+}
+Result write_atlas_page (PackedFile * page_file, PackedFile ** sorted, usize count, usize page, int height, bool mipmaps) {
+    // pages keep power of two sizes so mipmaps and wrapping work on older gpus
+    int page_height = 1;
+    while (page_height < height) page_height *= 2;
+
+    Image image = {
+        .width   = ATLAS_PAGE_SIZE,
+        .height  = page_height,
+        .mipmaps = 1,
+        .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    usize size = GetPixelDataSize(image.width, image.height, image.format);
+    image.data = MemAlloc(size);
+    if (image.data == NULL) return FAILURE;
+    clear_memory(image.data, size);
+
+    for (usize i = 0; i < count; i++) {
+        if (sorted[i]->region.page != page) continue;
+        const Image * sprite = &sorted[i]->image;
+        Rectangle at = sorted[i]->region.source;
+        for (int row = 0; row < sprite->height; row++) {
+            uchar * to = (uchar *)image.data + ((usize)(at.y + row) * image.width + (usize)at.x) * 4;
+            const uchar * from = (const uchar *)sprite->data + (usize)row * sprite->width * 4;
+            copy_memory(to, from, (usize)sprite->width * 4);
+        }
+    }
+    if (mipmaps) ImageMipmaps(&image);
+
+    page_file->converted = listUcharInit(size * 2, perm_allocator());
+    Result result = texture_file_write(&image, &page_file->converted);
+    UnloadImage(image);
+    return result;
+}
+Result pack_atlas (PackedFile * files, usize * file_count, char (*names)[256], const char * folder, bool mipmaps) {
+    usize count = 0;
+    PackedFile ** sorted = MemAlloc(sizeof(PackedFile *) * (*file_count + 1));
+    if (sorted == NULL) return FAILURE;
+    for (usize f = 0; f < *file_count; f++) {
+        if (files[f].atlased) sorted[count ++] = &files[f];
+    }
+    if (count == 0) {
+        MemFree(sorted);
+        return SUCCESS;
+    }
+    qsort(sorted, count, sizeof(PackedFile *), compare_atlased);
+
+    Result result = FAILURE;
+    AtlasRegion * regions = NULL;
+    int page_heights[ATLAS_PAGES_MAX] = {0};
+    usize page_count = place_atlased(sorted, count, page_heights);
+    if (page_count == 0) {
+        fprintf(stderr, "Atlased textures don't fit in %d pages\n", ATLAS_PAGES_MAX);
+        goto done;
+    }
+
+    for (usize page = 0; page < page_count; page++) {
+        PackedFile * page_file = &files[*file_count];
+        snprintf(names[page + 1], 256, "%s/" ATLAS_PAGE_FILE, folder, page);
+        *page_file = (PackedFile){ .path = names[page + 1] };
+        if (write_atlas_page(page_file, sorted, count, page, page_heights[page], mipmaps)) {
+            listUcharDeinit(&page_file->converted);
+            goto done;
+        }
+        if (compress_file(page_file)) {
+            listUcharDeinit(&page_file->converted);
+            listUcharDeinit(&page_file->compressed);
+            goto done;
+        }
+        *file_count += 1;
+    }
+
+    // index keeps packing order so lookups find sprites of the same folder close together
+    regions = MemAlloc(sizeof(AtlasRegion) * count);
+    if (regions == NULL) goto done;
+    usize region_count = 0;
+    for (usize f = 0; f < *file_count; f++) {
+        if (files[f].atlased) regions[region_count ++] = files[f].region;
+    }
+    PackedFile * index = &files[*file_count];
+    snprintf(names[0], 256, "%s/" ATLAS_INDEX_FILE, folder);
+    *index = (PackedFile){ .path = names[0] };
+    index->converted = listUcharInit(1024, perm_allocator());
+    if (atlas_file_write(regions, region_count, page_count, &index->converted)) {
+        listUcharDeinit(&index->converted);
+        goto done;
+    }
+    *file_count += 1;
+    printf("Packed %zu textures into %zu atlas pages\n", count, page_count);
+    result = SUCCESS;
+
+    done:
+    MemFree(regions);
+    MemFree(sorted);
+    return result;
+}
+
+Result write_padding (ListUchar * buffer, usize alignment) {
+    static const uchar zeroes[ARCHIVE_ALIGNMENT] = {0};
+    usize padding = (alignment - buffer->len % alignment) % alignment;
+    return write_bytes(buffer, zeroes, padding);
+}
 
 int main (int argc, char ** argv) {
     if (argc < 3) {
-        fprintf(stderr, "Usage: %s [Asset Folder Path, ..Paths]\n", argv[0]);
-        fprintf(stderr, "  Asset packer will read data from provided files and convert them into a C header file\n");
-        fprintf(stderr, "  Resulting header file will be directed to stdout");
+        fprintf(stderr, "Usage: %s [--mipmaps] [Output Path] [Asset Paths..] [--atlas Atlas Folder] [Texture Paths..]\n", argv[0]);
+        fprintf(stderr, "  Asset packer will read data from provided files and write them into a single indexed archive\n");
+        fprintf(stderr, "  Assets are looked up in the archive by the same paths they were given to the packer\n");
+        fprintf(stderr, "  Png textures are stored decoded, --mipmaps adds a full mip chain to each of them\n");
+        fprintf(stderr, "  Textures after --atlas are packed into shared pages, stored with their index in the atlas folder\n");
+        return 1;
+    }
+    const uint16_t endianness = 1;
+    if (*(const uchar *)&endianness != 1) {
+        fprintf(stderr, "Archives are little endian, the packer can't run on this machine\n");
         return 1;
     }
     SetTraceLogLevel(LOG_NONE);
 
-    printf("#ifndef ASSET_PACKER_H_\n");
-    printf("#define ASSET_PACKER_H_\n");
-    printf("#include <raylib.h>\n");
-    printf("const unsigned char * load_data_from_path (const char * path, int * len) {\n");
-    for (size_t i = 1; i < argc; i++) {
+    bool mipmaps = false;
+    if (TextIsEqual(argv[1], "--mipmaps")) {
+        mipmaps = true;
+        argv ++;
+        argc --;
+    }
+
+    int code = 1;
+    usize file_count = 0;
+    ArchiveEntry * entries = NULL;
+    uint32_t * buckets = NULL;
+    char * atlas_folder = NULL;
+    char atlas_names[ATLAS_PAGES_MAX + 1][256];
+    PackedFile * files = MemAlloc(sizeof(PackedFile) * (argc - 2 + ATLAS_PAGES_MAX + 1));
+    ListUchar buffer = listUcharInit(1024 * 1024, perm_allocator());
+
+    for (int i = 2; i < argc; i++) {
+        if (TextIsEqual(argv[i], "--atlas") && i + 1 < argc) {
+            atlas_folder = argv[++ i];
+            for (char * c = atlas_folder; *c; c++) {
+                if (*c == '\\') *c = '/';
+            }
+            continue;
+        }
         int len = 0;
-        unsigned char * data = LoadFileData(argv[i], &len);
+        uchar * data = LoadFileData(argv[i], &len);
         if (len <= 0) {
             UnloadFileData(data);
             continue;
         }
-        printf("  if (TextIsEqual(path, \"%s\")) {\n", argv[i]);
-        printf("    static const unsigned char ret[%d] = { ", len+1);
-        for (size_t d = 0; d < len; d++) {
-            printf("%d, ", data[d]);
-        }
-        printf("0 };\n");
-        printf("    *len = %d;\n", len);
-        printf("    return ret;\n");
-        printf("  }\n");
-        UnloadFileData(data);
-    }
-    printf("  return (void*)0;\n}\n");
-
-    printf("FilePathList load_map_path_list () {\n");
-    FilePathList maps = LoadDirectoryFiles("assets/maps");
-    printf("  static char * maps[%d] = {\n", maps.count);
-    for (size_t i = 0; i < maps.count; i++) {
-        printf("    \"%s\",\n", maps.paths[i]);
-    }
-    printf("  };\n");
-    printf("  FilePathList ret = { .capacity = %d, .count = %d, .paths = maps };\n", maps.count, maps.count);
-    printf("  return ret;\n}\n");
-    UnloadDirectoryFiles(maps);
-
-    printf("FilePathList load_unit_meta_file_paths () {\n");
-    FilePathList units = LoadDirectoryFilesEx("assets/units", ".json", false);
-    printf("  static char * paths[%d] = {\n", units.count);
-    for (size_t i = 0; i < units.count; i++) {
-        printf("    \"%s\", \n", units.paths[i]);
-    }
-    printf("  };\n");
-    printf("  FilePathList ret = { .capacity = %d, .count = %d, .paths = paths };\n", units.count, units.count);
-    printf("  return ret;\n}\n");
-    UnloadDirectoryFiles(units);
-
-    printf("#endif // ASSET_PACKER_H_");
-    return 0;
+        // paths are stored with forward slashes so windows and linux builds find the same entries
+        char * path = argv[i];
+        for (char * c = path; *c; c++) {
+            if (*c == '\\') *c = '/';
+        }
+        bool duplicate = false;
+        for (usize f = 0; f < file_count; f++) {
+            if (TextIsEqual(files[f].path, path)) duplicate = true;
+        }
+        if (duplicate) {
+            UnloadFileData(data);
+            continue;
+        }
+        files[file_count] = (PackedFile){ .path = path, .data = data, .len = len, .atlased = atlas_folder != NULL };
+        if (files[file_count].atlased) {
+            if (decode_atlased(&files[file_count])) {
+                fprintf(stderr, "Failed to decode texture %s\n", path);
+                UnloadFileData(data);
+                goto done;
+            }
+            if (files[file_count].atlased) {
+                file_count ++;
+                continue;
+            }
+        }
+        if (convert_texture(&files[file_count], mipmaps)) {
+            fprintf(stderr, "Failed to decode texture %s\n", path);
+            listUcharDeinit(&files[file_count].converted);
+            UnloadFileData(data);
+            goto done;
+        }
+        if (compress_file(&files[file_count])) {
+            fprintf(stderr, "Failed to compress %s\n", path);
+            listUcharDeinit(&files[file_count].converted);
+            listUcharDeinit(&files[file_count].compressed);
+            UnloadFileData(data);
+            goto done;
+        }
+        file_count ++;
+    }
+
+    if (pack_atlas(files, &file_count, atlas_names, atlas_folder, mipmaps)) {
+        fprintf(stderr, "Failed to pack atlas into %s\n", atlas_folder);
+        goto done;
+    }
+    // atlased textures only live in the pages from here on
+    usize kept = 0;
+    for (usize f = 0; f < file_count; f++) {
+        if (files[f].atlased) {
+            UnloadImage(files[f].image);
+            UnloadFileData(files[f].data);
+        }
+        else {
+            files[kept ++] = files[f];
+        }
+    }
+    file_count = kept;
+
+    usize bucket_count = 1;
+    while (bucket_count < file_count * 2) bucket_count *= 2;
+
+    ArchiveHeader header = {
+        .magic        = ARCHIVE_MAGIC,
+        .version      = ARCHIVE_VERSION,
+        .entry_count  = file_count,
+        .bucket_count = bucket_count,
+    };
+    usize strings_start = sizeof(ArchiveHeader) + sizeof(ArchiveEntry) * file_count + sizeof(uint32_t) * bucket_count;
+    usize strings_size = 0;
+    for (usize f = 0; f < file_count; f++) {
+        strings_size += string_length(files[f].path) + 1;
+    }
+
+    entries = MemAlloc(sizeof(ArchiveEntry) * (file_count ? file_count : 1));
+    buckets = MemAlloc(sizeof(uint32_t) * bucket_count);
+    usize path_cursor = strings_start;
+    usize data_cursor = strings_start + strings_size;
+    for (usize f = 0; f < file_count; f++) {
+        ArchiveEntry * entry = &entries[f];
+        entry->hash = archive_hash_path(files[f].path);
+        entry->path_offset = path_cursor;
+        entry->path_length = string_length(files[f].path);
+        path_cursor += entry->path_length + 1;
+
+        data_cursor += (ARCHIVE_ALIGNMENT - data_cursor % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT;
+        entry->data_offset = data_cursor;
+        usize raw_size;
+        file_contents(&files[f], &raw_size);
+        entry->raw_size = raw_size;
+        if (files[f].compressed.len) {
+            entry->codec = ARCHIVE_CODEC_LZ;
+            entry->data_size = files[f].compressed.len;
+        }
+        else {
+            entry->codec = ARCHIVE_CODEC_NONE;
+            entry->data_size = raw_size;
+        }
+        // data is followed by zero so text assets can be used in place
+        data_cursor += entry->data_size + 1;
+
+        usize slot = entry->hash & (bucket_count - 1);
+        while (buckets[slot]) slot = (slot + 1) & (bucket_count - 1);
+        buckets[slot] = f + 1;
+    }
+
+    if (write_bytes(&buffer, &header, sizeof(ArchiveHeader))) goto done;
+    if (write_bytes(&buffer, entries, sizeof(ArchiveEntry) * file_count)) goto done;
+    if (write_bytes(&buffer, buckets, sizeof(uint32_t) * bucket_count)) goto done;
+    for (usize f = 0; f < file_count; f++) {
+        if (write_bytes(&buffer, files[f].path, entries[f].path_length + 1)) goto done;
+    }
+    for (usize f = 0; f < file_count; f++) {
+        if (write_padding(&buffer, ARCHIVE_ALIGNMENT)) goto done;
+        if (buffer.len != entries[f].data_offset) {
+            fprintf(stderr, "Archive layout is inconsistent at %s\n", files[f].path);
+            goto done;
+        }
+        uchar terminator = 0;
+        usize raw_size;
+        const uchar * data = file_contents(&files[f], &raw_size);
+        if (entries[f].codec == ARCHIVE_CODEC_LZ) data = files[f].compressed.items;
+        if (write_bytes(&buffer, data, entries[f].data_size)) goto done;
+        if (write_bytes(&buffer, &terminator, 1)) goto done;
+    }
+
+    if (SaveFileData(argv[1], buffer.items, buffer.len) == false) {
+        fprintf(stderr, "Failed to write %s\n", argv[1]);
+        goto done;
+    }
+    code = 0;
+
+    usize raw_total = 0;
+    usize stored_total = 0;
+    for (usize f = 0; f < file_count; f++) {
+        raw_total += entries[f].raw_size;
+        stored_total += entries[f].data_size;
+    }
+    printf("Packed %zu assets into %s, %zu bytes of data stored in %zu bytes, archive is %zu bytes\n",
+           file_count, argv[1], raw_total, stored_total, buffer.len);
+
+    done:
+    if (code) fprintf(stderr, "Failed to pack assets into %s\n", argv[1]);
+    for (usize f = 0; f < file_count; f++) {
+        if (files[f].atlased) UnloadImage(files[f].image);
+        UnloadFileData(files[f].data);
+        listUcharDeinit(&files[f].converted);
+        listUcharDeinit(&files[f].compressed);
+    }
+    MemFree(files);
+    MemFree(entries);
+    MemFree(buckets);
+    listUcharDeinit(&buffer);
+    return code;
 }
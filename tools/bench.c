@@ -0,0 +1,502 @@
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/types.h"
+#include "../src/alloc.h"
+#include "../src/std.h"
+#include "../src/constants.h"
+#include "../src/assets.h"
+#include "../src/level.h"
+#include "../src/mesh.h"
+#include "../src/game.h"
+#include "../src/particle.h"
+#include "../src/pathfinding.h"
+#include "../src/quality.h"
+#include "../src/unit_pool.h"
+#include "../src/random.h"
+
+#define JSMN_HEADER
+#define JSMN_PARENT_LINKS
+#include "../vendor/jsmn.h"
+
+#define HEAP_TYPE float
+#define HEAP_NAME Bench
+#define HEAP_DECLARATION
+#define HEAP_IMPLEMENTATION
+#include "../src/heap.h"
+
+#define BENCH_MAPS_FOLDER "assets/maps"
+#define BENCH_RESULTS_MAX 256
+// microbenchmarks are repeated and the fastest run is kept, it's the one least disturbed by the rest of the machine
+#define BENCH_RUNS 5
+#define BENCH_SEED 1337
+// matches that don't finish by then are cut short, ten minutes of game time
+#define BENCH_MATCH_TURNS (FPS * 60 * 10)
+#define BENCH_HEAP_ITEMS 4096
+#define BENCH_LIST_ITEMS 65536
+#define BENCH_PARTICLE_STEPS 240
+
+typedef struct {
+    char   name[64];
+    usize  ops;
+    double ns_per_op;
+    // slowest single operation, only tracked for matches
+    double worst_ns;
+} BenchResult;
+
+typedef struct {
+    BenchResult items[BENCH_RESULTS_MAX];
+    usize       len;
+} BenchResults;
+
+/// Runs the measured work once, returns seconds spent and how many operations that covered
+typedef double (*BenchFunction)(void * data, usize * ops);
+
+BenchResults results = {0};
+
+/* Measuring *****************************************************************/
+BenchResult * bench_record (const char * group, const char * name) {
+    if (results.len >= BENCH_RESULTS_MAX) {
+        fprintf(stderr, "Too many benchmarks, %s/%s is dropped\n", group, name);
+        return NULL;
+    }
+    BenchResult * result = &results.items[results.len ++];
+    clear_memory(result, sizeof(BenchResult));
+    snprintf(result->name, sizeof(result->name), "%s/%s", group, name);
+    return result;
+}
+void bench_measure (const char * group, const char * name, BenchFunction function, void * data) {
+    double best = 0.0;
+    usize ops = 0;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        usize run_ops = 0;
+        double time = function(data, &run_ops);
+        temp_reset();
+        if (run_ops == 0) return;
+        if (run == 0 || time < best) {
+            best = time;
+            ops = run_ops;
+        }
+    }
+    BenchResult * result = bench_record(group, name);
+    if (result == NULL) return;
+    result->ops = ops;
+    result->ns_per_op = best * 1000000000.0 / ops;
+    printf("%-32s %10zu ops %14.1f ns/op\n", result->name, result->ops, result->ns_per_op);
+}
+
+/* Microbenchmarks ***********************************************************/
+double bench_find_path (void * data, usize * ops) {
+    Map * map = data;
+    ListWayPoint path = listWayPointInit(64, perm_allocator());
+    double time = 0.0;
+    for (usize a = 0; a < map->regions.len; a++) {
+        WayPoint * start = map->regions.items[a].castle.waypoint;
+        if (start == NULL) continue;
+        for (usize b = 0; b < map->regions.len; b++) {
+            if (a == b) continue;
+            NavTarget target = {
+                .type = NAV_TARGET_REGION,
+                .region = &map->regions.items[b],
+            };
+            double begin = GetTime();
+            nav_find_path(start, target, &path);
+            time += GetTime() - begin;
+            temp_reset();
+            *ops += 1;
+        }
+    }
+    listWayPointDeinit(&path);
+    return time;
+}
+double bench_range_search (void * data, usize * ops) {
+    Map * map = data;
+    ListUnit found = listUnitInit(32, perm_allocator());
+    double begin = GetTime();
+    for (usize r = 0; r < map->regions.len; r++) {
+        NavGraph * graph = &map->regions.items[r].nav_graph;
+        for (usize w = 0; w < graph->waypoints.len; w++) {
+            if (graph->waypoints.items[w] == NULL) continue;
+            // friendly list searches can't stop early so they cover the whole range
+            NavRangeSearchContext context = {
+                .type = NAV_CONTEXT_FRIENDLY,
+                .amount = NAV_CONTEXT_LIST,
+                .player_id = map->regions.items[r].player_id,
+                .range = UNIT_MAX_RANGE,
+                .unit_list = &found,
+            };
+            found.len = 0;
+            nav_range_search(graph->waypoints.items[w], &context);
+            *ops += 1;
+        }
+    }
+    double time = GetTime() - begin;
+    listUnitDeinit(&found);
+    return time;
+}
+double bench_area_mesh (void * data, usize * ops) {
+    Map * map = data;
+    double time = 0.0;
+    for (usize r = 0; r < map->regions.len; r++) {
+        Model model;
+        double begin = GetTime();
+        if (generate_area_mesh(&map->regions.items[r].area, LAYER_MAP, &model)) continue;
+        time += GetTime() - begin;
+        UnloadModel(model);
+        *ops += 1;
+    }
+    return time;
+}
+double bench_nav_region (void * data, usize * ops) {
+    const Map * source = data;
+    Map map;
+    if (map_clone(&map, source)) return 0.0;
+    map_clamp(&map);
+    map_subdivide_paths(&map);
+
+    double time = 0.0;
+    if (nav_init_global_grid(&map) == SUCCESS) {
+        double begin = GetTime();
+        for (usize r = 0; r < map.regions.len; r++) {
+            if (nav_init_region(&map.regions.items[r])) break;
+            *ops += 1;
+        }
+        time = GetTime() - begin;
+    }
+    map_deinit(&map);
+    return time;
+}
+double bench_load_level (void * data, usize * ops) {
+    char * path = data;
+    Map map = {0};
+    double begin = GetTime();
+    Result result = load_level(&map, path);
+    double time = GetTime() - begin;
+    if (result) return 0.0;
+    if (map.name) MemFree(map.name);
+    map_deinit(&map);
+    *ops = 1;
+    return time;
+}
+int bench_heap_compare (float a, float b) {
+    return a > b ? 1 : -1;
+}
+int bench_heap_equal (float a, float b) {
+    return a == b;
+}
+double bench_heap (void * data, usize * ops) {
+    (void)data;
+    // same as in pathfinding, the heap lives in temporary memory and is dropped with it
+    HeapBench heap;
+    if (heapBenchInit(BENCH_HEAP_ITEMS, &heap, temp_allocator(), bench_heap_compare, bench_heap_equal)) return 0.0;
+    Random random;
+    random_seed(&random, BENCH_SEED, RANDOM_SIMULATION);
+
+    double begin = GetTime();
+    for (usize i = 0; i < BENCH_HEAP_ITEMS; i++) {
+        heapBenchAppend(&heap, random_range(&random, 0, 100000) * 0.01f);
+    }
+    // lowering a few costs the same way pathfinding revisits cheaper routes
+    for (usize i = 0; i < BENCH_HEAP_ITEMS / 8; i++) {
+        usize index = random_range(&random, 0, heap.len - 1);
+        heapBenchUpdate(&heap, index, heap.items[index] * 0.5f);
+    }
+    float item;
+    while (heap.len) {
+        heapBenchPop(&heap, &item);
+    }
+    double time = GetTime() - begin;
+
+    *ops = BENCH_HEAP_ITEMS * 2 + BENCH_HEAP_ITEMS / 8;
+    return time;
+}
+double bench_lists (void * data, usize * ops) {
+    (void)data;
+    // starting small so the growth is measured too
+    ListUsize list = listUsizeInit(8, perm_allocator());
+    if (list.items == NULL) return 0.0;
+
+    double begin = GetTime();
+    for (usize i = 0; i < BENCH_LIST_ITEMS; i++) {
+        listUsizeAppend(&list, i);
+    }
+    for (usize i = 0; i < BENCH_LIST_ITEMS / 64; i++) {
+        listUsizeRemove(&list, list.len / 2);
+    }
+    while (list.len) {
+        listUsizeRemove(&list, list.len - 1);
+    }
+    double time = GetTime() - begin;
+
+    listUsizeDeinit(&list);
+    *ops = BENCH_LIST_ITEMS * 2;
+    return time;
+}
+double bench_particles (void * data, usize * ops) {
+    (void)data;
+    GameState state = {0};
+    if (particles_init(&state.particles)) return 0.0;
+    quality_init(&state.quality);
+    state.camera.zoom = 1.0f;
+    random_seed(&state.random[RANDOM_PRESENTATION], BENCH_SEED, RANDOM_PRESENTATION);
+
+    Unit unit = { .type = UNIT_FIGHTER, .health = 0.0f };
+    Attack attack = { .attacker_faction = FACTION_MAGES, .origin_position = { 50.0f, 50.0f } };
+
+    double time = 0.0;
+    for (usize step = 0; step < BENCH_PARTICLE_STEPS; step++) {
+        // topped up outside of the measured part so every step moves a full system
+        usize count;
+        do {
+            count = state.particles.count;
+            particles_blood(&state, &unit, attack);
+        } while (count < state.particles.count);
+        *ops += state.particles.count;
+
+        double begin = GetTime();
+        particles_advance(&state, 1.0f / FPS);
+        particles_clean(&state);
+        time += GetTime() - begin;
+    }
+    particles_deinit(&state.particles);
+    return time;
+}
+
+/* Macrobenchmarks ***********************************************************/
+void bench_match (Map * prefab, Assets * assets, Settings * settings) {
+    GameState game = {0};
+    game.resources = assets;
+    game.settings = settings;
+    game.players = listPlayerDataInit(PLAYERS_MAX, perm_allocator());
+    clear_memory(game.players.items, sizeof(PlayerData) * game.players.cap);
+    game.players.items[0].type = PLAYER_NEUTRAL;
+    for (usize i = 1; i < game.players.cap; i++) {
+        game.players.items[i].type = PLAYER_AI;
+        game.players.items[i].faction = i % 2 ? FACTION_KNIGHTS : FACTION_MAGES;
+    }
+
+    game.seed = BENCH_SEED;
+    if (game_state_prepare(&game, prefab)) {
+        fprintf(stderr, "Failed to set up a match on %s\n", prefab->name);
+        listPlayerDataDeinit(&game.players);
+        return;
+    }
+
+    double total = 0.0;
+    double worst = 0.0;
+    usize turns = 0;
+    usize winner = 0;
+    while (turns < BENCH_MATCH_TURNS && winner == 0) {
+        double begin = GetTime();
+        game_step(&game, 1.0f / FPS);
+        double time = GetTime() - begin;
+        total += time;
+        if (time > worst) worst = time;
+        turns ++;
+        winner = game_winner(&game);
+        temp_reset();
+    }
+    game_state_deinit(&game);
+
+    BenchResult * result = bench_record("match", prefab->name);
+    if (result == NULL) return;
+    result->ops = turns;
+    result->ns_per_op = total * 1000000000.0 / turns;
+    result->worst_ns = worst * 1000000000.0;
+    printf("%-32s %10zu turns %12.1f ns/turn, worst %.1f ns, winner %zu\n", result->name, turns, result->ns_per_op, result->worst_ns, winner);
+}
+
+/* Results *******************************************************************/
+Result bench_write (const char * path) {
+    FILE * file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return FAILURE;
+    }
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (usize i = 0; i < results.len; i++) {
+        const BenchResult * result = &results.items[i];
+        fprintf(file, "    { \"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.3f, \"worst_ns\": %.3f }%s\n",
+            result->name, result->ops, result->ns_per_op, result->worst_ns, i + 1 < results.len ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return SUCCESS;
+}
+Result bench_read (const char * path, BenchResults * result) {
+    clear_memory(result, sizeof(BenchResults));
+    char * text = LoadFileText(path);
+    if (text == NULL) return FAILURE;
+
+    usize len = strlen(text);
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    int token_count = jsmn_parse(&parser, text, len, NULL, 0);
+    if (token_count <= 0) {
+        UnloadFileText(text);
+        return FAILURE;
+    }
+    jsmntok_t * tokens = MemAlloc(sizeof(jsmntok_t) * token_count);
+    jsmn_init(&parser);
+    jsmn_parse(&parser, text, len, tokens, token_count);
+
+    BenchResult * current = NULL;
+    for (int i = 0; i + 1 < token_count; i++) {
+        if (tokens[i].type == JSMN_OBJECT && tokens[i].parent > 0 && result->len < BENCH_RESULTS_MAX) {
+            current = &result->items[result->len ++];
+            continue;
+        }
+        if (current == NULL || tokens[i].type != JSMN_STRING || tokens[i].size != 1) continue;
+
+        const char * key = text + tokens[i].start;
+        int key_len = tokens[i].end - tokens[i].start;
+        const jsmntok_t * value = &tokens[i + 1];
+        int value_len = value->end - value->start;
+        if (key_len == 4 && strncmp(key, "name", 4) == 0) {
+            if (value_len >= (int)sizeof(current->name)) value_len = sizeof(current->name) - 1;
+            copy_memory(current->name, text + value->start, value_len);
+            current->name[value_len] = 0;
+        }
+        else if (key_len == 9 && strncmp(key, "ns_per_op", 9) == 0) {
+            current->ns_per_op = strtod(text + value->start, NULL);
+        }
+    }
+
+    MemFree(tokens);
+    UnloadFileText(text);
+    return SUCCESS;
+}
+int bench_compare (const char * baseline_path, const char * current_path, float threshold) {
+    static BenchResults baseline;
+    static BenchResults current;
+    if (bench_read(baseline_path, &baseline)) {
+        printf("No baseline at %s, record one with make bench-baseline\n", baseline_path);
+        return 0;
+    }
+    if (bench_read(current_path, &current)) {
+        fprintf(stderr, "Failed to read benchmark results from %s\n", current_path);
+        return 1;
+    }
+
+    usize regressions = 0;
+    for (usize i = 0; i < current.len; i++) {
+        const BenchResult * now = &current.items[i];
+        const BenchResult * then = NULL;
+        for (usize b = 0; b < baseline.len; b++) {
+            if (strcmp(baseline.items[b].name, now->name) == 0) {
+                then = &baseline.items[b];
+                break;
+            }
+        }
+        if (then == NULL || then->ns_per_op <= 0.0) {
+            printf("%-32s new\n", now->name);
+            continue;
+        }
+        float change = (now->ns_per_op / then->ns_per_op - 1.0) * 100.0;
+        const char * verdict = "";
+        if (change > threshold) {
+            verdict = "REGRESSION";
+            regressions ++;
+        }
+        else if (change < -threshold) {
+            verdict = "faster";
+        }
+        printf("%-32s %14.1f -> %14.1f ns/op %+7.1f%% %s\n", now->name, then->ns_per_op, now->ns_per_op, change, verdict);
+    }
+
+    if (regressions) {
+        printf("%zu benchmarks are more than %.1f%% slower than the baseline\n", regressions, threshold);
+        return 1;
+    }
+    printf("No regressions beyond %.1f%%\n", threshold);
+    return 0;
+}
+
+/* Running *******************************************************************/
+int bench_run (const char * output, const char * maps_folder) {
+    Assets assets = {0};
+    Settings settings = {0};
+    if (load_asset_archive()) {
+        fprintf(stderr, "Failed to open asset archive\n");
+        return 1;
+    }
+    if (load_animations(&assets)) {
+        fprintf(stderr, "Failed to load animations\n");
+        return 1;
+    }
+
+    bench_measure("heap", "float", bench_heap, NULL);
+    bench_measure("list", "usize", bench_lists, NULL);
+    bench_measure("particles_advance", "full", bench_particles, NULL);
+
+    FilePathList paths = LoadDirectoryFilesEx(maps_folder, ".json", false);
+    if (paths.count == 0) {
+        fprintf(stderr, "No maps found in %s\n", maps_folder);
+    }
+    for (usize i = 0; i < paths.count; i++) {
+        Map map = {0};
+        if (load_level(&map, paths.paths[i])) {
+            fprintf(stderr, "Failed to load map %s\n", paths.paths[i]);
+            continue;
+        }
+        map.loaded = true;
+        const char * name = map.name;
+
+        bench_measure("load_level", name, bench_load_level, paths.paths[i]);
+        bench_measure("nav_init_region", name, bench_nav_region, &map);
+
+        if (map_prepare_prefab(&assets, &map)) {
+            fprintf(stderr, "Failed to prepare map %s\n", name);
+            goto next;
+        }
+        bench_measure("generate_area_mesh", name, bench_area_mesh, &map);
+
+        Map instance;
+        if (map_instantiate(&instance, &map) == SUCCESS) {
+            bench_measure("nav_find_path", name, bench_find_path, &instance);
+            bench_measure("nav_range_search", name, bench_range_search, &instance);
+            map_deinit(&instance);
+        }
+
+        bench_match(&map, &assets, &settings);
+
+        next:
+        if (map.name) MemFree(map.name);
+        map_deinit(&map);
+        temp_reset();
+    }
+    UnloadDirectoryFiles(paths);
+
+    if (bench_write(output)) return 1;
+    printf("Results written to %s\n", output);
+    return 0;
+}
+
+int main (int argc, char ** argv) {
+    if (argc < 3 || (strcmp(argv[1], "run") != 0 && strcmp(argv[1], "compare") != 0)) {
+        fprintf(stderr, "Usage: %s run [Output Path] [Maps Folder]\n", argv[0]);
+        fprintf(stderr, "       %s compare [Baseline Path] [Results Path] [Threshold %%]\n", argv[0]);
+        fprintf(stderr, "  Benchmarks pathfinding, map setup, particles and AI matches on every map in the folder, %s by default\n", BENCH_MAPS_FOLDER);
+        return 1;
+    }
+    if (strcmp(argv[1], "compare") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Compare needs both the baseline and the results\n");
+            return 1;
+        }
+        float threshold = argc > 4 ? strtof(argv[4], NULL) : 10.0f;
+        return bench_compare(argv[2], argv[3], threshold);
+    }
+
+    // matches play without sounds loaded, missing sound warnings would bury the results
+    SetTraceLogLevel(LOG_ERROR);
+    // meshes and the map cache need a gl context, nothing is ever shown
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(320, 240, "Line Lancer Bench");
+    unit_pool_init();
+    int code = bench_run(argv[2], argc > 3 ? argv[3] : BENCH_MAPS_FOLDER);
+    unit_pool_deinit();
+    CloseWindow();
+    return code;
+}
@@ -0,0 +1,116 @@
+#include <raylib.h>
+#include <stdio.h>
+#include "../src/types.h"
+#include "../src/alloc.h"
+#include "../src/assets.h"
+#include "../src/level.h"
+#include "../src/map_file.h"
+#include "../src/pathfinding.h"
+
+// runs the same preparation the game does without touching the gpu, then checks what the game assumes
+Result validate_map (const Map * source) {
+    Result result = SUCCESS;
+    Map map;
+    if (map_clone(&map, source)) {
+        fprintf(stderr, "Failed to copy the map for validation\n");
+        return FAILURE;
+    }
+
+    if (source->name == NULL) {
+        fprintf(stderr, "Map is missing name property\n");
+        result = FAILURE;
+    }
+    if (source->player_count == 0) {
+        fprintf(stderr, "Map is missing player_count property\n");
+        result = FAILURE;
+    }
+    if (map.width == 0 || map.height == 0) {
+        fprintf(stderr, "Map has no size\n");
+        result = FAILURE;
+    }
+    if (result) goto done;
+
+    for (usize player = 1; player <= map.player_count; player++) {
+        usize owned = 0;
+        for (usize r = 0; r < map.regions.len; r++) {
+            if (map.regions.items[r].player_id == player) owned ++;
+        }
+        if (owned == 0) {
+            fprintf(stderr, "Player %zu doesn't start with any region\n", player);
+            result = FAILURE;
+        }
+    }
+    for (usize r = 0; r < map.regions.len; r++) {
+        const Region * region = &map.regions.items[r];
+        if (region->player_id > map.player_count) {
+            fprintf(stderr, "Region %zu belongs to player %zu but the map has only %u players\n", region->region_id, region->player_id, map.player_count);
+            result = FAILURE;
+        }
+        if (region->area.lines.len < 3) {
+            fprintf(stderr, "Region %zu has no outline\n", region->region_id);
+            result = FAILURE;
+        }
+    }
+    if (result) goto done;
+
+    map_clamp(&map);
+    map_subdivide_paths(&map);
+    if (map_make_connections(&map)) {
+        fprintf(stderr, "Map objects couldn't be connected, see the log above\n");
+        result = FAILURE;
+        goto done;
+    }
+    for (usize p = 0; p < map.paths.len; p++) {
+        const Path * path = &map.paths.items[p];
+        if (path->region_a == NULL || path->region_b == NULL) {
+            fprintf(stderr, "Path %zu doesn't connect two regions\n", path->path_id);
+            result = FAILURE;
+        }
+    }
+
+    done:
+    map_deinit(&map);
+    return result;
+}
+
+int main (int argc, char ** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s [Map Path] [Output Path]\n", argv[0]);
+        fprintf(stderr, "  Map compiler validates a Tiled json map and writes it in the binary format the game loads\n");
+        return 1;
+    }
+    const uint16_t endianness = 1;
+    if (*(const uchar *)&endianness != 1) {
+        fprintf(stderr, "Compiled maps are little endian, the compiler can't run on this machine\n");
+        return 1;
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    Map map = {0};
+    if (load_level(&map, argv[1])) {
+        fprintf(stderr, "Failed to load map %s\n", argv[1]);
+        return 1;
+    }
+    int code = 1;
+    ListUchar buffer = listUcharInit(4096, perm_allocator());
+
+    if (validate_map(&map)) {
+        fprintf(stderr, "Map %s is invalid\n", argv[1]);
+        goto done;
+    }
+    if (map_file_write(&map, &buffer)) {
+        fprintf(stderr, "Failed to serialize map %s\n", argv[1]);
+        goto done;
+    }
+    if (SaveFileData(argv[2], buffer.items, buffer.len) == false) {
+        fprintf(stderr, "Failed to write %s\n", argv[2]);
+        goto done;
+    }
+    code = 0;
+
+    done:
+    listUcharDeinit(&buffer);
+    if (map.name) MemFree(map.name);
+    map_deinit(&map);
+    return code;
+}
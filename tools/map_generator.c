@@ -0,0 +1,478 @@
+#include <raylib.h>
+#include <raymath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include "../src/types.h"
+#include "../src/alloc.h"
+#include "../src/std.h"
+#include "../src/constants.h"
+#include "../src/assets.h"
+#include "../src/level.h"
+
+#define GENERATOR_TILE 32
+// cell size used when the map size isn't given, in tiles, roughly what the shipped maps use
+#define GENERATOR_CELL_TILES 12
+// smallest cell that still fits a castle, buildings around it and water around the region
+#define GENERATOR_CELL_MIN (NAV_GRID_SIZE * 24)
+// how far seeds wander from the middle of their cell, kept low so neighbouring paths don't cross
+#define GENERATOR_JITTER 0.2f
+// regions are voronoi cells scaled towards their seed, the rest turns into water between them
+#define GENERATOR_REGION_SCALE 0.72f
+#define GENERATOR_POLYGON_MAX 32
+// how deep path ends reach into the regions they connect
+#define GENERATOR_PATH_INSET (NAV_GRID_SIZE * 2.0f)
+#define GENERATOR_BUILDING_SPACING (NAV_GRID_SIZE * 3.0f)
+
+typedef struct {
+    Vector2 points[GENERATOR_POLYGON_MAX];
+    usize   len;
+} Polygon;
+
+typedef struct {
+    Vector2 seed;
+    Polygon area;
+    usize   player_id;
+} GenRegion;
+
+typedef struct {
+    usize   a;
+    usize   b;
+    Vector2 start;
+    Vector2 end;
+} GenPath;
+
+typedef struct {
+    usize regions;
+    usize players;
+    usize buildings;
+    usize paths;
+    usize size;
+    usize seed;
+} GeneratorOptions;
+
+/* Random ********************************************************************/
+static uint64_t generator_state;
+
+uint64_t generator_random (void) {
+    // xorshift, the output has to stay the same on every platform for a given seed
+    generator_state ^= generator_state << 13;
+    generator_state ^= generator_state >> 7;
+    generator_state ^= generator_state << 17;
+    return generator_state;
+}
+float generator_random_float (float min, float max) {
+    return min + (float)(generator_random() % 100000) / 100000.0f * (max - min);
+}
+
+/* Geometry ******************************************************************/
+// keeps the part of the polygon on the side of the line the normal points away from
+void polygon_clip (Polygon * polygon, Vector2 origin, Vector2 normal) {
+    Polygon result = {0};
+    for (usize i = 0; i < polygon->len; i++) {
+        Vector2 a = polygon->points[i];
+        Vector2 b = polygon->points[(i + 1) % polygon->len];
+        float da = Vector2DotProduct(Vector2Subtract(a, origin), normal);
+        float db = Vector2DotProduct(Vector2Subtract(b, origin), normal);
+
+        if (da <= 0.0f && result.len < GENERATOR_POLYGON_MAX) {
+            result.points[result.len++] = a;
+        }
+        if ((da < 0.0f && db > 0.0f) || (da > 0.0f && db < 0.0f)) {
+            if (result.len < GENERATOR_POLYGON_MAX) {
+                result.points[result.len++] = Vector2Lerp(a, b, da / (da - db));
+            }
+        }
+    }
+    *polygon = result;
+}
+// distance along the ray to where it leaves a convex polygon the origin is inside of
+float polygon_exit (const Polygon * polygon, Vector2 origin, Vector2 direction) {
+    float exit = FLT_MAX;
+    for (usize i = 0; i < polygon->len; i++) {
+        Vector2 a = polygon->points[i];
+        Vector2 b = polygon->points[(i + 1) % polygon->len];
+        Vector2 edge = Vector2Subtract(b, a);
+        float denominator = direction.x * edge.y - direction.y * edge.x;
+        if (fabsf(denominator) < 0.0001f) continue;
+        Vector2 to_a = Vector2Subtract(a, origin);
+        float t = (to_a.x * edge.y - to_a.y * edge.x) / denominator;
+        float u = (to_a.x * direction.y - to_a.y * direction.x) / denominator;
+        if (t > 0.0f && u >= 0.0f && u <= 1.0f && t < exit) exit = t;
+    }
+    return exit;
+}
+float polygon_inner_radius (const Polygon * polygon, Vector2 point) {
+    float radius = FLT_MAX;
+    for (usize i = 0; i < polygon->len; i++) {
+        Vector2 a = polygon->points[i];
+        Vector2 b = polygon->points[(i + 1) % polygon->len];
+        Vector2 edge = Vector2Subtract(b, a);
+        float t = Vector2DotProduct(Vector2Subtract(point, a), edge) / Vector2LengthSqr(edge);
+        t = Clamp(t, 0.0f, 1.0f);
+        float distance = Vector2Distance(point, Vector2Add(a, Vector2Scale(edge, t)));
+        if (distance < radius) radius = distance;
+    }
+    return radius;
+}
+Test polygon_crosses_line (const Polygon * polygon, Vector2 a, Vector2 b) {
+    for (usize i = 0; i < polygon->len; i++) {
+        Vector2 c = polygon->points[i];
+        Vector2 d = polygon->points[(i + 1) % polygon->len];
+        if (CheckCollisionLines(a, b, c, d, NULL)) return YES;
+    }
+    return NO;
+}
+
+/* Layout ********************************************************************/
+Result generate_regions (GenRegion * regions, const GeneratorOptions * options, usize columns) {
+    float cell = (float)(options->size * GENERATOR_TILE) / columns;
+    float map_size = options->size * GENERATOR_TILE;
+
+    for (usize i = 0; i < options->regions; i++) {
+        Vector2 middle = { (i % columns + 0.5f) * cell, (i / columns + 0.5f) * cell };
+        regions[i].seed.x = middle.x + generator_random_float(-GENERATOR_JITTER, GENERATOR_JITTER) * cell;
+        regions[i].seed.y = middle.y + generator_random_float(-GENERATOR_JITTER, GENERATOR_JITTER) * cell;
+    }
+
+    for (usize i = 0; i < options->regions; i++) {
+        Polygon * area = &regions[i].area;
+        area->len = 4;
+        area->points[0] = (Vector2){ 0.0f, 0.0f };
+        area->points[1] = (Vector2){ map_size, 0.0f };
+        area->points[2] = (Vector2){ map_size, map_size };
+        area->points[3] = (Vector2){ 0.0f, map_size };
+
+        // seeds further than two cells away can't cut into the cell
+        for (usize o = 0; o < options->regions; o++) {
+            if (o == i) continue;
+            Vector2 other = regions[o].seed;
+            if (Vector2Distance(other, regions[i].seed) > cell * 2.5f) continue;
+            Vector2 middle = Vector2Lerp(regions[i].seed, other, 0.5f);
+            polygon_clip(area, middle, Vector2Subtract(other, regions[i].seed));
+        }
+        // clipping near corners leaves slivers of edges that the bevel can't round
+        usize kept = 0;
+        for (usize p = 0; p < area->len; p++) {
+            Vector2 point = Vector2Lerp(regions[i].seed, area->points[p], GENERATOR_REGION_SCALE);
+            if (kept > 0 && Vector2Distance(point, area->points[kept - 1]) < NAV_GRID_SIZE) continue;
+            area->points[kept++] = point;
+        }
+        if (kept > 1 && Vector2Distance(area->points[0], area->points[kept - 1]) < NAV_GRID_SIZE) kept --;
+        area->len = kept;
+        if (area->len < 3) {
+            fprintf(stderr, "Region %zu ended up without an area\n", i);
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+Result generate_buildings (const GenRegion * region, usize buildings, Vector2 * result) {
+    if (buildings == 0) return SUCCESS;
+    float radius = polygon_inner_radius(&region->area, region->seed) * 0.6f;
+    float spacing = buildings > 1 ? 2.0f * radius * sinf(PI / buildings) : radius;
+    if (radius < GENERATOR_BUILDING_SPACING || spacing < GENERATOR_BUILDING_SPACING) {
+        return FAILURE;
+    }
+    float angle = generator_random_float(0.0f, 2.0f * PI);
+    for (usize b = 0; b < buildings; b++) {
+        float a = angle + 2.0f * PI * b / buildings;
+        result[b] = Vector2Add(region->seed, (Vector2){ cosf(a) * radius, sinf(a) * radius });
+    }
+    return SUCCESS;
+}
+Test generate_path (const GenRegion * regions, usize count, usize a, usize b, GenPath * result) {
+    Vector2 from = regions[a].seed;
+    Vector2 to = regions[b].seed;
+    Vector2 direction = Vector2Normalize(Vector2Subtract(to, from));
+    float exit = polygon_exit(&regions[a].area, from, direction);
+    float entry = polygon_exit(&regions[b].area, to, Vector2Negate(direction));
+    if (exit == FLT_MAX || entry == FLT_MAX) return NO;
+
+    result->a = a;
+    result->b = b;
+    result->start = Vector2Add(from, Vector2Scale(direction, exit - GENERATOR_PATH_INSET));
+    result->end = Vector2Subtract(to, Vector2Scale(direction, entry - GENERATOR_PATH_INSET));
+
+    for (usize r = 0; r < count; r++) {
+        if (r == a || r == b) continue;
+        if (polygon_crosses_line(&regions[r].area, result->start, result->end)) return NO;
+    }
+    return YES;
+}
+Test path_crosses_paths (const GenPath * path, const GenPath * paths, usize count) {
+    for (usize p = 0; p < count; p++) {
+        if (CheckCollisionLines(path->start, path->end, paths[p].start, paths[p].end, NULL)) return YES;
+    }
+    return NO;
+}
+usize union_find (usize * parents, usize item) {
+    while (parents[item] != item) {
+        parents[item] = parents[parents[item]];
+        item = parents[item];
+    }
+    return item;
+}
+// connects grid neighbours, a random spanning tree first so every region is reachable, then extra paths up to the count
+Result generate_paths (const GenRegion * regions, const GeneratorOptions * options, usize columns, GenPath * result, usize * count) {
+    usize capacity = options->regions * 2;
+    GenPath * candidates = MemAlloc(sizeof(GenPath) * capacity);
+    usize * parents = MemAlloc(sizeof(usize) * options->regions);
+    bool * used = MemAlloc(sizeof(bool) * capacity);
+    usize candidate_count = 0;
+    Result status = FAILURE;
+    *count = 0;
+
+    for (usize i = 0; i < options->regions; i++) {
+        parents[i] = i;
+        usize right = i + 1;
+        usize down = i + columns;
+        if (right % columns != 0 && right < options->regions) {
+            if (generate_path(regions, options->regions, i, right, &candidates[candidate_count])) candidate_count ++;
+        }
+        if (down < options->regions) {
+            if (generate_path(regions, options->regions, i, down, &candidates[candidate_count])) candidate_count ++;
+        }
+    }
+    for (usize i = candidate_count; i > 1; i--) {
+        usize swap = generator_random() % i;
+        GenPath temp = candidates[i - 1];
+        candidates[i - 1] = candidates[swap];
+        candidates[swap] = temp;
+    }
+
+    for (usize i = 0; i < candidate_count; i++) {
+        usize a = union_find(parents, candidates[i].a);
+        usize b = union_find(parents, candidates[i].b);
+        if (a == b) continue;
+        if (path_crosses_paths(&candidates[i], result, *count)) continue;
+        used[i] = true;
+        parents[a] = b;
+        result[(*count)++] = candidates[i];
+    }
+    if (*count + 1 < options->regions) {
+        fprintf(stderr, "Only %zu of %zu regions could be connected, try another seed or a bigger map\n", *count + 1, options->regions);
+        goto done;
+    }
+    if (options->paths < *count) {
+        fprintf(stderr, "Connecting all regions takes %zu paths, using that instead of %zu\n", *count, options->paths);
+    }
+    for (usize i = 0; i < candidate_count && *count < options->paths; i++) {
+        if (used[i]) continue;
+        if (path_crosses_paths(&candidates[i], result, *count)) continue;
+        result[(*count)++] = candidates[i];
+    }
+    if (options->paths > *count) {
+        fprintf(stderr, "Only %zu paths fit between the regions, using that instead of %zu\n", *count, options->paths);
+    }
+    status = SUCCESS;
+
+    done:
+    MemFree(candidates);
+    MemFree(parents);
+    MemFree(used);
+    return status;
+}
+// the first player starts in a corner, every next one as far as possible from all the others
+void generate_players (GenRegion * regions, const GeneratorOptions * options) {
+    regions[0].player_id = 1;
+    for (usize player = 2; player <= options->players; player++) {
+        usize best = 0;
+        float best_distance = -1.0f;
+        for (usize r = 0; r < options->regions; r++) {
+            if (regions[r].player_id) continue;
+            float closest = FLT_MAX;
+            for (usize o = 0; o < options->regions; o++) {
+                if (regions[o].player_id == 0) continue;
+                float distance = Vector2Distance(regions[r].seed, regions[o].seed);
+                if (distance < closest) closest = distance;
+            }
+            if (closest > best_distance) {
+                best_distance = closest;
+                best = r;
+            }
+        }
+        regions[best].player_id = player;
+    }
+}
+
+/* Output ********************************************************************/
+void write_point (FILE * file, const char * type, usize id, Vector2 position, bool last) {
+    fprintf(file,
+        "        { \"id\":%zu, \"name\":\"\", \"type\":\"%s\", \"point\":true, \"rotation\":0, \"visible\":true, "
+        "\"width\":0, \"height\":0, \"x\":%.3f, \"y\":%.3f }%s\n",
+        id, type, position.x, position.y, last ? "" : ",");
+}
+Result write_map (const char * path, const GenRegion * regions, const GenPath * paths, usize path_count, const Vector2 * buildings, const GeneratorOptions * options) {
+    FILE * file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return FAILURE;
+    }
+    usize object_id = 1;
+    usize layer_id = 3;
+
+    fprintf(file, "{ \"compressionlevel\":-1, \"infinite\":false, \"orientation\":\"orthogonal\", \"renderorder\":\"right-down\",\n");
+    fprintf(file, "  \"tiledversion\":\"1.10.2\", \"version\":\"1.10\", \"type\":\"map\", \"tilesets\":[],\n");
+    fprintf(file, "  \"width\":%zu, \"height\":%zu, \"tilewidth\":%d, \"tileheight\":%d,\n", options->size, options->size, GENERATOR_TILE, GENERATOR_TILE);
+    fprintf(file, "  \"properties\":[\n");
+    fprintf(file, "    { \"name\":\"name\", \"type\":\"string\", \"value\":\"Stress %zu-%zu\" },\n", options->regions, options->seed);
+    fprintf(file, "    { \"name\":\"player_count\", \"type\":\"int\", \"value\":%zu }],\n", options->players);
+    fprintf(file, "  \"layers\":[\n");
+
+    fprintf(file, "  { \"id\":1, \"name\":\"Regions\", \"type\":\"group\", \"opacity\":1, \"visible\":true, \"x\":0, \"y\":0, \"layers\":[\n");
+    for (usize r = 0; r < options->regions; r++) {
+        const GenRegion * region = &regions[r];
+        fprintf(file, "    { \"id\":%zu, \"name\":\"%zu\", \"type\":\"objectgroup\", \"draworder\":\"topdown\", \"opacity\":1, \"visible\":true, \"x\":0, \"y\":0,\n", layer_id++, r + 1);
+        if (region->player_id) {
+            fprintf(file, "      \"properties\":[{ \"name\":\"player_id\", \"type\":\"int\", \"value\":%zu }],\n", region->player_id);
+        }
+        fprintf(file, "      \"objects\":[\n");
+        fprintf(file, "        { \"id\":%zu, \"name\":\"\", \"type\":\"region\", \"rotation\":0, \"visible\":true, \"width\":0, \"height\":0, \"x\":%.3f, \"y\":%.3f, \"polygon\":[",
+            object_id++, region->seed.x, region->seed.y);
+        for (usize p = 0; p < region->area.len; p++) {
+            Vector2 point = Vector2Subtract(region->area.points[p], region->seed);
+            fprintf(file, "{ \"x\":%.3f, \"y\":%.3f }%s", point.x, point.y, p + 1 < region->area.len ? ", " : "");
+        }
+        fprintf(file, "] },\n");
+        write_point(file, "guard", object_id++, region->seed, options->buildings == 0);
+        for (usize b = 0; b < options->buildings; b++) {
+            write_point(file, "node", object_id++, buildings[r * options->buildings + b], b + 1 == options->buildings);
+        }
+        fprintf(file, "      ] }%s\n", r + 1 < options->regions ? "," : "");
+    }
+    fprintf(file, "  ] },\n");
+
+    fprintf(file, "  { \"id\":2, \"name\":\"Paths\", \"type\":\"objectgroup\", \"draworder\":\"topdown\", \"opacity\":1, \"visible\":true, \"x\":0, \"y\":0, \"objects\":[\n");
+    for (usize p = 0; p < path_count; p++) {
+        Vector2 end = Vector2Subtract(paths[p].end, paths[p].start);
+        fprintf(file,
+            "    { \"id\":%zu, \"name\":\"\", \"type\":\"\", \"rotation\":0, \"visible\":true, \"width\":0, \"height\":0, \"x\":%.3f, \"y\":%.3f, "
+            "\"polyline\":[{ \"x\":0, \"y\":0 }, { \"x\":%.3f, \"y\":%.3f }] }%s\n",
+            object_id++, paths[p].start.x, paths[p].start.y, end.x, end.y, p + 1 < path_count ? "," : "");
+    }
+    fprintf(file, "  ] }],\n");
+    fprintf(file, "  \"nextlayerid\":%zu, \"nextobjectid\":%zu }\n", layer_id, object_id);
+
+    if (fclose(file)) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+// loads the written map back and prepares it the way the game does, anything the generator got wrong shows up here
+Result verify_map (const char * path) {
+    Map map = {0};
+    if (load_level(&map, (char *)path)) {
+        fprintf(stderr, "Failed to load generated map %s\n", path);
+        return FAILURE;
+    }
+    Result result = SUCCESS;
+    for (usize p = 0; p < map.paths.len; p++) {
+        for (usize o = p + 1; o < map.paths.len; o++) {
+            const ListLine * a = &map.paths.items[p].lines;
+            const ListLine * b = &map.paths.items[o].lines;
+            for (usize la = 0; la < a->len; la++) {
+                for (usize lb = 0; lb < b->len; lb++) {
+                    if (CheckCollisionLines(a->items[la].a, a->items[la].b, b->items[lb].a, b->items[lb].b, NULL)) {
+                        fprintf(stderr, "Paths %zu and %zu cross each other\n", p, o);
+                        result = FAILURE;
+                    }
+                }
+            }
+        }
+    }
+
+    Map copy;
+    if (result == SUCCESS) result = map_clone(&copy, &map);
+    if (result == SUCCESS) {
+        map_clamp(&copy);
+        map_subdivide_paths(&copy);
+        result = map_make_connections(&copy);
+        for (usize p = 0; result == SUCCESS && p < copy.paths.len; p++) {
+            if (copy.paths.items[p].region_a == NULL || copy.paths.items[p].region_b == NULL) {
+                fprintf(stderr, "Path %zu doesn't connect two regions\n", p);
+                result = FAILURE;
+            }
+        }
+        map_deinit(&copy);
+    }
+    if (map.name) MemFree(map.name);
+    map_deinit(&map);
+    return result;
+}
+
+usize read_option (int argc, char ** argv, int index, usize fallback) {
+    if (argc <= index) return fallback;
+    return strtoul(argv[index], NULL, 10);
+}
+
+int main (int argc, char ** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s [Output Path] [Regions] [Players] [Buildings] [Paths] [Size] [Seed]\n", argv[0]);
+        fprintf(stderr, "  Map generator lays out a Tiled json map of voronoi regions joined by paths for stress testing\n");
+        fprintf(stderr, "  Defaults to 16 regions, 2 players, 3 buildings per region, 1.5 paths per region and 1 as seed\n");
+        fprintf(stderr, "  Size is the width and height in tiles, without it the map grows with the number of regions\n");
+        return 1;
+    }
+    GeneratorOptions options = {
+        .regions   = read_option(argc, argv, 2, 16),
+        .players   = read_option(argc, argv, 3, 2),
+        .buildings = read_option(argc, argv, 4, 3),
+        .paths     = read_option(argc, argv, 5, 0),
+        .size      = read_option(argc, argv, 6, 0),
+        .seed      = read_option(argc, argv, 7, 1),
+    };
+    if (options.regions < 2) {
+        fprintf(stderr, "Map needs at least 2 regions\n");
+        return 1;
+    }
+    if (options.players == 0 || options.players >= PLAYERS_MAX || options.players > options.regions) {
+        fprintf(stderr, "Player count has to be between 1 and %d and not above the number of regions\n", PLAYERS_MAX - 1);
+        return 1;
+    }
+    if (options.paths == 0) options.paths = options.regions * 3 / 2;
+
+    usize columns = (usize)ceilf(sqrtf((float)options.regions));
+    if (options.size == 0) options.size = columns * GENERATOR_CELL_TILES;
+    if ((float)(options.size * GENERATOR_TILE) / columns < GENERATOR_CELL_MIN) {
+        fprintf(stderr, "Map of %zu tiles is too small for %zu regions, it needs at least %zu tiles\n",
+            options.size, options.regions, (usize)ceilf((float)GENERATOR_CELL_MIN * columns / GENERATOR_TILE));
+        return 1;
+    }
+    // xorshift state can't be zero
+    generator_state = (uint64_t)options.seed * 2654435761u + 1;
+    SetTraceLogLevel(LOG_WARNING);
+
+    int code = 1;
+    GenRegion * regions = MemAlloc(sizeof(GenRegion) * options.regions);
+    GenPath * paths = MemAlloc(sizeof(GenPath) * options.regions * 2);
+    Vector2 * buildings = MemAlloc(sizeof(Vector2) * (options.regions * options.buildings + 1));
+    usize path_count = 0;
+    clear_memory(regions, sizeof(GenRegion) * options.regions);
+
+    if (generate_regions(regions, &options, columns)) goto done;
+    for (usize r = 0; r < options.regions; r++) {
+        if (generate_buildings(&regions[r], options.buildings, &buildings[r * options.buildings])) {
+            fprintf(stderr, "Region %zu is too small for %zu buildings, try a bigger map\n", r, options.buildings);
+            goto done;
+        }
+    }
+    if (generate_paths(regions, &options, columns, paths, &path_count)) goto done;
+    generate_players(regions, &options);
+
+    if (write_map(argv[1], regions, paths, path_count, buildings, &options)) goto done;
+    if (verify_map(argv[1])) {
+        fprintf(stderr, "Generated map %s doesn't pass validation\n", argv[1]);
+        goto done;
+    }
+    printf("Generated %s with %zu regions and %zu paths on %zux%zu tiles\n", argv[1], options.regions, path_count, options.size, options.size);
+    code = 0;
+
+    done:
+    MemFree(regions);
+    MemFree(paths);
+    MemFree(buildings);
+    return code;
+}